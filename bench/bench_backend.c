@@ -0,0 +1,124 @@
+// 内存区域后端对比: 普通memalign、大页、预取、锁定对缺页次数与TLB缺失的影响
+// 用法: mempool_bench_backend [--mb=256] [--block=2048] [--accesses=4000000]
+#include "bench_common.h"
+#include <mempool.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+static volatile uint64_t bench_sink; // 防止随机访问被优化掉
+
+// 当前进程的次缺页计数
+static long bench_minor_faults(void)
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_minflt;
+}
+
+// 打开数据TLB读缺失计数器, 不支持时返回-1
+static int bench_dtlb_open(void)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void bench_run(const char *name, uint32_t flags, size_t block_size, size_t blocks, long accesses)
+{
+    long faults = bench_minor_faults();
+    uint64_t start = bench_now_ns();
+    mempool_t *pool = mempool_create_flags(block_size, blocks, flags);
+    uint64_t create_ns = bench_now_ns() - start;
+    long create_faults = bench_minor_faults() - faults;
+    if (!pool) {
+        printf("%-22s create failed\n", name);
+        return;
+    }
+
+    uint8_t **ptrs = malloc(sizeof(uint8_t *) * blocks);
+    size_t got = mempool_alloc_batch(pool, ptrs, blocks, false);
+    MEMPOOL_ASSERT(got == blocks);
+
+    // 首次写入每个块(数据路径上的首次访问)
+    faults = bench_minor_faults();
+    start = bench_now_ns();
+    for (size_t i = 0; i < blocks; i++) {
+        ptrs[i][0] = (uint8_t)i;
+    }
+    double touch_ns = (double)(bench_now_ns() - start) / (double)blocks;
+    long touch_faults = bench_minor_faults() - faults;
+
+    // 随机访问块(TLB压力)
+    int fd = bench_dtlb_open();
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    uint64_t x = 88172645463325252ull;
+    uint64_t sum = 0;
+    start = bench_now_ns();
+    for (long i = 0; i < accesses; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        sum += ptrs[x % blocks][block_size / 2];
+    }
+    double access_ns = (double)(bench_now_ns() - start) / (double)accesses;
+    bench_sink = sum;
+    long long tlb_misses = -1;
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &tlb_misses, sizeof(tlb_misses)) != sizeof(tlb_misses)) tlb_misses = -1;
+        close(fd);
+    }
+
+    char effective[64];
+    snprintf(effective, sizeof(effective), "%s%s%s%s",
+             (pool->area_flags & MEMPOOL_FLAG_HUGEPAGE) ? "hugetlb " : "",
+             (pool->area_flags & MEMPOOL_FLAG_THP) ? "thp " : "",
+             (pool->area_flags & MEMPOOL_FLAG_PREFAULT) ? "prefault " : "",
+             (pool->area_flags & MEMPOOL_FLAG_MLOCK) ? "mlock" : "");
+
+    printf("%-22s %10.1f %10ld %10ld %10.1f %10.1f ", name, (double)create_ns / 1e6,
+           create_faults, touch_faults, touch_ns, access_ns);
+    if (tlb_misses >= 0) {
+        printf("%12lld", tlb_misses);
+    } else {
+        printf("%12s", "n/a");
+    }
+    printf("  %s\n", effective);
+
+    mempool_free_batch(pool, ptrs, blocks);
+    free(ptrs);
+    mempool_destroy(pool);
+}
+
+int main(int argc, char **argv)
+{
+    size_t mb = (size_t)bench_arg_long(argc, argv, "--mb", 256);
+    size_t block_size = (size_t)bench_arg_long(argc, argv, "--block", 2048);
+    long accesses = bench_arg_long(argc, argv, "--accesses", 4000000);
+    size_t blocks = MEMPOOL_MIN(mb * 1024 * 1024 / block_size, (size_t)MEMPOOL_MAX_BLOCKS);
+
+    printf("pool: %zu blocks x %zu bytes\n", blocks, block_size);
+    printf("%-22s %10s %10s %10s %10s %10s %12s  %s\n", "backend", "create ms", "create pf",
+           "touch pf", "touch ns", "access ns", "dTLB miss", "effective");
+    bench_run("memalign", 0, block_size, blocks, accesses);
+    bench_run("mmap+prefault", MEMPOOL_FLAG_PREFAULT, block_size, blocks, accesses);
+    bench_run("thp", MEMPOOL_FLAG_THP, block_size, blocks, accesses);
+    bench_run("thp+prefault", MEMPOOL_FLAG_THP | MEMPOOL_FLAG_PREFAULT, block_size, blocks, accesses);
+    bench_run("hugetlb+prefault", MEMPOOL_FLAG_HUGEPAGE | MEMPOOL_FLAG_PREFAULT, block_size, blocks, accesses);
+    bench_run("hugetlb+prefault+mlock", MEMPOOL_FLAG_HUGEPAGE | MEMPOOL_FLAG_PREFAULT | MEMPOOL_FLAG_MLOCK,
+              block_size, blocks, accesses);
+    return 0;
+}
@@ -0,0 +1,102 @@
+// 位图查找内核对比: 不同填充率下各内核的首个空闲位、连续空闲区间与空闲计数耗时
+// 填充方式与分配器一致: 低地址的fill%位已分配, 其余空闲
+// 用法: mempool_bench_bitmap [--bits=65536] [--run=8] [--iters=20000]
+#include "bench_common.h"
+#include <mempool.h>
+#include <mempool_bitmap.h>
+
+static volatile size_t bench_sink; // 防止查找结果被优化掉
+
+// 按千分比填充: 前fill_permille/1000的位清0, 其余置1; last_only时只保留最后一位空闲
+static void bench_fill(BITMAP_TYPE *bitmap, size_t words, long fill_permille, int last_only)
+{
+    size_t nbits = words * MEMPOOL_BITMAP_EACH_NUM;
+    size_t used = last_only ? nbits - 1 : nbits * (size_t)fill_permille / 1000;
+
+    for (size_t w = 0; w < words; w++) {
+        bitmap[w] = 0;
+    }
+    for (size_t i = used; i < nbits; i++) {
+        bitmap[i / MEMPOOL_BITMAP_EACH_NUM] |= (BITMAP_TYPE)1 << (i % MEMPOOL_BITMAP_EACH_NUM);
+    }
+}
+
+static void bench_kernel(const BITMAP_TYPE *bitmap, size_t words, size_t run, long iters,
+                         double *first_ns, double *run_ns, double *pop_ns)
+{
+    size_t nbits = words * MEMPOOL_BITMAP_EACH_NUM;
+    size_t sink = 0;
+
+    uint64_t start = bench_now_ns();
+    for (long i = 0; i < iters; i++) {
+        sink += (size_t)mempool_bitmap_find_first(bitmap, words);
+    }
+    *first_ns = (double)(bench_now_ns() - start) / (double)iters;
+
+    start = bench_now_ns();
+    for (long i = 0; i < iters; i++) {
+        sink += (size_t)mempool_bitmap_find_run(bitmap, nbits, run);
+    }
+    *run_ns = (double)(bench_now_ns() - start) / (double)iters;
+
+    start = bench_now_ns();
+    for (long i = 0; i < iters; i++) {
+        sink += mempool_bitmap_popcount(bitmap, words);
+    }
+    *pop_ns = (double)(bench_now_ns() - start) / (double)iters;
+
+    bench_sink = sink;
+}
+
+int main(int argc, char **argv)
+{
+    size_t nbits = (size_t)bench_arg_long(argc, argv, "--bits", 65536);
+    size_t run = (size_t)bench_arg_long(argc, argv, "--run", 8);
+    long iters = bench_arg_long(argc, argv, "--iters", 20000);
+    size_t words = (nbits + MEMPOOL_BITMAP_EACH_NUM - 1) / MEMPOOL_BITMAP_EACH_NUM;
+
+    static const struct {
+        const char *name;
+        long fill_permille;
+        int last_only;
+    } fills[] = {
+        { "0%",     0,    0 },
+        { "50%",    500,  0 },
+        { "90%",    900,  0 },
+        { "99%",    990,  0 },
+        { "99.9%",  999,  0 },
+        { "last",   0,    1 },
+    };
+    static const mempool_bitmap_kernel_t kernels[] = {
+        MEMPOOL_BITMAP_KERNEL_SCALAR,
+        MEMPOOL_BITMAP_KERNEL_SSE2,
+        MEMPOOL_BITMAP_KERNEL_AVX2,
+    };
+
+    bench_pin_cpu(0);
+
+    BITMAP_TYPE *bitmap = aligned_alloc(64, (words * sizeof(BITMAP_TYPE) + 63) / 64 * 64);
+    if (!bitmap) {
+        return 1;
+    }
+
+    printf("bitmap kernels: %zu bits, run=%zu, %ld iterations (ns/op)\n", words * MEMPOOL_BITMAP_EACH_NUM, run, iters);
+    printf("%-8s %-8s %12s %12s %12s\n", "kernel", "fill", "find_first", "find_run", "popcount");
+
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (mempool_bitmap_set_kernel(kernels[k]) != 0) {
+            continue; // CPU不支持
+        }
+        for (size_t f = 0; f < sizeof(fills) / sizeof(fills[0]); f++) {
+            double first_ns, run_ns, pop_ns;
+            bench_fill(bitmap, words, fills[f].fill_permille, fills[f].last_only);
+            bench_kernel(bitmap, words, run, iters, &first_ns, &run_ns, &pop_ns);
+            printf("%-8s %-8s %12.1f %12.1f %12.1f\n",
+                   mempool_bitmap_kernel_name(), fills[f].name, first_ns, run_ns, pop_ns);
+        }
+    }
+
+    mempool_bitmap_set_kernel(MEMPOOL_BITMAP_KERNEL_AUTO);
+    free(bitmap);
+    return 0;
+}
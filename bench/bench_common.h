@@ -0,0 +1,74 @@
+#ifndef MEMPOOL_BENCH_COMMON_H
+#define MEMPOOL_BENCH_COMMON_H
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+// 单调时钟(纳秒)
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// 将当前线程绑定到指定CPU(按在线CPU数取模), 失败时忽略
+static inline void bench_pin_cpu(int cpu)
+{
+#ifdef __linux__
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpu <= 0) return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % ncpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+// 当前线程可运行的CPU数(受taskset/cgroup限制), 需在绑定CPU之前调用
+static inline int bench_cpu_count(void)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        return CPU_COUNT(&set);
+    }
+#endif
+    return 1;
+}
+
+// 读取命令行中的整数参数(--name=value), 不存在时返回默认值
+static inline long bench_arg_long(int argc, char **argv, const char *name, long def)
+{
+    size_t len = strlen(name);
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], name, len) == 0 && argv[i][len] == '=') {
+            return strtol(argv[i] + len + 1, NULL, 0);
+        }
+    }
+    return def;
+}
+
+// 读取命令行中的字符串参数(--name=value), 不存在时返回默认值
+static inline const char *bench_arg_str(int argc, char **argv, const char *name, const char *def)
+{
+    size_t len = strlen(name);
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], name, len) == 0 && argv[i][len] == '=') {
+            return argv[i] + len + 1;
+        }
+    }
+    return def;
+}
+
+#endif // MEMPOOL_BENCH_COMMON_H
@@ -0,0 +1,94 @@
+// 无锁分配、每线程缓存与互斥锁分配的线程扩展性对比
+// 用法: mempool_bench_lockfree [--threads=8] [--iters=200000] [--burst=4] [--magazine=16]
+#include "bench_common.h"
+#include <mempool.h>
+
+#define BENCH_BLOCK_SIZE    256
+#define BENCH_BLOCK_COUNT   4096
+
+typedef struct {
+    mempool_t *pool;
+    pthread_barrier_t *barrier;
+    int thread_id;
+    long iters;
+    int burst;
+    uint64_t ops;
+} bench_arg_t;
+
+static void *bench_thread(void *arg)
+{
+    bench_arg_t *a = (bench_arg_t *)arg;
+    uint8_t *held[64];
+
+    bench_pin_cpu(a->thread_id);
+    pthread_barrier_wait(a->barrier);
+
+    for (long i = 0; i < a->iters; i++) {
+        int n = 0;
+        for (int j = 0; j < a->burst; j++) {
+            if ((held[n] = mempool_alloc(a->pool, false)) != NULL) {
+                held[n++][0] = (uint8_t)j;
+            }
+        }
+        for (int j = 0; j < n; j++) {
+            mempool_free(a->pool, held[j]);
+        }
+        a->ops += (uint64_t)n * 2;
+    }
+    return NULL;
+}
+
+// 返回总吞吐(百万次操作/秒)
+static double bench_run(uint32_t flags, size_t magazine, int threads, long iters, int burst)
+{
+    mempool_t *pool = mempool_create_flags(BENCH_BLOCK_SIZE, BENCH_BLOCK_COUNT, flags);
+    MEMPOOL_ASSERT(pool != NULL);
+    if (magazine) {
+        MEMPOOL_ASSERT(mempool_magazine_enable(pool, magazine) == 0);
+    }
+
+    pthread_t tids[threads];
+    bench_arg_t args[threads];
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, threads + 1);
+
+    for (int i = 0; i < threads; i++) {
+        args[i] = (bench_arg_t){ .pool = pool, .barrier = &barrier, .thread_id = i,
+                                 .iters = iters, .burst = burst, .ops = 0 };
+        pthread_create(&tids[i], NULL, bench_thread, &args[i]);
+    }
+
+    pthread_barrier_wait(&barrier);
+    uint64_t start = bench_now_ns();
+    uint64_t ops = 0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+        ops += args[i].ops;
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+
+    pthread_barrier_destroy(&barrier);
+    MEMPOOL_ASSERT(mempool_available(pool) == BENCH_BLOCK_COUNT);
+    mempool_destroy(pool);
+
+    return (double)ops * 1e3 / (double)elapsed;
+}
+
+int main(int argc, char **argv)
+{
+    int max_threads = (int)bench_arg_long(argc, argv, "--threads", 8);
+    long iters = bench_arg_long(argc, argv, "--iters", 200000);
+    int burst = (int)bench_arg_long(argc, argv, "--burst", 4);
+    if (burst < 1 || burst > 64) burst = 4;
+
+    size_t magazine = (size_t)bench_arg_long(argc, argv, "--magazine", 16);
+
+    printf("%-8s %14s %16s %16s %8s\n", "threads", "mutex Mops/s", "lockfree Mops/s", "magazine Mops/s", "speedup");
+    for (int t = 1; t <= max_threads; t *= 2) {
+        double mutex = bench_run(0, 0, t, iters, burst);
+        double lockfree = bench_run(MEMPOOL_FLAG_LOCKFREE, 0, t, iters, burst);
+        double cached = bench_run(MEMPOOL_FLAG_LOCKFREE, magazine, t, iters, burst);
+        printf("%-8d %14.2f %16.2f %16.2f %7.2fx\n", t, mutex, lockfree, cached, lockfree / mutex);
+    }
+    return 0;
+}
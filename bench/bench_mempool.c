@@ -0,0 +1,381 @@
+// 综合性能测试: 单线程分配/释放耗时、多线程扩展曲线、生产者/消费者队列吞吐、批量大小扫描,
+// 分配相关项目与malloc/free对比; 结果以表格输出, 可同时输出JSON
+// 用法: mempool_bench [--suite=all|single|scaling|queue|batch] [--iters=1000000] [--threads=8]
+//                     [--messages=1000000] [--capacity=1024] [--json=FILE|-]
+#include "bench_common.h"
+#include <mempool.h>
+
+#define BENCH_BLOCK_SIZE    256
+#define BENCH_BLOCK_COUNT   4096
+#define BENCH_BURST         4       // 每轮先连续分配BENCH_BURST块再全部释放
+#define BENCH_MAX_BATCH     256
+#define BENCH_MAX_RESULTS   256
+
+// 经volatile函数指针调用, 避免编译器消除成对的malloc/free
+static void *(*volatile bench_malloc)(size_t) = malloc;
+static void (*volatile bench_libc_free)(void *) = free;
+
+typedef enum {
+    BENCH_MALLOC = 0,   // malloc/free
+    BENCH_MUTEX,        // 互斥锁池
+    BENCH_LOCKFREE,     // 无锁池
+    BENCH_MAGAZINE,     // 无锁池 + 每线程缓存
+    BENCH_FREELIST,     // 无锁池 + 空闲链表引擎
+    BENCH_KINDS,
+} bench_kind_t;
+
+static const char *const bench_kind_names[BENCH_KINDS] = { "malloc", "mutex", "lockfree", "magazine", "freelist" };
+
+typedef struct {
+    const char *suite;
+    char name[32];
+    int threads;
+    int batch;
+    double ns_per_op;       // 单个线程每次操作耗时
+    double mops;            // 总吞吐(百万次操作/秒)
+} bench_result_t;
+
+static FILE *bench_out;     // 表格输出
+static bench_result_t bench_results[BENCH_MAX_RESULTS];
+static size_t bench_result_count;
+
+static const bench_result_t *bench_record(const char *suite, const char *name, int threads, int batch,
+                                          uint64_t ops, uint64_t elapsed_ns)
+{
+    MEMPOOL_ASSERT(bench_result_count < BENCH_MAX_RESULTS);
+    bench_result_t *r = &bench_results[bench_result_count++];
+    r->suite = suite;
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->threads = threads;
+    r->batch = batch;
+    r->ns_per_op = ops ? (double)elapsed_ns * threads / (double)ops : 0;
+    r->mops = elapsed_ns ? (double)ops * 1e3 / (double)elapsed_ns : 0;
+    return r;
+}
+
+static mempool_t *bench_pool_create(bench_kind_t kind)
+{
+    if (kind == BENCH_MALLOC) {
+        return NULL;
+    }
+    uint32_t flags = kind == BENCH_MUTEX ? 0 : MEMPOOL_FLAG_LOCKFREE;
+    if (kind == BENCH_FREELIST) {
+        flags |= MEMPOOL_FLAG_FREELIST;
+    }
+    mempool_t *pool = mempool_create_flags(BENCH_BLOCK_SIZE, BENCH_BLOCK_COUNT, flags);
+    MEMPOOL_ASSERT(pool != NULL);
+    if (kind == BENCH_MAGAZINE) {
+        MEMPOOL_ASSERT(mempool_magazine_enable(pool, 32) == 0);
+    }
+    return pool;
+}
+
+static void bench_pool_destroy(mempool_t *pool)
+{
+    if (pool) {
+        MEMPOOL_ASSERT(mempool_available(pool) == BENCH_BLOCK_COUNT);
+        mempool_destroy(pool);
+    }
+}
+
+static inline uint8_t *bench_alloc(mempool_t *pool)
+{
+    return pool ? mempool_alloc(pool, false) : bench_malloc(BENCH_BLOCK_SIZE);
+}
+
+static inline void bench_free(mempool_t *pool, uint8_t *block)
+{
+    if (pool) {
+        mempool_free(pool, block);
+    } else {
+        bench_libc_free(block);
+    }
+}
+
+//===================================================================
+//  单线程与多线程分配/释放
+//===================================================================
+typedef struct {
+    mempool_t *pool;
+    pthread_barrier_t *barrier;
+    int thread_id;
+    long iters;
+    uint64_t ops;
+} bench_alloc_arg_t;
+
+static void *bench_alloc_thread(void *arg)
+{
+    bench_alloc_arg_t *a = (bench_alloc_arg_t *)arg;
+    uint8_t *held[BENCH_BURST];
+
+    bench_pin_cpu(a->thread_id);
+    pthread_barrier_wait(a->barrier);
+
+    for (long i = 0; i < a->iters; i++) {
+        int n = 0;
+        for (int j = 0; j < BENCH_BURST; j++) {
+            if ((held[n] = bench_alloc(a->pool)) != NULL) {
+                held[n++][0] = (uint8_t)j;
+            }
+        }
+        for (int j = 0; j < n; j++) {
+            bench_free(a->pool, held[j]);
+        }
+        a->ops += (uint64_t)n * 2;
+    }
+    return NULL;
+}
+
+static const bench_result_t *bench_alloc_run(const char *suite, bench_kind_t kind, int threads, long iters)
+{
+    mempool_t *pool = bench_pool_create(kind);
+    pthread_t tids[threads];
+    bench_alloc_arg_t args[threads];
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, threads + 1);
+
+    for (int i = 0; i < threads; i++) {
+        args[i] = (bench_alloc_arg_t){ .pool = pool, .barrier = &barrier, .thread_id = i, .iters = iters };
+        pthread_create(&tids[i], NULL, bench_alloc_thread, &args[i]);
+    }
+
+    pthread_barrier_wait(&barrier);
+    uint64_t start = bench_now_ns();
+    uint64_t ops = 0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+        ops += args[i].ops;
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+
+    pthread_barrier_destroy(&barrier);
+    bench_pool_destroy(pool);
+    return bench_record(suite, bench_kind_names[kind], threads, 1, ops, elapsed);
+}
+
+static void bench_single(long iters)
+{
+    fprintf(bench_out, "\n[single] alloc/free, 1 thread, burst %d\n", BENCH_BURST);
+    fprintf(bench_out, "%-10s %10s %10s\n", "allocator", "ns/op", "Mops/s");
+    for (int k = 0; k < BENCH_KINDS; k++) {
+        const bench_result_t *r = bench_alloc_run("single", (bench_kind_t)k, 1, iters);
+        fprintf(bench_out, "%-10s %10.2f %10.2f\n", r->name, r->ns_per_op, r->mops);
+    }
+}
+
+static void bench_scaling(int max_threads, long iters)
+{
+    fprintf(bench_out, "\n[scaling] alloc/free Mops/s, burst %d\n", BENCH_BURST);
+    fprintf(bench_out, "%-8s", "threads");
+    for (int k = 0; k < BENCH_KINDS; k++) {
+        fprintf(bench_out, " %10s", bench_kind_names[k]);
+    }
+    fprintf(bench_out, "\n");
+
+    for (int t = 1; t <= max_threads; t *= 2) {
+        fprintf(bench_out, "%-8d", t);
+        for (int k = 0; k < BENCH_KINDS; k++) {
+            fprintf(bench_out, " %10.2f", bench_alloc_run("scaling", (bench_kind_t)k, t, iters)->mops);
+        }
+        fprintf(bench_out, "\n");
+    }
+}
+
+//===================================================================
+//  生产者/消费者: 生产者从池分配块并入队, 消费者批量出队后释放
+//===================================================================
+typedef struct {
+    mempool_t *pool;
+    mempool_queue_t *queue;
+    long messages;
+    int batch;
+} bench_queue_arg_t;
+
+static void *bench_producer(void *arg)
+{
+    bench_queue_arg_t *a = (bench_queue_arg_t *)arg;
+
+    bench_pin_cpu(0);
+    for (long seq = 0; seq < a->messages; ) {
+        uint8_t *block = mempool_alloc(a->pool, false);
+        if (!block) {
+            sched_yield();
+            continue;
+        }
+        while (mempool_queue_enqueue_with_length(a->queue, block, (size_t)seq) != 0) {
+            sched_yield();
+        }
+        seq++;
+    }
+    return NULL;
+}
+
+static void *bench_consumer(void *arg)
+{
+    bench_queue_arg_t *a = (bench_queue_arg_t *)arg;
+    uint8_t *bufs[BENCH_MAX_BATCH];
+
+    bench_pin_cpu(1);
+    for (long seq = 0; seq < a->messages; ) {
+        size_t n = mempool_queue_dequeue_batch(a->queue, bufs, (size_t)a->batch);
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+        mempool_free_batch(a->pool, bufs, n);
+        seq += (long)n;
+    }
+    return NULL;
+}
+
+static void bench_queue(long messages, size_t capacity, int batch)
+{
+    static const struct {
+        const char *name;
+        uint32_t mode;
+    } modes[] = {
+        { "locked", MEMPOOL_QUEUE_LOCKED },
+        { "spsc", MEMPOOL_QUEUE_SPSC },
+        { "mpmc", MEMPOOL_QUEUE_MPMC },
+    };
+
+    fprintf(bench_out, "\n[queue] 1 producer (alloc+enqueue) / 1 consumer (dequeue+free), batch %d\n", batch);
+    fprintf(bench_out, "%-10s %10s %10s\n", "queue", "ns/msg", "Mmsg/s");
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        mempool_t *pool = mempool_create_flags(BENCH_BLOCK_SIZE, BENCH_BLOCK_COUNT, MEMPOOL_FLAG_LOCKFREE);
+        mempool_queue_t *queue = mempool_queue_create_mode(pool, capacity, modes[m].mode);
+        MEMPOOL_ASSERT(pool != NULL && queue != NULL);
+
+        bench_queue_arg_t arg = { .pool = pool, .queue = queue, .messages = messages, .batch = batch };
+        pthread_t producer, consumer;
+        uint64_t start = bench_now_ns();
+        pthread_create(&consumer, NULL, bench_consumer, &arg);
+        pthread_create(&producer, NULL, bench_producer, &arg);
+        pthread_join(producer, NULL);
+        pthread_join(consumer, NULL);
+        uint64_t elapsed = bench_now_ns() - start;
+
+        const bench_result_t *r = bench_record("queue", modes[m].name, 1, batch, (uint64_t)messages, elapsed);
+        fprintf(bench_out, "%-10s %10.2f %10.2f\n", r->name, r->ns_per_op, r->mops);
+
+        mempool_queue_destroy(queue);
+        bench_pool_destroy(pool);
+    }
+}
+
+//===================================================================
+//  批量大小扫描: 每次分配batch块再全部释放, 统计每块耗时
+//===================================================================
+static const bench_result_t *bench_batch_run(bench_kind_t kind, int batch, long blocks)
+{
+    mempool_t *pool = bench_pool_create(kind);
+    uint8_t *bufs[BENCH_MAX_BATCH];
+    long rounds = blocks / batch;
+    uint64_t ops = 0;
+
+    uint64_t start = bench_now_ns();
+    for (long i = 0; i < rounds; i++) {
+        size_t n;
+        if (pool) {
+            n = mempool_alloc_batch(pool, bufs, (size_t)batch, false);
+            mempool_free_batch(pool, bufs, n);
+        } else {
+            for (n = 0; n < (size_t)batch; n++) {
+                bufs[n] = bench_malloc(BENCH_BLOCK_SIZE);
+            }
+            for (size_t j = 0; j < n; j++) {
+                bench_libc_free(bufs[j]);
+            }
+        }
+        ops += n * 2;
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+
+    bench_pool_destroy(pool);
+    return bench_record("batch", bench_kind_names[kind], 1, batch, ops, elapsed);
+}
+
+static void bench_batch(long blocks)
+{
+    fprintf(bench_out, "\n[batch] alloc_batch/free_batch ns per block operation\n");
+    fprintf(bench_out, "%-8s", "batch");
+    for (int k = 0; k < BENCH_KINDS; k++) {
+        fprintf(bench_out, " %10s", bench_kind_names[k]);
+    }
+    fprintf(bench_out, "\n");
+
+    for (int batch = 1; batch <= BENCH_MAX_BATCH; batch *= 4) {
+        fprintf(bench_out, "%-8d", batch);
+        for (int k = 0; k < BENCH_KINDS; k++) {
+            fprintf(bench_out, " %10.2f", bench_batch_run((bench_kind_t)k, batch, blocks)->ns_per_op);
+        }
+        fprintf(bench_out, "\n");
+    }
+}
+
+//===================================================================
+//  JSON输出
+//===================================================================
+static int bench_write_json(const char *path)
+{
+    FILE *fp = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+
+    fprintf(fp, "{\n  \"benchmark\": \"mempool\",\n  \"block_size\": %d,\n  \"results\": [\n", BENCH_BLOCK_SIZE);
+    for (size_t i = 0; i < bench_result_count; i++) {
+        const bench_result_t *r = &bench_results[i];
+        fprintf(fp, "    {\"suite\": \"%s\", \"name\": \"%s\", \"threads\": %d, \"batch\": %d, "
+                    "\"ns_per_op\": %.3f, \"mops\": %.3f}%s\n",
+                r->suite, r->name, r->threads, r->batch, r->ns_per_op, r->mops,
+                i + 1 < bench_result_count ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+
+    if (fp != stdout) {
+        fclose(fp);
+    }
+    return 0;
+}
+
+static int bench_suite_enabled(const char *suite, const char *name)
+{
+    return strcmp(suite, "all") == 0 || strcmp(suite, name) == 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *suite = bench_arg_str(argc, argv, "--suite", "all");
+    const char *json = bench_arg_str(argc, argv, "--json", NULL);
+    long iters = bench_arg_long(argc, argv, "--iters", 1000000);
+    int max_threads = (int)bench_arg_long(argc, argv, "--threads", 8);
+    long messages = bench_arg_long(argc, argv, "--messages", 1000000);
+    size_t capacity = (size_t)bench_arg_long(argc, argv, "--capacity", 1024);
+    int batch = (int)bench_arg_long(argc, argv, "--batch", 32);
+    if (batch < 1 || batch > BENCH_MAX_BATCH) batch = 32;
+    if (max_threads < 1) max_threads = 1;
+
+    // JSON输出到标准输出时表格改为输出到标准错误
+    bench_out = (json && strcmp(json, "-") == 0) ? stderr : stdout;
+
+    if (bench_suite_enabled(suite, "single")) {
+        bench_single(iters);
+    }
+    if (bench_suite_enabled(suite, "scaling")) {
+        bench_scaling(max_threads, iters / 4);
+    }
+    if (bench_suite_enabled(suite, "queue")) {
+        bench_queue(messages, capacity, batch);
+    }
+    if (bench_suite_enabled(suite, "batch")) {
+        bench_batch(iters * BENCH_BURST);
+    }
+
+    if (bench_result_count == 0) {
+        fprintf(stderr, "unknown suite: %s\n", suite);
+        return 1;
+    }
+    return json ? -bench_write_json(json) : 0;
+}
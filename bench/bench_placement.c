@@ -0,0 +1,197 @@
+// 分配位置策略对比: first-fit / next-fit / LIFO 在典型分配/释放交错模式下的耗时、缓存缺失与估算查找距离
+//   steady   - 池保持约75%占用, 每步释放一个随机块再分配一个(生命周期随机)
+//   pipeline - 池保持约75%占用, 按FIFO顺序释放最早分配的块(收包环/流水线)
+//   scratch  - 约75%长期占用的背景上反复分配临时块, 使用后立即释放(请求内临时缓冲)
+// 每次分配后写满整个块, 模拟数据路径上的首次访问;
+// "est. dist"列不是实测的位图探测次数, 而是由返回块下标推算的从该策略查找起点到返回块之间的块数
+// (LIFO命中最近释放块时记为0); 位图按字扫描, 实际探测的字数远小于该值, 仅用于比较各策略的相对位置
+// 用法: mempool_bench_placement [--blocks=16384] [--block=256] [--ops=2000000] [--lockfree=1]
+#include "bench_common.h"
+#include <mempool.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+enum { WL_STEADY, WL_PIPELINE, WL_SCRATCH, WL_COUNT };
+static const char *wl_names[WL_COUNT] = { "steady", "pipeline", "scratch" };
+
+// 打开末级缓存缺失计数器, 不支持时返回-1
+static int bench_cache_miss_open(void)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static inline uint64_t bench_rand(uint64_t *x)
+{
+    *x ^= *x << 13;
+    *x ^= *x >> 7;
+    *x ^= *x << 17;
+    return *x;
+}
+
+struct placement_run {
+    mempool_t *pool;
+    uint32_t placement;
+    size_t cursor;          // next-fit查找起点(推算查找距离用)
+    size_t last_freed;      // 最近释放的块下标
+    uint64_t est_dist;      // 估算查找距离累计(块数)
+};
+
+static size_t run_index(struct placement_run *run, const uint8_t *ptr)
+{
+    return (size_t)(ptr - run->pool->memory_area) / run->pool->block_size;
+}
+
+static uint8_t *run_alloc(struct placement_run *run, size_t block_size)
+{
+    uint8_t *ptr = mempool_alloc(run->pool, false);
+    if (!ptr) {
+        return NULL;
+    }
+
+    size_t idx = run_index(run, ptr);
+    switch (run->placement) {
+    case MEMPOOL_PLACEMENT_NEXT_FIT:
+        run->est_dist += idx >= run->cursor ? idx - run->cursor : run->pool->block_count - run->cursor + idx;
+        run->cursor = idx + 1;
+        break;
+    case MEMPOOL_PLACEMENT_LIFO:
+        run->est_dist += idx == run->last_freed ? 0 : idx;
+        break;
+    default:
+        run->est_dist += idx;
+        break;
+    }
+
+    memset(ptr, (int)idx, block_size);
+    return ptr;
+}
+
+static void run_free(struct placement_run *run, uint8_t *ptr)
+{
+    run->last_freed = run_index(run, ptr);
+    mempool_free(run->pool, ptr);
+}
+
+static void bench_run(int workload, uint32_t placement, const char *name,
+                      size_t blocks, size_t block_size, long ops, uint32_t flags)
+{
+    mempool_t *pool = mempool_create_flags(block_size, blocks, flags);
+    if (!pool || mempool_set_placement(pool, placement) != 0) {
+        printf("%-10s %-10s create failed\n", wl_names[workload], name);
+        if (pool) mempool_destroy(pool);
+        return;
+    }
+
+    struct placement_run run = { pool, placement, 0, (size_t)-1, 0 };
+    size_t live_count = blocks * 3 / 4;
+    uint8_t **live = malloc(sizeof(uint8_t *) * live_count);
+    uint64_t x = 88172645463325252ull;
+
+    // 预热: 先占满再随机释放1/4, 使空闲块分散在整个池中
+    uint8_t **all = malloc(sizeof(uint8_t *) * blocks);
+    for (size_t i = 0; i < blocks; i++) {
+        all[i] = run_alloc(&run, block_size);
+    }
+    for (size_t i = blocks - 1; i > 0; i--) {
+        size_t j = bench_rand(&x) % (i + 1);
+        uint8_t *tmp = all[i];
+        all[i] = all[j];
+        all[j] = tmp;
+    }
+    for (size_t i = live_count; i < blocks; i++) {
+        run_free(&run, all[i]);
+    }
+    memcpy(live, all, sizeof(uint8_t *) * live_count);
+    free(all);
+    run.est_dist = 0;
+
+    int fd = bench_cache_miss_open();
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    size_t head = 0;
+    uint64_t start = bench_now_ns();
+    for (long i = 0; i < ops; i++) {
+        switch (workload) {
+        case WL_STEADY: {
+            size_t k = bench_rand(&x) % live_count;
+            run_free(&run, live[k]);
+            live[k] = run_alloc(&run, block_size);
+            break;
+        }
+        case WL_PIPELINE:
+            run_free(&run, live[head]);
+            live[head] = run_alloc(&run, block_size);
+            head = head + 1 == live_count ? 0 : head + 1;
+            break;
+        default: {
+            uint8_t *tmp = run_alloc(&run, block_size);
+            run_free(&run, tmp);
+            break;
+        }
+        }
+    }
+    double op_ns = (double)(bench_now_ns() - start) / (double)ops;
+
+    long long misses = -1;
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &misses, sizeof(misses)) != sizeof(misses)) misses = -1;
+        close(fd);
+    }
+
+    printf("%-10s %-10s %10.1f ", wl_names[workload], name, op_ns);
+    if (misses >= 0) {
+        printf("%14.2f", (double)misses / (double)ops);
+    } else {
+        printf("%14s", "n/a");
+    }
+    printf(" %12.1f\n", (double)run.est_dist / (double)ops);
+
+    for (size_t i = 0; i < live_count; i++) {
+        mempool_free(pool, live[i]);
+    }
+    free(live);
+    mempool_destroy(pool);
+}
+
+int main(int argc, char **argv)
+{
+    size_t blocks = (size_t)bench_arg_long(argc, argv, "--blocks", 16384);
+    size_t block_size = (size_t)bench_arg_long(argc, argv, "--block", 256);
+    long ops = bench_arg_long(argc, argv, "--ops", 2000000);
+    uint32_t flags = bench_arg_long(argc, argv, "--lockfree", 1) ? MEMPOOL_FLAG_LOCKFREE : 0;
+
+    static const struct {
+        const char *name;
+        uint32_t placement;
+    } policies[] = {
+        { "first-fit", MEMPOOL_PLACEMENT_FIRST_FIT },
+        { "next-fit",  MEMPOOL_PLACEMENT_NEXT_FIT },
+        { "lifo",      MEMPOOL_PLACEMENT_LIFO },
+    };
+
+    blocks = MEMPOOL_MIN(blocks, (size_t)MEMPOOL_MAX_BLOCKS);
+    bench_pin_cpu(0);
+
+    printf("pool: %zu blocks x %zu bytes, %ld ops, %s\n", blocks, block_size, ops,
+           flags ? "lockfree" : "locked");
+    printf("%-10s %-10s %10s %14s %12s\n", "workload", "placement", "ns/op", "cache miss/op", "est. dist");
+    for (int w = 0; w < WL_COUNT; w++) {
+        for (size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); p++) {
+            bench_run(w, policies[p].placement, policies[p].name, blocks, block_size, ops, flags);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+// 加锁队列、SPSC与MPMC无锁队列的吞吐与延迟对比(一个生产者线程, 一个消费者线程)
+// 用法: mempool_bench_queue [--messages=2000000] [--capacity=256] [--batch=32]
+#include "bench_common.h"
+#include <mempool.h>
+
+#define BENCH_BLOCK_SIZE    64
+#define BENCH_LAT_SAMPLE    64      // 每N条消息采样一次延迟
+
+typedef struct {
+    mempool_queue_t *queue;
+    uint8_t **blocks;
+    size_t block_num;
+    long messages;
+    long batch;
+    uint64_t *latency;      // 采样延迟(ns), 由消费者写入
+    size_t latency_count;
+} bench_arg_t;
+
+// 生产者: 数据长度字段携带发送时间戳
+static void *bench_producer(void *arg)
+{
+    bench_arg_t *a = (bench_arg_t *)arg;
+
+    bench_pin_cpu(0);
+    for (long seq = 0; seq < a->messages; ) {
+        if (mempool_queue_enqueue_with_length(a->queue, a->blocks[seq % a->block_num], bench_now_ns()) == 0) {
+            seq++;
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *bench_consumer(void *arg)
+{
+    bench_arg_t *a = (bench_arg_t *)arg;
+    uint8_t *bufs[a->batch];
+    size_t lens[a->batch];
+
+    bench_pin_cpu(1);
+    for (long seq = 0; seq < a->messages; ) {
+        size_t n = mempool_queue_dequeue_batch_with_length(a->queue, bufs, lens, a->batch);
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+        uint64_t now = bench_now_ns();
+        for (size_t i = 0; i < n; i++, seq++) {
+            if (seq % BENCH_LAT_SAMPLE == 0) {
+                a->latency[a->latency_count++] = now - lens[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void bench_run(const char *name, uint32_t mode, long messages, size_t capacity, long batch)
+{
+    // 块数为容量两倍, 生产者循环复用的块在再次入队前必然已被取出
+    mempool_t *pool = mempool_create(BENCH_BLOCK_SIZE, capacity * 2);
+    mempool_queue_t *queue = mempool_queue_create_mode(pool, capacity, mode);
+    MEMPOOL_ASSERT(pool != NULL && queue != NULL);
+
+    uint8_t *blocks[capacity * 2];
+    MEMPOOL_ASSERT(mempool_alloc_batch(pool, blocks, capacity * 2, false) == capacity * 2);
+
+    bench_arg_t arg = { .queue = queue, .blocks = blocks, .block_num = capacity * 2,
+                        .messages = messages, .batch = batch,
+                        .latency = malloc(sizeof(uint64_t) * (messages / BENCH_LAT_SAMPLE + 1)) };
+
+    pthread_t producer, consumer;
+    uint64_t start = bench_now_ns();
+    pthread_create(&consumer, NULL, bench_consumer, &arg);
+    pthread_create(&producer, NULL, bench_producer, &arg);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    uint64_t elapsed = bench_now_ns() - start;
+
+    qsort(arg.latency, arg.latency_count, sizeof(uint64_t), cmp_u64);
+    size_t n = arg.latency_count;
+    printf("%-8s %12.2f %10llu %10llu %10llu %12llu\n", name,
+           (double)messages * 1e3 / (double)elapsed,
+           (unsigned long long)arg.latency[n / 2],
+           (unsigned long long)arg.latency[n * 99 / 100],
+           (unsigned long long)arg.latency[n * 999 / 1000],
+           (unsigned long long)arg.latency[n - 1]);
+
+    free(arg.latency);
+    mempool_free_batch(pool, blocks, capacity * 2);
+    mempool_queue_destroy(queue);
+    mempool_destroy(pool);
+}
+
+int main(int argc, char **argv)
+{
+    long messages = bench_arg_long(argc, argv, "--messages", 2000000);
+    size_t capacity = (size_t)bench_arg_long(argc, argv, "--capacity", 256);
+    long batch = bench_arg_long(argc, argv, "--batch", 32);
+    if (batch < 1) batch = 1;
+
+    printf("%-8s %12s %10s %10s %10s %12s\n", "queue", "Mmsg/s", "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+    bench_run("locked", MEMPOOL_QUEUE_LOCKED, messages, capacity, batch);
+    bench_run("spsc", MEMPOOL_QUEUE_SPSC, messages, capacity, batch);
+    bench_run("mpmc", MEMPOOL_QUEUE_MPMC, messages, capacity, batch);
+    return 0;
+}
@@ -20,90 +20,306 @@
 
 // 配置宏
 #define MEMPOOL_ALIGNMENT       64      // 内存对齐要求
-#define MEMPOOL_MAX_BLOCKS      256     // 最大支持块数
+#ifndef MEMPOOL_MAX_BLOCKS
+#define MEMPOOL_MAX_BLOCKS      (1u << 20) // 最大支持块数(位图在创建时按实际块数分配)
+#endif
 #define MEMPOOL_MIN(a, b)       (((a) < (b)) ? (a) : (b))
 
+// 无锁分配模式编译期开关(0/1), 开启后mempool_create创建的池默认使用无锁路径
+#ifndef MEMPOOL_LOCKFREE_EN
+#define MEMPOOL_LOCKFREE_EN     0
+#endif
+
+// 统计计数编译期开关(0/1): 计数按线程分片, 读取时汇总, 关闭后热路径不产生任何统计开销
+#ifndef MEMPOOL_STATS_EN
+#define MEMPOOL_STATS_EN        1
+#endif
+#define MEMPOOL_STATS_SHARDS    16      // 统计分片数(2的幂), 线程按首次使用顺序轮流映射到分片
+#define MEMPOOL_STATS_BATCH     32      // 分片占用增量累计到该值时汇总到全局占用计数
+
+// 延迟直方图编译期开关(0/1), 见mempool_hist.h; 关闭时分配/释放/入队/出队路径不读取时钟
+#ifndef MEMPOOL_HISTOGRAM_EN
+#define MEMPOOL_HISTOGRAM_EN    0
+#endif
+
+// 空闲链表引擎(MEMPOOL_FLAG_FREELIST)的重复释放检查(0/1): 开启时额外维护空闲位图,
+// 每次分配/释放多一次原子位操作; 默认只在调试构建中开启
+#ifndef MEMPOOL_FREELIST_CHECK
+#ifdef MEMPOOL_DEBUG
+#define MEMPOOL_FREELIST_CHECK  1
+#else
+#define MEMPOOL_FREELIST_CHECK  0
+#endif
+#endif
+
+// 内存池创建标志(mempool_create_flags)
+#define MEMPOOL_FLAG_LOCKFREE   (1u << 0)   // 分配/释放通过CAS原子操作位图，不持有互斥锁
+#define MEMPOOL_FLAG_EXTERNAL_AREA (1u << 1) // 内存区域由调用者提供(mempool_create_with_area), 销毁时不释放
+#define MEMPOOL_FLAG_ELASTIC    (1u << 2)   // 弹性池(mempool_create_elastic), 空闲块耗尽时按slab扩展
+// 内存区域后端标志: 任一置位时内存区域改用mmap分配, 不可用时逐级回退,
+// 实际生效的标志记录在pool->area_flags中
+#define MEMPOOL_FLAG_HUGEPAGE   (1u << 3)   // 优先MAP_HUGETLB大页, 失败时回退到透明大页
+#define MEMPOOL_FLAG_THP        (1u << 4)   // 透明大页(madvise), 失败时回退到普通页
+#define MEMPOOL_FLAG_PREFAULT   (1u << 5)   // 创建时预先触碰所有页, 避免运行时缺页
+#define MEMPOOL_FLAG_MLOCK      (1u << 6)   // 锁定内存区域, 避免被换出
+#define MEMPOOL_FLAG_SHARED     (1u << 7)   // 跨进程共享池(mempool_create_shared), 强制无锁模式
+#define MEMPOOL_FLAG_REFCOUNT   (1u << 8)   // 每块引用计数(mempool_ref/mempool_unref), 最后一个引用释放时才归还块
+#define MEMPOOL_FLAG_FREELIST   (1u << 9)   // 空闲链表引擎: 分配/释放O(1)且与块数无关, 按LIFO顺序复用块;
+                                            // 最多2^21-1块, 不支持弹性/共享/引用计数池与连续块分配
+#define MEMPOOL_FLAG_AREA_MASK  (MEMPOOL_FLAG_HUGEPAGE | MEMPOOL_FLAG_THP | MEMPOOL_FLAG_PREFAULT | MEMPOOL_FLAG_MLOCK)
+// 只能由mempool_create_elastic/mempool_create_shared设置的标志, 传给mempool_create_flags/mempool_create_with_area时创建失败
+#define MEMPOOL_FLAG_INTERNAL_MASK (MEMPOOL_FLAG_ELASTIC | MEMPOOL_FLAG_SHARED)
+
+#if MEMPOOL_LOCKFREE_EN
+#define MEMPOOL_DEFAULT_FLAGS   MEMPOOL_FLAG_LOCKFREE
+#else
+#define MEMPOOL_DEFAULT_FLAGS   0
+#endif
+
 // 根据块数量自动选择最优位图类型
 #if MEMPOOL_MAX_BLOCKS <= 32
     #define BITMAP_TYPE uint32_t
-    #define BITMAP_WORDS 1
     #define LOG2_MEMPOOL_BITMAP_EACH_NUM 5  // log2(32)
-#elif MEMPOOL_MAX_BLOCKS <= 64
+#elif MEMPOOL_MAX_BLOCKS <= 0xFFFFFFFF
     #define BITMAP_TYPE uint64_t
-    #define BITMAP_WORDS 1
-    #define LOG2_MEMPOOL_BITMAP_EACH_NUM 6  // log2(64)
-#elif MEMPOOL_MAX_BLOCKS <= 128
-    #define BITMAP_TYPE uint64_t
-    #define BITMAP_WORDS 2
-    #define LOG2_MEMPOOL_BITMAP_EACH_NUM 6  // log2(64)
-#elif MEMPOOL_MAX_BLOCKS <= 256
-    #define BITMAP_TYPE uint64_t
-    #define BITMAP_WORDS 4
     #define LOG2_MEMPOOL_BITMAP_EACH_NUM 6  // log2(64)
 #else
     #error "MEMPOOL_MAX_BLOCKS exceeds maximum supported value"
 #endif
 
+// 根据块数量选择块索引类型(队列中保存的块索引)
+#if MEMPOOL_MAX_BLOCKS <= 0x10000
+    typedef uint16_t mempool_index_t;
+#else
+    typedef uint32_t mempool_index_t;
+#endif
+
 #define MEMPOOL_BITMAP_EACH_NUM (sizeof(BITMAP_TYPE) * 8) // 位图类型大小(比特数)
+#define MEMPOOL_BITMAP_WORDS(n) (((n) + MEMPOOL_BITMAP_EACH_NUM - 1) / MEMPOOL_BITMAP_EACH_NUM) // n位所需字数
+
+struct mempool_magazine;
+struct mempool_shared_hdr;
+
+// 阻塞等待状态(mempool_alloc_timed/mempool_queue_dequeue_timed): seq为futex字,
+// 释放/入队路径只在waiters非0时才递增seq并唤醒, 无等待者时不产生系统调用
+struct mempool_wait {
+    uint32_t seq;
+    uint32_t waiters;
+};
+#define MEMPOOL_WAIT_FOREVER    UINT64_MAX  // 无限等待
+
+// 统计分片: 每个分片独占缓存行, 同一分片上的线程以宽松原子操作累加
+struct mempool_stats_shard {
+    size_t allocs;
+    size_t frees;
+    size_t alloc_failures;
+    size_t hw_allocs;
+    size_t hw_frees;
+    size_t lock_contended;
+    long usage_delta;       // 尚未汇总到全局占用计数的增量
+} __attribute__((aligned(MEMPOOL_ALIGNMENT)));
+
+// 内存池统计快照(mempool_get_stats)
+typedef struct {
+    size_t allocs;          // 成功分配的块数
+    size_t frees;           // 释放的块数(引用计数池为最后一个引用释放的次数)
+    size_t alloc_failures;  // 失败的分配调用次数
+    size_t in_use;          // 当前被使用者持有的块数(不含线程缓存中的块)
+    size_t peak_in_use;     // 占用峰值(多线程时误差不超过每线程MEMPOOL_STATS_BATCH块)
+    size_t hw_owned;        // 当前硬件持有的块数
+    size_t lock_contended;  // 加锁时锁已被占用的次数(含与该池共用锁的队列)
+} mempool_stats_t;
+
+// 队列统计快照(mempool_queue_get_stats)
+typedef struct {
+    size_t depth;           // 当前深度
+    size_t peak_depth;      // 深度峰值
+    size_t enqueue_rejected;    // 被拒绝的入队次数(队列满/重复入队/非法块)
+} mempool_queue_stats_t;
+
+// 块句柄: 跨进程传递块时使用(各进程映射地址不同, 不能直接传递指针)
+typedef struct {
+    uint32_t pool_id;       // 所属共享池标识(0为无效句柄)
+    uint32_t block_index;   // 块索引
+} mempool_handle_t;
 
 typedef struct {
     uint8_t *memory_area;       // 内存区域基地址
     size_t block_size_unaligned;// 原始块大小(未对齐)
     size_t block_size;          // 每个块的大小(对齐后)
     size_t block_count;         // 实际块数量
+    uint32_t flags;             // 创建标志(MEMPOOL_FLAG_*)
+    uint32_t area_flags;        // 内存区域实际生效的后端标志(MEMPOOL_FLAG_AREA_MASK子集)
+    size_t area_size;           // mmap映射大小(0表示内存区域不是由内存池映射的)
+    uint32_t pool_id;           // 共享池标识(块句柄校验用, 非共享池为0)
+    struct mempool_shared_hdr *shared;  // 共享映射头部(非共享池为NULL)
+    struct mempool_wait *wait;          // 阻塞分配等待状态(共享池指向共享映射, 否则指向wait_local)
+    struct mempool_wait wait_local;
+
+    // 两级位图: 摘要位图第i位为1表示free_bitmap[i]中有空闲块,
+    // 查找空闲块时先查摘要再查叶子, 代价与块数量基本无关
+    size_t bitmap_words;            // 叶子位图字数
+    size_t summary_words;           // 摘要位图字数
+    BITMAP_TYPE *free_bitmap;       // 空闲块位图(叶子层)
+    BITMAP_TYPE *free_summary;      // 空闲块摘要位图
+    BITMAP_TYPE *hw_owned_bitmap;   // 硬件占用标记
+    uint32_t *refcount;             // 每块额外引用数(引用数-1, 空闲块为0), 未启用引用计数时为NULL
+
+    // 空闲链表引擎(MEMPOOL_FLAG_FREELIST): 链接存放在按块下标索引的旁路数组中, 不写入块内存
+    uint32_t *freelist_next;        // 每块的下一个空闲块下标+1(0为链表尾), 位图引擎为NULL
+    uint64_t freelist_head;         // 链表头: 首块下标+1、空闲块数与ABA标签(每次修改加1)
+
+    // 弹性扩展: 内存区域按最大容量预留地址空间, 按slab提交物理内存,
+    // 每个slab占用连续的整数个位图字, 块索引与指针换算与普通池一致
+    size_t slab_blocks;             // 每个slab的块数(非弹性池为0)
+    size_t slab_max;                // 最大slab数
+    size_t slab_min;                // 常驻slab数(收缩时保留)
+    size_t slab_committed;          // 当前已提交slab数
+    size_t slab_generation;         // slab变化计数(扩展时判断是否已被其他线程扩展)
+    uint8_t *slab_state;            // 每个slab是否已提交
+
+    struct mempool_stats_shard *stats;  // 统计分片(MEMPOOL_STATS_SHARDS个)
+    long stats_in_use;                  // 已汇总的占用块数
+    size_t stats_peak;                  // 占用峰值
 
-    BITMAP_TYPE free_bitmap[BITMAP_WORDS];     // 空闲块位图
-    BITMAP_TYPE hw_owned_bitmap[BITMAP_WORDS]; // 硬件占用标记
+    size_t magazine_size;                 // 每线程缓存容量(0表示未启用)
+    struct mempool_magazine *magazines;   // 所有线程缓存链表(销毁时回收)
+    MEMPOOL_TLS_KEY_TYPE magazine_key;    // 线程缓存TLS键
+    uint8_t *magazine_cached;             // 每块一字节, 非0表示块在某个线程缓存中(检测重复释放)
+
+    uint32_t placement;             // 单块分配位置策略(MEMPOOL_PLACEMENT_*)
+    size_t next_fit_cursor;         // 下次适配的起始块下标
+    uint32_t *lifo_hints;           // 最近释放块的提示环(块下标+1, 0为空槽), 仅LIFO策略分配
+    size_t lifo_top;                // 提示环累计写入次数
 
 #ifdef MEMPOOL_LOCK_INIT
     MEMPOOL_LOCK_TYPE lock;
 #endif
 } mempool_t;
 
+// 单块分配位置策略(mempool_set_placement)
+#define MEMPOOL_PLACEMENT_FIRST_FIT 0   // 总是取下标最小的空闲块(默认)
+#define MEMPOOL_PLACEMENT_NEXT_FIT  1   // 从上次分配位置之后继续查找, 到末尾后回绕
+#define MEMPOOL_PLACEMENT_LIFO      2   // 优先复用最近释放的块(缓存热), 没有可用的最近释放块时按first-fit
+
+// 队列模式(mempool_queue_create_mode)
+#define MEMPOOL_QUEUE_LOCKED    0   // 与内存池共用互斥锁(默认), 拒绝重复入队
+#define MEMPOOL_QUEUE_SPSC      1   // 单生产者/单消费者无锁环形队列, 不检查重复入队
+#define MEMPOOL_QUEUE_MPMC      2   // 多生产者/多消费者无锁环形队列(每槽位序号), 不检查重复入队
+
+struct mempool_ring;
+
 // 队列结构
 typedef struct mempool_queue {
-    struct mempool_queue *next;  // 用于构建优先级队列链表
+    struct mempool_queue *next;  // 用于构建优先级队列链表(mempool_prio.h, 按优先级从高到低)
+    uint32_t sched_weight;       // 优先级队列集合中的WRR权重(块数)/DRR额度(字节)
+    size_t sched_deficit;        // WRR本轮剩余块数/DRR剩余额度
     mempool_t *pool;
-    uint16_t *block_indices;
+    mempool_index_t *block_indices;
     size_t *data_lengths;
     size_t capacity;
     size_t head;
     size_t tail;
     size_t count;
-    BITMAP_TYPE queue_bitmap[BITMAP_WORDS];
+    BITMAP_TYPE *queue_bitmap;   // 已入队块位图(防止重复入队, 仅加锁模式)
+    uint32_t mode;               // 队列模式(MEMPOOL_QUEUE_*)
+    struct mempool_ring *ring;   // 无锁模式的头尾索引(加锁模式为NULL)
+    struct mempool_wait wait;    // 阻塞出队等待状态
+    bool wake_fence;             // 无锁模式且membarrier不可用: 入队侧以完整屏障代替非对称屏障
+    int event_fd;                // 就绪通知eventfd(未启用为-1)
+    uint32_t event_armed;        // 1: 下一次深度达到水位时写eventfd(写入前清0, 合并通知)
+    size_t event_watermark;      // 触发通知的队列深度
+    size_t stats_peak_depth;     // 深度峰值
+    size_t stats_rejected;       // 被拒绝的入队次数
 } mempool_queue_t;
 
 // 内存池基础API
 mempool_t *mempool_create(size_t data_size, size_t num_blocks);
+mempool_t *mempool_create_flags(size_t data_size, size_t num_blocks, uint32_t flags);
+mempool_t *mempool_create_with_area(uint8_t *area, size_t data_size, size_t num_blocks, uint32_t flags);
+// 弹性内存池: 初始提交initial_slabs个slab, 空闲块耗尽时自动扩展, 最多max_slabs个
+mempool_t *mempool_create_elastic(size_t data_size, size_t slab_blocks, size_t initial_slabs,
+                                  size_t max_slabs, uint32_t flags);
+size_t mempool_shrink(mempool_t *pool);     // 归还完全空闲的slab, 返回归还数量
+// 跨进程共享池: 共享头部、位图与内存区域位于同一共享映射中, 各进程持有自己的mempool_t视图;
+// name为NULL时使用匿名memfd(仅fork出的子进程可见), 销毁视图不删除名字, 需调用mempool_unlink_shared
+mempool_t *mempool_create_shared(const char *name, size_t data_size, size_t num_blocks);
+mempool_t *mempool_attach_shared(const char *name);
+int mempool_unlink_shared(const char *name);
+mempool_handle_t mempool_to_handle(mempool_t *pool, uint8_t *ptr);
+uint8_t *mempool_from_handle(mempool_t *pool, mempool_handle_t handle);
 void mempool_destroy(mempool_t *pool);
 
 uint8_t *mempool_alloc(mempool_t *pool, bool for_hw);
+// 阻塞分配: 池耗尽时等待释放, 超时返回NULL(timeout_ns为0等价于mempool_alloc);
+// 有等待者时mempool_free不经过线程缓存, 直接归还位图并唤醒; 已在线程缓存中的块在缓存溢出或被刷新前不会唤醒等待者
+uint8_t *mempool_alloc_timed(mempool_t *pool, bool for_hw, uint64_t timeout_ns);
 void mempool_free(mempool_t *pool, uint8_t *ptr);
 
+// 批量分配/释放: 一次加锁内按位图字整体取走/归还多个块(不经过线程缓存)
+size_t mempool_alloc_batch(mempool_t *pool, uint8_t **bufs, size_t n, bool for_hw);
+void mempool_free_batch(mempool_t *pool, uint8_t **bufs, size_t n);
+
+// 分配n个地址连续的块(如DMA描述符环), 返回首块地址, 无足够长的连续空闲区间时返回NULL;
+// 不经过线程缓存, 各块仍需分别释放
+uint8_t *mempool_alloc_contiguous(mempool_t *pool, size_t n, bool for_hw);
+
+// 引用计数(MEMPOOL_FLAG_REFCOUNT): 分配得到的块持有1个引用, 同一块可交给多个使用者(零拷贝扇出);
+// 启用后mempool_free/mempool_free_batch释放一个引用, 最后一个引用释放时块才归还位图
+int mempool_ref(mempool_t *pool, uint8_t *ptr);         // 增加一个引用, 非法或空闲块返回-1
+void mempool_unref(mempool_t *pool, uint8_t *ptr);      // 释放一个引用(同mempool_free)
+uint32_t mempool_refcount(mempool_t *pool, uint8_t *ptr);   // 当前引用数, 非法指针返回0
+
+// 每线程块缓存(magazine): 启用后普通分配/释放优先在本线程缓存中完成,
+// 缓存空/满时批量与位图交换; 线程退出时自动归还
+int mempool_magazine_enable(mempool_t *pool, size_t magazine_size);
+void mempool_magazine_flush(mempool_t *pool);
+
+// 单块分配位置策略(MEMPOOL_PLACEMENT_*), 需在多线程使用该池之前设置;
+// 批量分配与连续块分配始终按first-fit; 空闲链表引擎的池固定按LIFO复用, 设置时返回-1
+int mempool_set_placement(mempool_t *pool, uint32_t placement);
+
 size_t mempool_block_size(mempool_t *pool);
 size_t mempool_available(mempool_t *pool);
 size_t mempool_used(mempool_t *pool);
+size_t mempool_capacity(mempool_t *pool);   // 当前可用的总块数(弹性池为已提交slab的块数)
+
+// 统计快照: 只读取各分片计数, 不加锁, 不影响分配/释放路径; MEMPOOL_STATS_EN为0时返回-1
+// 统计分片位于每个进程自己的池视图中: 共享池的各项统计只反映本进程的操作, 全局空闲块数请用mempool_available
+int mempool_get_stats(mempool_t *pool, mempool_stats_t *stats);
+int mempool_queue_get_stats(mempool_queue_t *queue, mempool_queue_stats_t *stats);
 
 // 队列API
 mempool_queue_t *mempool_queue_create(mempool_t *pool, size_t capacity);
+mempool_queue_t *mempool_queue_create_mode(mempool_t *pool, size_t capacity, uint32_t mode);
 void mempool_queue_destroy(mempool_queue_t *queue);
 int mempool_queue_enqueue(mempool_queue_t *queue, uint8_t *buffer);
 uint8_t *mempool_queue_dequeue(mempool_queue_t *queue);
 // 新增内部函数声明(仅在.c文件中使用，不需要在.h中声明)
 // 新增公共接口
+// data_length随块原样传递, 含义由调用者定义(mempool_pkt在其中打包数据偏移与长度)
 int mempool_queue_enqueue_with_length(mempool_queue_t *queue, uint8_t *buffer, size_t data_length);
 uint8_t *mempool_queue_dequeue_with_length(mempool_queue_t *queue, size_t *data_length);
+// 阻塞出队: 队列为空时等待入队, 超时返回NULL
+uint8_t *mempool_queue_dequeue_timed(mempool_queue_t *queue, size_t *data_length, uint64_t timeout_ns);
 size_t mempool_queue_dequeue_batch_with_length(mempool_queue_t *queue, 
                                               uint8_t **buffers, 
                                               size_t *data_lengths,
                                               size_t max_count);
 
 uint8_t *mempool_queue_peek(mempool_queue_t *queue);
+uint8_t *mempool_queue_peek_with_length(mempool_queue_t *queue, size_t *data_length);
 size_t mempool_queue_dequeue_batch(mempool_queue_t *queue, uint8_t **buffers, size_t max_count);
 size_t mempool_queue_count(mempool_queue_t *queue);
 bool mempool_queue_is_empty(mempool_queue_t *queue);
 bool mempool_queue_is_full(mempool_queue_t *queue);
 
+// 就绪通知: 队列深度达到watermark(0按1处理, 即由空变为非空; 超过容量时按容量)时eventfd变为可读, 可与套接字一起加入epoll;
+// 通知是合并的, 每次布防后最多写一次eventfd. 返回eventfd(重复调用只更新水位), 失败返回-1
+int mempool_queue_event_enable(mempool_queue_t *queue, size_t watermark);
+// 消费者处理完一次就绪后调用: 清除可读状态并重新布防, 若深度仍达到水位则立即再次通知; 返回当前深度
+size_t mempool_queue_event_ack(mempool_queue_t *queue);
+
 
 
 
@@ -0,0 +1,31 @@
+#ifndef MEMPOOL_BITMAP_H
+#define MEMPOOL_BITMAP_H
+
+#include "mempool.h"
+
+//===================================================================
+//  位图查找内核: 首个置位、连续N个置位、整体置位计数
+//  x86上按CPU特性在运行时选择AVX2/SSE2实现, 其他平台(以及ThreadSanitizer构建)使用标量实现;
+//  标量实现逐字宽松原子读取, 可用于无锁模式下被并发修改的位图(结果为近似快照)
+//===================================================================
+
+typedef enum {
+    MEMPOOL_BITMAP_KERNEL_AUTO = 0,     // 按CPU特性自动选择
+    MEMPOOL_BITMAP_KERNEL_SCALAR,
+    MEMPOOL_BITMAP_KERNEL_SSE2,
+    MEMPOOL_BITMAP_KERNEL_AVX2,
+} mempool_bitmap_kernel_t;
+
+// 首个置位的位下标, 全0时返回-1
+long mempool_bitmap_find_first(const BITMAP_TYPE *bitmap, size_t words);
+// 前nbits位中第一段连续n个置位的起始位下标, 不存在(或n为0)时返回-1
+long mempool_bitmap_find_run(const BITMAP_TYPE *bitmap, size_t nbits, size_t n);
+// 置位总数
+size_t mempool_bitmap_popcount(const BITMAP_TYPE *bitmap, size_t words);
+
+// 指定内核(性能测试/测试用), CPU不支持时返回-1且不改变当前选择
+int mempool_bitmap_set_kernel(mempool_bitmap_kernel_t kernel);
+// 当前使用的内核名称
+const char *mempool_bitmap_kernel_name(void);
+
+#endif // MEMPOOL_BITMAP_H
@@ -0,0 +1,52 @@
+#ifndef MEMPOOL_CHAIN_H
+#define MEMPOOL_CHAIN_H
+
+#include "mempool.h"
+#include <sys/uio.h>
+
+//===================================================================
+//  分散/聚集缓冲链: 由多个内存池块组成的链表, 承载大于block_size的数据
+//  (巨帧、重组后的消息), 按需线性化或导出为iovec直接交给writev/sendmsg
+//===================================================================
+
+// 段描述符: 数据位于block + offset, 长度length
+typedef struct mempool_seg {
+    struct mempool_seg *next;
+    uint8_t *block;         // 内存池块起始地址
+    uint32_t offset;        // 数据在块内的偏移
+    uint32_t length;        // 数据长度
+} mempool_seg_t;
+
+// 缓冲链(由调用者持有, 可放在栈上)
+typedef struct {
+    mempool_t *pool;        // 数据块所在内存池
+    mempool_t *seg_pool;    // 段描述符内存池(块大小不小于sizeof(mempool_seg_t)), NULL时使用MEMPOOL_MALLOC
+    mempool_seg_t *head;
+    mempool_seg_t *tail;
+    size_t length;          // 总数据长度
+    size_t segs;            // 段数
+} mempool_chain_t;
+
+void mempool_chain_init(mempool_chain_t *chain, mempool_t *pool, mempool_t *seg_pool);
+void mempool_chain_free(mempool_chain_t *chain);    // 释放所有块, 链变为空
+
+// 追加/前插数据(拷贝), 优先使用尾段/首段块内的剩余空间; 内存不足时返回-1且链保持不变.
+// 与其他链共享的块(引用数大于1)不会被写入
+int mempool_chain_append(mempool_chain_t *chain, const uint8_t *data, size_t len);
+int mempool_chain_prepend(mempool_chain_t *chain, const uint8_t *data, size_t len);
+// 零拷贝追加一个已分配的块(所有权转移给链)
+int mempool_chain_append_block(mempool_chain_t *chain, uint8_t *block, size_t offset, size_t len);
+
+// 在at处拆分: [0, at)留在chain, [at, length)移入tail(tail被初始化).
+// 拆分点位于段中间时, 引用计数池共享该块, 否则拷贝后半段
+int mempool_chain_split(mempool_chain_t *chain, size_t at, mempool_chain_t *tail);
+
+// 按需线性化: 单段时直接返回数据地址, 多段且总长不超过块大小时合并为一个块,
+// 超过块大小时返回NULL(使用mempool_chain_copy_out拷贝到调用者缓冲区)
+uint8_t *mempool_chain_linearize(mempool_chain_t *chain);
+size_t mempool_chain_copy_out(mempool_chain_t *chain, size_t offset, uint8_t *dst, size_t len);
+
+// 导出为iovec, 返回段数; iov不足(或max_iov为负)时返回-1
+int mempool_chain_to_iovec(mempool_chain_t *chain, struct iovec *iov, int max_iov);
+
+#endif // MEMPOOL_CHAIN_H
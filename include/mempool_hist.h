@@ -0,0 +1,87 @@
+#ifndef MEMPOOL_HIST_H
+#define MEMPOOL_HIST_H
+
+#include "mempool.h"
+
+//===================================================================
+//  延迟直方图: 对数分桶, 每个2的幂区间再等分MEMPOOL_HIST_SUB_BUCKETS份(相对误差不超过1/16)
+//  每个线程独立计数, 记录路径不加锁也不做原子读改写; 查询时汇总所有线程
+//  计时单位为MEMPOOL_TICKS(), 查询结果换算为纳秒
+//  MEMPOOL_HISTOGRAM_EN为0时计时代码全部编译掉, 查询接口返回-1
+//===================================================================
+
+typedef enum {
+    MEMPOOL_HIST_ALLOC = 0,     // mempool_alloc
+    MEMPOOL_HIST_FREE,          // mempool_free
+    MEMPOOL_HIST_ENQUEUE,       // mempool_queue_enqueue_with_length
+    MEMPOOL_HIST_DEQUEUE,       // mempool_queue_dequeue_with_length / mempool_queue_dequeue_batch_with_length
+    MEMPOOL_HIST_OPS,
+} mempool_hist_op_t;
+
+#define MEMPOOL_HIST_SUB_BITS       4
+#define MEMPOOL_HIST_SUB_BUCKETS    (1u << MEMPOOL_HIST_SUB_BITS)
+#define MEMPOOL_HIST_BUCKETS        ((64 - MEMPOOL_HIST_SUB_BITS + 1) * MEMPOOL_HIST_SUB_BUCKETS)
+
+// 查询结果(纳秒), 百分位取所在桶的上界
+typedef struct {
+    uint64_t count;
+    uint64_t mean_ns;
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+} mempool_hist_summary_t;
+
+// 每线程计数, 只由所属线程写入; base为上次reset时的计数快照, 只在注册表锁内读写
+struct mempool_hist_thread {
+    struct mempool_hist_thread *next;
+    uint64_t counts[MEMPOOL_HIST_OPS][MEMPOOL_HIST_BUCKETS];
+    uint64_t sum[MEMPOOL_HIST_OPS];
+    uint64_t base_counts[MEMPOOL_HIST_OPS][MEMPOOL_HIST_BUCKETS];
+    uint64_t base_sum[MEMPOOL_HIST_OPS];
+};
+
+// 汇总指定操作的延迟分布, 未启用时返回-1
+int mempool_hist_summary(mempool_hist_op_t op, mempool_hist_summary_t *summary);
+// 指定百分位(0~100)的延迟, 无样本或未启用时返回-1
+int mempool_hist_percentile(mempool_hist_op_t op, double percentile, uint64_t *ns);
+// 打印所有操作的百分位表
+int mempool_hist_dump(FILE *fp);
+// 清零(记录快照, 之后的查询只统计此后的样本)
+int mempool_hist_reset(void);
+
+#if MEMPOOL_HISTOGRAM_EN
+extern MEMPOOL_THREAD_LOCAL struct mempool_hist_thread *mempool_hist_self;
+struct mempool_hist_thread *mempool_hist_register(void);
+
+static inline unsigned mempool_hist_bucket(uint64_t ticks)
+{
+    if (ticks < MEMPOOL_HIST_SUB_BUCKETS) {
+        return (unsigned)ticks;
+    }
+    unsigned shift = (unsigned)(63 - __builtin_clzll(ticks)) - MEMPOOL_HIST_SUB_BITS;
+    return MEMPOOL_HIST_SUB_BUCKETS * (shift + 1) + (unsigned)((ticks >> shift) & (MEMPOOL_HIST_SUB_BUCKETS - 1));
+}
+
+// 只有所属线程写入, 宽松原子写保证查询线程读到完整的值
+static inline void mempool_hist_record(mempool_hist_op_t op, uint64_t ticks)
+{
+    struct mempool_hist_thread *hist = mempool_hist_self;
+    if (!hist && !(hist = mempool_hist_register())) {
+        return;
+    }
+
+    uint64_t *count = &hist->counts[op][mempool_hist_bucket(ticks)];
+    MEMPOOL_ATOMIC_STORE_RELAXED(count, *count + 1);
+    MEMPOOL_ATOMIC_STORE_RELAXED(&hist->sum[op], hist->sum[op] + ticks);
+}
+
+#define MEMPOOL_HIST_BEGIN(start)       uint64_t start = MEMPOOL_TICKS()
+#define MEMPOOL_HIST_END(op, start)     mempool_hist_record((op), MEMPOOL_TICKS() - (start))
+#else
+#define MEMPOOL_HIST_BEGIN(start)
+#define MEMPOOL_HIST_END(op, start)
+#endif
+
+#endif // MEMPOOL_HIST_H
@@ -0,0 +1,61 @@
+#ifndef MEMPOOL_NUMA_H
+#define MEMPOOL_NUMA_H
+
+#include "mempool.h"
+
+//===================================================================
+//  NUMA感知内存池: 内存区域绑定到指定节点, 或每个节点一个子池并优先本地分配
+//===================================================================
+
+// 节点统计(按发起分配的线程所在节点计数)
+typedef struct {
+    size_t local_hits;      // 由本节点子池满足的分配
+    size_t remote_hits;     // 本节点耗尽后由其他节点满足的分配
+    size_t failures;        // 所有节点均耗尽
+} mempool_numa_stats_t;
+
+#define MEMPOOL_NUMA_STATS_SHARDS   8   // 每节点统计分片数(2的幂), 线程按首次使用顺序轮流映射到分片
+
+// 节点统计分片: 每个分片独占缓存行, 同一分片上的线程以宽松原子操作累加
+struct mempool_numa_shard {
+    size_t local_hits;
+    size_t remote_hits;
+    size_t failures;
+} __attribute__((aligned(MEMPOOL_ALIGNMENT)));
+
+// 每节点状态
+struct mempool_numa_node {
+    mempool_t *pool;        // 不存在的节点为NULL
+    bool bound;             // 内存区域是否成功绑定到该节点
+    uint8_t fallback[MEMPOOL_NUMA_MAX_NODES];   // 远端节点按距离从近到远排列
+    size_t fallback_count;
+    struct mempool_numa_shard stats[MEMPOOL_NUMA_STATS_SHARDS];
+};
+
+typedef struct {
+    size_t num_nodes;       // 最大节点号+1
+    struct mempool_numa_node nodes[MEMPOOL_NUMA_MAX_NODES];
+    int cpu_count;
+    uint8_t *cpu_to_node;   // CPU号 -> 节点号
+} mempool_numa_t;
+
+// 在指定节点上创建单个内存池(内存区域在创建时预取, 使物理页落在该节点)
+mempool_t *mempool_create_on_node(size_t data_size, size_t num_blocks, int node, uint32_t flags);
+
+// 每个节点创建一个子池
+mempool_numa_t *mempool_numa_create(size_t data_size, size_t blocks_per_node, uint32_t flags);
+void mempool_numa_destroy(mempool_numa_t *numa);
+
+// 优先从调用线程所在节点分配, 本地耗尽时按距离回退到远端节点
+uint8_t *mempool_numa_alloc(mempool_numa_t *numa, bool for_hw);
+uint8_t *mempool_numa_alloc_on(mempool_numa_t *numa, int node, bool for_hw);
+void mempool_numa_free(mempool_numa_t *numa, uint8_t *ptr);
+
+// 查询接口
+int mempool_numa_node_count(void);
+int mempool_numa_current_node(mempool_numa_t *numa);
+int mempool_numa_node_of(mempool_numa_t *numa, uint8_t *ptr);
+mempool_t *mempool_numa_pool(mempool_numa_t *numa, int node);
+int mempool_numa_get_stats(mempool_numa_t *numa, int node, mempool_numa_stats_t *stats);
+
+#endif // MEMPOOL_NUMA_H
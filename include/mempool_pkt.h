@@ -0,0 +1,92 @@
+#ifndef MEMPOOL_PKT_H
+#define MEMPOOL_PKT_H
+
+#include "mempool.h"
+
+//===================================================================
+//  报文缓冲视图: 在内存池块上预留头部空间, 协议层插入/剥离报头只移动偏移,
+//  不拷贝负载(类似skb/mbuf的push/pull/put/trim)
+//
+//      block          block+offset        +length             block+size
+//        |<- headroom ->|<----- data ----->|<---- tailroom ---->|
+//===================================================================
+
+#ifndef MEMPOOL_PKT_DEFAULT_HEADROOM
+#define MEMPOOL_PKT_DEFAULT_HEADROOM    128     // 默认头部预留(以太网+IP+传输层报头)
+#endif
+
+// 数据偏移与长度打包到队列的data_length中随块传递: 高半部分为偏移, 低半部分为长度
+#define MEMPOOL_PKT_SHIFT               (sizeof(size_t) * 4)
+#define MEMPOOL_PKT_PACK(offset, length) (((size_t)(offset) << MEMPOOL_PKT_SHIFT) | (size_t)(length))
+#define MEMPOOL_PKT_OFFSET(packed)      ((uint32_t)((packed) >> MEMPOOL_PKT_SHIFT))
+#define MEMPOOL_PKT_LENGTH(packed)      ((uint32_t)((packed) & (((size_t)1 << MEMPOOL_PKT_SHIFT) - 1)))
+
+typedef struct {
+    uint8_t *block;         // 内存池块起始地址
+    uint32_t offset;        // 数据起始偏移
+    uint32_t length;        // 数据长度
+    uint32_t size;          // 块大小
+} mempool_pkt_t;
+
+// 分配块并预留headroom字节头部空间(数据长度为0), 失败返回-1
+int mempool_pkt_alloc(mempool_t *pool, size_t headroom, mempool_pkt_t *pkt);
+// 在已有块上建立视图
+int mempool_pkt_attach(mempool_t *pool, uint8_t *block, size_t offset, size_t length, mempool_pkt_t *pkt);
+void mempool_pkt_free(mempool_t *pool, mempool_pkt_t *pkt);
+
+// 经队列传递时偏移与长度随块一起传递
+int mempool_pkt_enqueue(mempool_queue_t *queue, const mempool_pkt_t *pkt);
+int mempool_pkt_dequeue(mempool_queue_t *queue, mempool_pkt_t *pkt);   // 队列为空返回-1
+int mempool_pkt_dequeue_timed(mempool_queue_t *queue, mempool_pkt_t *pkt, uint64_t timeout_ns);
+
+static inline uint8_t *mempool_pkt_data(const mempool_pkt_t *pkt)
+{
+    return pkt->block + pkt->offset;
+}
+
+static inline size_t mempool_pkt_headroom(const mempool_pkt_t *pkt)
+{
+    return pkt->offset;
+}
+
+static inline size_t mempool_pkt_tailroom(const mempool_pkt_t *pkt)
+{
+    return pkt->size - pkt->offset - pkt->length;
+}
+
+// 在数据前插入len字节(报头), 返回新的数据起始地址; 头部空间不足返回NULL
+static inline uint8_t *mempool_pkt_push(mempool_pkt_t *pkt, size_t len)
+{
+    if (len > pkt->offset) return NULL;
+    pkt->offset -= (uint32_t)len;
+    pkt->length += (uint32_t)len;
+    return pkt->block + pkt->offset;
+}
+
+// 剥离数据前len字节(报头), 返回新的数据起始地址; 数据不足返回NULL
+static inline uint8_t *mempool_pkt_pull(mempool_pkt_t *pkt, size_t len)
+{
+    if (len > pkt->length) return NULL;
+    pkt->offset += (uint32_t)len;
+    pkt->length -= (uint32_t)len;
+    return pkt->block + pkt->offset;
+}
+
+// 在数据末尾追加len字节, 返回追加区域的起始地址; 尾部空间不足返回NULL
+static inline uint8_t *mempool_pkt_put(mempool_pkt_t *pkt, size_t len)
+{
+    if (len > mempool_pkt_tailroom(pkt)) return NULL;
+    uint8_t *tail = pkt->block + pkt->offset + pkt->length;
+    pkt->length += (uint32_t)len;
+    return tail;
+}
+
+// 将数据截断为len字节(len不小于当前长度时不变)
+static inline void mempool_pkt_trim(mempool_pkt_t *pkt, size_t len)
+{
+    if (len < pkt->length) {
+        pkt->length = (uint32_t)len;
+    }
+}
+
+#endif // MEMPOOL_PKT_H
@@ -13,6 +13,15 @@
 #include <assert.h>
 #include <stdio.h>
 #include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <linux/futex.h>
+#include <linux/membarrier.h>
+#include <sys/eventfd.h>
 
 //===================================================================
 // 树莓派实现
@@ -22,9 +31,118 @@ typedef pthread_mutex_t                     MEMPOOL_LOCK_TYPE;
 #define MEMPOOL_LOCK_INIT(lock)             pthread_mutex_init((lock), NULL)
 #define MEMPOOL_LOCK(lock)                  pthread_mutex_lock((lock))
 #define MEMPOOL_UNLOCK(lock)                pthread_mutex_unlock((lock))
+#define MEMPOOL_TRYLOCK(lock)               pthread_mutex_trylock((lock))  // 成功返回0(锁竞争统计使用)
+// 线程局部存储适配(每线程块缓存与统计分片使用)
+#define MEMPOOL_THREAD_LOCAL                __thread
+typedef pthread_key_t                       MEMPOOL_TLS_KEY_TYPE;
+#define MEMPOOL_TLS_KEY_CREATE(key, dtor)   pthread_key_create((key), (dtor))
+#define MEMPOOL_TLS_KEY_DELETE(key)         pthread_key_delete((key))
+#define MEMPOOL_TLS_GET(key)                pthread_getspecific((key))
+#define MEMPOOL_TLS_SET(key, val)           pthread_setspecific((key), (val))
 #define MEMPOOL_MALLOC(size)                malloc(size)
 #define MEMPOOL_FREE(ptr)                   free(ptr)
 #define MEMPOOL_MEMALIGN(alignment, size)   memalign(alignment, size)
+// 虚拟内存适配(弹性内存池使用): 预留地址空间, 按需提交/归还物理页, 成功返回0
+#define MEMPOOL_VM_RESERVE(size)                                                  \
+    ({                                                                            \
+        void *vm_addr = mmap(NULL, (size), PROT_NONE,                             \
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0); \
+        vm_addr == MAP_FAILED ? NULL : vm_addr;                                   \
+    })
+#define MEMPOOL_VM_COMMIT(addr, size)       mprotect((addr), (size), PROT_READ | PROT_WRITE)
+#define MEMPOOL_VM_DECOMMIT(addr, size)                                           \
+    (mmap((addr), (size), PROT_NONE,                                              \
+          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0) == MAP_FAILED ? -1 : 0)
+#define MEMPOOL_VM_RELEASE(addr, size)      munmap((addr), (size))
+#define MEMPOOL_VM_PAGE_SIZE()              ((size_t)sysconf(_SC_PAGESIZE))
+// 内存区域后端适配(mempool_create_flags的大页/预取/锁定标志使用)
+#define MEMPOOL_HUGEPAGE_SIZE               ((size_t)2 << 20)
+#define MEMPOOL_VM_MAP(size, huge)                                                \
+    ({                                                                            \
+        void *vm_addr = mmap(NULL, (size), PROT_READ | PROT_WRITE,                \
+                             MAP_PRIVATE | MAP_ANONYMOUS |                        \
+                             ((huge) ? MAP_HUGETLB : 0), -1, 0);                  \
+        vm_addr == MAP_FAILED ? NULL : vm_addr;                                   \
+    })
+#define MEMPOOL_VM_ADVISE_HUGE(addr, size)  madvise((addr), (size), MADV_HUGEPAGE)
+#define MEMPOOL_VM_LOCK(addr, size)         mlock((addr), (size))
+// 共享内存适配(跨进程共享池使用), 失败返回-1
+#define MEMPOOL_SHM_CREATE(name)            shm_open((name), O_RDWR | O_CREAT | O_EXCL, 0600)
+#define MEMPOOL_SHM_OPEN(name)              shm_open((name), O_RDWR, 0)
+#define MEMPOOL_SHM_ANON()                  ((int)syscall(SYS_memfd_create, "mempool", 0))
+#define MEMPOOL_SHM_UNLINK(name)            shm_unlink((name))
+#define MEMPOOL_SHM_RESIZE(fd, size)        ftruncate((fd), (off_t)(size))
+#define MEMPOOL_SHM_SIZE(fd)                ({ struct stat st; fstat((fd), &st) == 0 ? (size_t)st.st_size : 0; })
+#define MEMPOOL_SHM_CLOSE(fd)               close((fd))
+#define MEMPOOL_SHM_MAP(fd, size)                                                 \
+    ({                                                                            \
+        void *vm_addr = mmap(NULL, (size), PROT_READ | PROT_WRITE,                \
+                             MAP_SHARED, (fd), 0);                                \
+        vm_addr == MAP_FAILED ? NULL : vm_addr;                                   \
+    })
+// 进程号与墙上时间(共享池生成pool_id的种子)
+#define MEMPOOL_PROCESS_ID()                ((uint32_t)getpid())
+#define MEMPOOL_WALL_TIME()                 ((uint32_t)time(NULL))
+// futex适配(阻塞分配/出队使用), 使用非私有futex以支持跨进程共享池; timeout_ns为UINT64_MAX时无限等待
+#define MEMPOOL_FUTEX_WAIT(addr, val, timeout_ns)                                 \
+    ({                                                                            \
+        struct timespec fts = { .tv_sec = (time_t)((timeout_ns) / 1000000000ull), \
+                                .tv_nsec = (long)((timeout_ns) % 1000000000ull) };\
+        syscall(SYS_futex, (addr), FUTEX_WAIT, (val),                             \
+                (timeout_ns) == UINT64_MAX ? NULL : &fts, NULL, 0);               \
+    })
+#define MEMPOOL_FUTEX_WAKE_ALL(addr)        syscall(SYS_futex, (addr), FUTEX_WAKE, INT32_MAX, NULL, NULL, 0)
+// eventfd适配(队列就绪通知): 非阻塞, 写入累加计数使其可读, 读取清零
+#define MEMPOOL_EVENT_CREATE()              eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)
+#define MEMPOOL_EVENT_SIGNAL(fd)            ({ uint64_t ev = 1; (void)!write((fd), &ev, sizeof(ev)); })
+#define MEMPOOL_EVENT_CLEAR(fd)             ({ uint64_t ev; (void)!read((fd), &ev, sizeof(ev)); })
+#define MEMPOOL_EVENT_CLOSE(fd)             close((fd))
+// 非对称屏障: 慢路径在本进程所有运行中的线程上执行一次完整内存屏障, 快路径只需编译器屏障
+#define MEMPOOL_HEAVY_BARRIER_REGISTER()    syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0)
+#define MEMPOOL_HEAVY_BARRIER()             syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0)
+#define MEMPOOL_LIGHT_BARRIER()             __atomic_signal_fence(__ATOMIC_SEQ_CST)
+#define MEMPOOL_FULL_BARRIER()              __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define MEMPOOL_CURRENT_TIME_NS()                                                 \
+    ({                                                                            \
+        struct timespec ts;                                                       \
+        clock_gettime(CLOCK_MONOTONIC, &ts);                                      \
+        (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;               \
+    })
+// 延迟直方图计时: x86使用TSC(按MEMPOOL_CURRENT_TIME_NS校准为纳秒), 其他平台直接取纳秒
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define MEMPOOL_TICKS()                     __rdtsc()
+#define MEMPOOL_TICKS_ARE_NS                0
+#else
+#define MEMPOOL_TICKS()                     MEMPOOL_CURRENT_TIME_NS()
+#define MEMPOOL_TICKS_ARE_NS                1
+#endif
+// NUMA适配(mempool_numa使用): 拓扑来自sysfs, 内存策略通过系统调用设置,
+// 策略作用于调用线程此后触发的缺页
+#define MEMPOOL_NUMA_MAX_NODES              64
+#define MEMPOOL_NUMA_POLICY_BIND            2   // MPOL_BIND
+#define MEMPOOL_NUMA_GET_POLICY(mode, mask) \
+    syscall(SYS_get_mempolicy, (mode), (mask), MEMPOOL_NUMA_MAX_NODES + 1, NULL, 0)
+#define MEMPOOL_NUMA_SET_POLICY(mode, mask) \
+    syscall(SYS_set_mempolicy, (mode), (mask), MEMPOOL_NUMA_MAX_NODES + 1)
+#define MEMPOOL_NUMA_NODE_EXISTS(node)      mempool_port_sysfs_exists("/sys/devices/system/node/node%d", (node), 0)
+#define MEMPOOL_NUMA_CPU_ON_NODE(cpu, node) mempool_port_sysfs_exists("/sys/devices/system/node/node%d/cpu%d", (node), (cpu))
+#define MEMPOOL_NUMA_DISTANCE_FILE(node)    mempool_port_sysfs_open("/sys/devices/system/node/node%d/distance", (node))
+#define MEMPOOL_CPU_COUNT()                 ((int)sysconf(_SC_NPROCESSORS_CONF))
+#define MEMPOOL_CURRENT_CPU()               sched_getcpu()  // 需要_GNU_SOURCE
+// 原子操作适配(无锁模式使用, GCC/Clang内置函数)
+#define MEMPOOL_ATOMIC_LOAD(ptr)                    __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define MEMPOOL_ATOMIC_STORE(ptr, val)              __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#define MEMPOOL_ATOMIC_CAS(ptr, expected, desired)  \
+    __atomic_compare_exchange_n((ptr), (expected), (desired), true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define MEMPOOL_ATOMIC_FETCH_OR(ptr, val)           __atomic_fetch_or((ptr), (val), __ATOMIC_SEQ_CST)
+#define MEMPOOL_ATOMIC_FETCH_AND(ptr, val)          __atomic_fetch_and((ptr), (val), __ATOMIC_SEQ_CST)
+#define MEMPOOL_ATOMIC_FETCH_ADD(ptr, val)          __atomic_fetch_add((ptr), (val), __ATOMIC_SEQ_CST)
+// 宽松原子操作(不提供顺序保证): 统计计数, 以及只需避免数据竞争的读写
+#define MEMPOOL_ATOMIC_ADD_RELAXED(ptr, val)        __atomic_fetch_add((ptr), (val), __ATOMIC_RELAXED)
+#define MEMPOOL_ATOMIC_LOAD_RELAXED(ptr)            __atomic_load_n((ptr), __ATOMIC_RELAXED)
+#define MEMPOOL_ATOMIC_EXCHANGE_RELAXED(ptr, val)   __atomic_exchange_n((ptr), (val), __ATOMIC_RELAXED)
+#define MEMPOOL_ATOMIC_STORE_RELAXED(ptr, val)      __atomic_store_n((ptr), (val), __ATOMIC_RELAXED)
 // test需要的适配
 #define MEMPOOL_DELAY_MS(ms)                     \
     do                                           \
@@ -73,6 +191,19 @@ static inline const char* get_timestamp2() {
     return buffer;
 }
 
+// sysfs路径是否存在(路径格式最多两个整数参数)
+static inline int mempool_port_sysfs_exists(const char *fmt, int a, int b) {
+    char path[96];
+    snprintf(path, sizeof(path), fmt, a, b);
+    return access(path, F_OK) == 0;
+}
+
+static inline FILE *mempool_port_sysfs_open(const char *fmt, int a) {
+    char path[96];
+    snprintf(path, sizeof(path), fmt, a);
+    return fopen(path, "r");
+}
+
 
 #include <ctype.h>
 static void hex_dump(const unsigned char *data, size_t length) {
@@ -0,0 +1,51 @@
+#ifndef MEMPOOL_PRIO_H
+#define MEMPOOL_PRIO_H
+
+#include "mempool.h"
+
+//===================================================================
+//  多优先级队列集合: 每个流量类别一个mempool_queue_t, 经queue->next按优先级从高到低链接,
+//  出队时按调度规则在各类别间选择. 生产者直接向所属类别的队列入队;
+//  出队(调度)只能由一个线程进行(DRR需先查看队首长度再出队)
+//
+//      mempool_prio_t prio;
+//      mempool_prio_init(&prio, MEMPOOL_PRIO_DRR);
+//      mempool_prio_add(&prio, ctrl_queue, 1514);      // 类别0(最高)
+//      mempool_prio_add(&prio, bulk_queue, 1514);      // 类别1
+//      n = mempool_prio_dequeue_batch(&prio, burst, lens, 32);
+//===================================================================
+
+// 调度规则
+#define MEMPOOL_PRIO_STRICT     0   // 严格优先级: 高优先级类别为空时才服务低优先级类别
+#define MEMPOOL_PRIO_WRR        1   // 加权轮询: 每轮每个类别最多出队weight个块
+#define MEMPOOL_PRIO_DRR        2   // 差额轮询: 每轮每个类别增加weight字节额度, 按块的数据长度扣减
+
+// 队列集合(由调用者持有, 可放在栈上)
+typedef struct {
+    mempool_queue_t *head;      // 最高优先级类别
+    mempool_queue_t *tail;      // 最低优先级类别
+    mempool_queue_t *current;   // WRR/DRR当前轮到的类别
+    size_t current_cls;         // current的类别编号
+    size_t classes;             // 类别数
+    uint32_t discipline;        // 调度规则(MEMPOOL_PRIO_*)
+    bool in_turn;               // DRR: current本轮已增加额度
+    // DRR计费长度: 由队列中随块传递的data_length换算, NULL时直接使用data_length
+    // (mempool_pkt打包的偏移/长度可传入返回MEMPOOL_PKT_LENGTH的函数)
+    size_t (*cost)(size_t data_length);
+} mempool_prio_t;
+
+void mempool_prio_init(mempool_prio_t *prio, uint32_t discipline);
+// 追加一个类别(优先级低于已有类别), 返回类别编号; 队列已属于某个集合或WRR/DRR权重为0时返回-1
+int mempool_prio_add(mempool_prio_t *prio, mempool_queue_t *queue, uint32_t weight);
+// 从集合中移除所有类别(不销毁队列)
+void mempool_prio_clear(mempool_prio_t *prio);
+
+// 按调度规则出队一个块, cls返回所属类别编号(可为NULL); 所有类别为空时返回NULL
+uint8_t *mempool_prio_dequeue(mempool_prio_t *prio, size_t *data_length, size_t *cls);
+// 一次调用按调度规则跨类别填满一个突发, 返回出队数量(data_lengths可为NULL)
+size_t mempool_prio_dequeue_batch(mempool_prio_t *prio, uint8_t **buffers, size_t *data_lengths, size_t max_count);
+
+// 所有类别中的块数
+size_t mempool_prio_count(mempool_prio_t *prio);
+
+#endif // MEMPOOL_PRIO_H
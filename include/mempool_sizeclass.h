@@ -0,0 +1,70 @@
+#ifndef MEMPOOL_SIZECLASS_H
+#define MEMPOOL_SIZECLASS_H
+
+#include "mempool.h"
+
+//===================================================================
+//  多级块大小分配器: 由多个mempool_t组成, 按请求大小选择最小可容纳的级别
+//===================================================================
+
+// 配置宏
+#define MEMPOOL_SIZECLASS_MAX_CLASSES   32      // 最大级别数
+#ifndef MEMPOOL_SIZECLASS_CHUNK_SHIFT
+#define MEMPOOL_SIZECLASS_CHUNK_SHIFT   12      // 指针反查粒度(log2), 各级内存区域按此粒度对齐
+#endif
+#define MEMPOOL_SIZECLASS_STATS_SHARDS  8       // 每级统计分片数(2的幂), 线程按首次使用顺序轮流映射到分片
+
+// 级别配置
+typedef struct {
+    size_t size;            // 该级最大数据大小
+    size_t num_blocks;      // 该级块数量
+} mempool_sizeclass_config_t;
+
+// 级别统计(累计值, 用于评估内存浪费)
+typedef struct {
+    size_t block_size;      // 该级实际块大小(对齐后)
+    size_t block_count;     // 该级块数量
+    size_t allocs;          // 累计分配次数
+    size_t requested_bytes; // 累计请求字节数
+    size_t wasted_bytes;    // 累计浪费字节数(块大小 - 请求大小)
+} mempool_sizeclass_stats_t;
+
+// 级别统计分片: 每个分片独占缓存行, 同一分片上的线程以宽松原子操作累加
+struct mempool_sizeclass_shard {
+    size_t allocs;
+    size_t requested_bytes;
+} __attribute__((aligned(MEMPOOL_ALIGNMENT)));
+
+// 每级状态
+struct mempool_sizeclass_class {
+    mempool_t *pool;
+    struct mempool_sizeclass_shard stats[MEMPOOL_SIZECLASS_STATS_SHARDS];
+};
+
+typedef struct {
+    uint8_t *arena;             // 所有级别共用的内存区域
+    size_t arena_size;
+    size_t num_classes;
+    struct mempool_sizeclass_class classes[MEMPOOL_SIZECLASS_MAX_CLASSES];
+
+    // 大小 -> 级别: 下标为(size + MEMPOOL_ALIGNMENT - 1) / MEMPOOL_ALIGNMENT
+    uint8_t *size_to_class;
+    size_t max_size;            // 最大级别的块大小
+    // 指针 -> 级别: 下标为(ptr - arena) >> MEMPOOL_SIZECLASS_CHUNK_SHIFT
+    uint8_t *chunk_to_class;
+} mempool_sizeclass_t;
+
+mempool_sizeclass_t *mempool_sizeclass_create(const mempool_sizeclass_config_t *config, size_t num_classes, uint32_t flags);
+void mempool_sizeclass_destroy(mempool_sizeclass_t *sc);
+
+uint8_t *mempool_sizeclass_alloc(mempool_sizeclass_t *sc, size_t size);
+void mempool_sizeclass_free(mempool_sizeclass_t *sc, uint8_t *ptr);
+
+// 查询接口
+int mempool_sizeclass_class_of(mempool_sizeclass_t *sc, size_t size);  // 请求大小对应的级别, 无法容纳时返回-1
+mempool_t *mempool_sizeclass_pool_of(mempool_sizeclass_t *sc, uint8_t *ptr);
+mempool_t *mempool_sizeclass_pool(mempool_sizeclass_t *sc, size_t class_idx);
+size_t mempool_sizeclass_waste(mempool_sizeclass_t *sc, size_t size);  // 单次请求浪费的字节数, 无法容纳时返回SIZE_MAX
+int mempool_sizeclass_get_stats(mempool_sizeclass_t *sc, size_t class_idx, mempool_sizeclass_stats_t *stats);
+
+#endif // MEMPOOL_SIZECLASS_H
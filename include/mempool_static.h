@@ -0,0 +1,113 @@
+#ifndef MEMPOOL_STATIC_H
+#define MEMPOOL_STATIC_H
+
+#include "mempool.h"
+
+//===================================================================
+//  编译期定长内存池(仅头文件): 块大小与块数为编译期常量
+//  - 块大小向上取整为2的幂, 块索引与地址换算只需移位
+//  - 位图字数固定, 扫描循环可完全展开
+//  - 分配/释放通过CAS原子操作位图(同MEMPOOL_FLAG_LOCKFREE), 不需要锁, 也不需要创建/销毁
+//
+//  用法:
+//      MEMPOOL_STATIC_DEFINE(rx_pool, 2048, 512)   // 生成类型rx_pool_t与rx_pool_xxx函数
+//      static rx_pool_t rx;
+//      rx_pool_init(&rx);
+//      uint8_t *buf = rx_pool_alloc(&rx, true);
+//      rx_pool_free(&rx, buf);
+//===================================================================
+
+// 块大小向上取整到2的幂后的位移量(最小8字节)
+#define MEMPOOL_STATIC_SHIFT(size)      ((size) <= 8 ? 3 : 64 - __builtin_clzll((unsigned long long)(size) - 1))
+#define MEMPOOL_STATIC_WORDS(count)     (((count) + 63) / 64)
+
+#define MEMPOOL_STATIC_DEFINE(name, block_size, block_count)                                  \
+enum {                                                                                        \
+    name##_SHIFT = MEMPOOL_STATIC_SHIFT(block_size),                                          \
+    name##_BLOCK_SIZE = 1 << MEMPOOL_STATIC_SHIFT(block_size),                                \
+    name##_BLOCK_COUNT = (block_count),                                                       \
+    name##_WORDS = MEMPOOL_STATIC_WORDS(block_count),                                         \
+};                                                                                            \
+_Static_assert((block_count) > 0 && (block_count) <= MEMPOOL_MAX_BLOCKS,                      \
+               #name ": invalid block count");                                                \
+                                                                                              \
+typedef struct {                                                                              \
+    uint8_t area[(size_t)(block_count) << MEMPOOL_STATIC_SHIFT(block_size)]                   \
+        __attribute__((aligned(MEMPOOL_ALIGNMENT)));                                          \
+    uint64_t free_bitmap[MEMPOOL_STATIC_WORDS(block_count)];      /* 1表示空闲 */               \
+    uint64_t hw_owned_bitmap[MEMPOOL_STATIC_WORDS(block_count)];  /* 1表示硬件持有 */           \
+} name##_t;                                                                                   \
+                                                                                              \
+static inline void name##_init(name##_t *pool)                                                \
+{                                                                                             \
+    for (size_t w = 0; w < name##_WORDS; w++) {                                               \
+        pool->free_bitmap[w] = ~0ull;                                                         \
+        pool->hw_owned_bitmap[w] = 0;                                                         \
+    }                                                                                         \
+    if ((block_count) % 64) {                                                                 \
+        pool->free_bitmap[name##_WORDS - 1] = (1ull << ((block_count) % 64)) - 1;            \
+    }                                                                                         \
+}                                                                                             \
+                                                                                              \
+static inline uint8_t *name##_block(name##_t *pool, size_t index)                             \
+{                                                                                             \
+    return pool->area + (index << name##_SHIFT);                                              \
+}                                                                                             \
+                                                                                              \
+static inline size_t name##_index(name##_t *pool, const uint8_t *ptr)                         \
+{                                                                                             \
+    return (size_t)(ptr - pool->area) >> name##_SHIFT;                                        \
+}                                                                                             \
+                                                                                              \
+/* 从低地址开始取第一个空闲块, 池耗尽返回NULL */                                                    \
+static inline uint8_t *name##_alloc(name##_t *pool, bool for_hw)                              \
+{                                                                                             \
+    _Pragma("GCC unroll 64")                                                                  \
+    for (size_t w = 0; w < name##_WORDS; w++) {                                               \
+        uint64_t bits = MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->free_bitmap[w]);                   \
+        while (bits) {                                                                        \
+            uint64_t bit = bits & (~bits + 1);                                                \
+            if (MEMPOOL_ATOMIC_CAS(&pool->free_bitmap[w], &bits, bits & ~bit)) {              \
+                if (for_hw) {                                                                 \
+                    MEMPOOL_ATOMIC_FETCH_OR(&pool->hw_owned_bitmap[w], bit);                  \
+                }                                                                             \
+                return name##_block(pool, w * 64 + (size_t)__builtin_ctzll(bit));             \
+            }                                                                                 \
+        }                                                                                     \
+    }                                                                                         \
+    return NULL;                                                                              \
+}                                                                                             \
+                                                                                              \
+/* 越界指针与已空闲块直接忽略; 块内任意地址释放所在块 */                                                \
+static inline void name##_free(name##_t *pool, uint8_t *ptr)                                  \
+{                                                                                             \
+    if (ptr < pool->area || ptr >= pool->area + sizeof(pool->area)) {                         \
+        return;                                                                               \
+    }                                                                                         \
+    size_t index = name##_index(pool, ptr);                                                   \
+    uint64_t bit = 1ull << (index & 63);                                                      \
+    if (MEMPOOL_ATOMIC_LOAD(&pool->free_bitmap[index >> 6]) & bit) {                          \
+        return;                                                                               \
+    }                                                                                         \
+    if (MEMPOOL_ATOMIC_LOAD(&pool->hw_owned_bitmap[index >> 6]) & bit) {                      \
+        MEMPOOL_ATOMIC_FETCH_AND(&pool->hw_owned_bitmap[index >> 6], ~bit);                   \
+    }                                                                                         \
+    MEMPOOL_ATOMIC_FETCH_OR(&pool->free_bitmap[index >> 6], bit);                             \
+}                                                                                             \
+                                                                                              \
+static inline bool name##_is_hw_owned(name##_t *pool, const uint8_t *ptr)                     \
+{                                                                                             \
+    size_t index = name##_index(pool, ptr);                                                   \
+    return (MEMPOOL_ATOMIC_LOAD(&pool->hw_owned_bitmap[index >> 6]) >> (index & 63)) & 1;     \
+}                                                                                             \
+                                                                                              \
+static inline size_t name##_available(name##_t *pool)                                         \
+{                                                                                             \
+    size_t count = 0;                                                                         \
+    for (size_t w = 0; w < name##_WORDS; w++) {                                               \
+        count += (size_t)__builtin_popcountll(MEMPOOL_ATOMIC_LOAD(&pool->free_bitmap[w]));    \
+    }                                                                                         \
+    return count;                                                                             \
+}
+
+#endif // MEMPOOL_STATIC_H
@@ -1,6 +1,12 @@
 #include "mempool.h"
+#include "mempool_hist.h"
+#include "mempool_bitmap.h"
 #include <string.h>
 
+#if defined(__BMI2__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 #ifdef MEMPOOL_LOG_LEVEL
 #undef MEMPOOL_LOG_LEVEL
 #endif
@@ -54,20 +60,479 @@ static inline int find_first_set_bit(BITMAP_TYPE bitmap)
     #define POPCOUNT_LL(x) popcount_ll_generic(x)
 #endif
 
+// 每线程块缓存(magazine)
+struct mempool_magazine {
+    struct mempool_magazine *next;  // 池内缓存链表
+    mempool_t *pool;
+    size_t count;                   // 当前缓存块数
+    uint8_t *blocks[];              // 缓存栈(容量为pool->magazine_size)
+};
+
+// 块在某个线程缓存中(已释放过, 再次释放为重复释放)
+static inline bool mempool_magazine_cached(mempool_t *pool, size_t block_idx)
+{
+    if (pool->magazine_cached && MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->magazine_cached[block_idx])) {
+        ERROR_PRINT("Double free of block %zu in pool %p (already in a thread cache)", block_idx, pool);
+        return true;
+    }
+    return false;
+}
+
+// 位图字下标与位掩码
+#define BITMAP_WORD_OF(idx)     ((size_t)(idx) >> LOG2_MEMPOOL_BITMAP_EACH_NUM)
+#define BITMAP_MASK_OF(idx)     ((BITMAP_TYPE)1 << ((idx) & (MEMPOOL_BITMAP_EACH_NUM - 1)))
+
+// 有锁模式下修改叶子位图与硬件标记(调用者持有池锁): 线程缓存的释放路径不加锁读取这两个位图,
+// 因此以宽松原子写入(与普通写入的指令相同)
+#define BITMAP_SET_LOCKED(word_ptr, mask)   MEMPOOL_ATOMIC_STORE_RELAXED((word_ptr), *(word_ptr) | (mask))
+#define BITMAP_CLEAR_LOCKED(word_ptr, mask) MEMPOOL_ATOMIC_STORE_RELAXED((word_ptr), *(word_ptr) & ~(mask))
+
+// 空闲链表引擎的链表头布局: [标签22位 | 空闲块数21位 | 首块下标+1 21位], 块数与首块在同一次CAS中更新
+#define FREELIST_FIELD_BITS     21
+#define FREELIST_FIELD_MASK     (((uint64_t)1 << FREELIST_FIELD_BITS) - 1)
+#define FREELIST_MAX_BLOCKS     ((size_t)FREELIST_FIELD_MASK)
+#define FREELIST_FIRST(head)    ((uint32_t)((head) & FREELIST_FIELD_MASK))
+#define FREELIST_COUNT(head)    ((size_t)(((head) >> FREELIST_FIELD_BITS) & FREELIST_FIELD_MASK))
+#define FREELIST_HEAD(old, first, count) \
+    (((((old) >> (2 * FREELIST_FIELD_BITS)) + 1) << (2 * FREELIST_FIELD_BITS)) | \
+     ((uint64_t)(count) << FREELIST_FIELD_BITS) | (uint64_t)(first))
+
+// 将位图前nbits位置1, 其余位清0
+static void bitmap_fill(BITMAP_TYPE *bitmap, size_t words, size_t nbits)
+{
+    for (size_t i = 0; i < words; i++) {
+        bitmap[i] = (BITMAP_TYPE)(-1);
+    }
+
+    // 处理非对齐的位数(屏蔽多余位)
+    if (nbits % MEMPOOL_BITMAP_EACH_NUM != 0) {
+        bitmap[words - 1] = BITMAP_MASK_OF(nbits) - 1;
+    }
+}
+
+// 从第s个摘要字开始查找第一个非0摘要字, 不存在时返回summary_words;
+// 首字非0时直接返回, 否则交给向量查找内核跳过全0区域
+static inline size_t bitmap_next_summary(mempool_t *pool, size_t s)
+{
+    if (s >= pool->summary_words) {
+        return pool->summary_words;
+    }
+    if (MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->free_summary[s]) != 0) {
+        return s;
+    }
+    long bit = mempool_bitmap_find_first(&pool->free_summary[s], pool->summary_words - s);
+    return bit < 0 ? pool->summary_words : s + (size_t)bit / MEMPOOL_BITMAP_EACH_NUM;
+}
+
+// 通过摘要位图查找第一个有空闲块的叶子字(调用者持有池锁), 无空闲块时返回-1
+static inline long bitmap_find_word_locked(mempool_t *pool)
+{
+    size_t s = bitmap_next_summary(pool, 0);
+    if (s >= pool->summary_words) {
+        return -1;
+    }
+    return (long)(s * MEMPOOL_BITMAP_EACH_NUM + find_first_set_bit(pool->free_summary[s]));
+}
+
+// 从叶子字中取走mask对应的块(调用者持有池锁), 叶子字变空时同步清除摘要位
+static inline void bitmap_take_locked(mempool_t *pool, size_t word, BITMAP_TYPE mask)
+{
+    BITMAP_CLEAR_LOCKED(&pool->free_bitmap[word], mask);
+    if (pool->free_bitmap[word] == 0) {
+        pool->free_summary[BITMAP_WORD_OF(word)] &= ~BITMAP_MASK_OF(word);
+    }
+}
+
+// 将mask对应的块还回叶子字(调用者持有池锁)
+static inline void bitmap_give_locked(mempool_t *pool, size_t word, BITMAP_TYPE mask)
+{
+    BITMAP_SET_LOCKED(&pool->free_bitmap[word], mask);
+    pool->free_summary[BITMAP_WORD_OF(word)] |= BITMAP_MASK_OF(word);
+}
+
+// 无锁模式下叶子字被取空后清除摘要位; 清除后复查叶子字,
+// 避免与并发释放交错时丢失摘要位(无锁模式下摘要位只是"可能有空闲"的提示)
+static inline void summary_clear_lockfree(mempool_t *pool, size_t word)
+{
+    BITMAP_TYPE *summary = &pool->free_summary[BITMAP_WORD_OF(word)];
+
+    MEMPOOL_ATOMIC_FETCH_AND(summary, ~BITMAP_MASK_OF(word));
+    if (MEMPOOL_ATOMIC_FETCH_OR(&pool->free_bitmap[word], 0) != 0) {
+        MEMPOOL_ATOMIC_FETCH_OR(summary, BITMAP_MASK_OF(word));
+    }
+}
+
+// 无锁模式下将mask对应的块还回叶子字, 返回还回前的叶子字
+static inline BITMAP_TYPE bitmap_give_lockfree(mempool_t *pool, size_t word, BITMAP_TYPE mask)
+{
+    BITMAP_TYPE old = MEMPOOL_ATOMIC_FETCH_OR(&pool->free_bitmap[word], mask);
+
+    // 叶子字由空变为非空时置位摘要
+    if (old == 0) {
+        MEMPOOL_ATOMIC_FETCH_OR(&pool->free_summary[BITMAP_WORD_OF(word)], BITMAP_MASK_OF(word));
+    }
+    return old;
+}
+
+//===================================================================
+//  阻塞等待(futex)
+//===================================================================
+// 释放/入队成功后唤醒所有等待者, 无等待者时只有一次读取
+static inline void mempool_wait_wake(struct mempool_wait *wait)
+{
+    if (MEMPOOL_ATOMIC_LOAD(&wait->waiters) != 0) {
+        MEMPOOL_ATOMIC_FETCH_ADD(&wait->seq, 1);
+        MEMPOOL_FUTEX_WAKE_ALL(&wait->seq);
+    }
+}
+
+// 等待try_fn成功或超时. 先登记等待者, 再读取seq并重试:
+// 唤醒方"先归还块再检查waiters". 加锁的池与队列由try_fn在锁内检查(唤醒方在锁内归还/入队,
+// 解锁后才检查waiters, 两侧经过同一把锁), 无锁池的归还是顺序一致的原子读改写,
+// 因此要么重试能看到归还的块, 要么唤醒方看到等待者并改变seq使futex等待立即返回.
+// 无锁队列的发布只是release写, 唤醒方不付屏障代价, 由等待方登记后执行一次非对称屏障(heavy_barrier)
+static void *mempool_wait_until(struct mempool_wait *wait, uint64_t timeout_ns, bool heavy_barrier,
+                                void *(*try_fn)(void *ctx), void *ctx)
+{
+    uint64_t now = MEMPOOL_CURRENT_TIME_NS();
+    uint64_t deadline = (timeout_ns > UINT64_MAX - now) ? UINT64_MAX : now + timeout_ns;
+    void *result;
+
+    MEMPOOL_ATOMIC_FETCH_ADD(&wait->waiters, 1);
+    if (heavy_barrier) {
+        MEMPOOL_HEAVY_BARRIER();
+    }
+    for (;;) {
+        uint32_t seq = MEMPOOL_ATOMIC_LOAD(&wait->seq);
+        if ((result = try_fn(ctx)) != NULL) break;
+
+        uint64_t remaining = MEMPOOL_WAIT_FOREVER;
+        if (deadline != UINT64_MAX) {
+            now = MEMPOOL_CURRENT_TIME_NS();
+            if (now >= deadline) break;
+            remaining = deadline - now;
+        }
+        MEMPOOL_FUTEX_WAIT(&wait->seq, seq, remaining);
+    }
+    MEMPOOL_ATOMIC_FETCH_ADD(&wait->waiters, (uint32_t)-1);
+
+    return result;
+}
+
+//===================================================================
+//  统计计数: 按线程分片累加, 读取时汇总; 占用增量每MEMPOOL_STATS_BATCH块汇总一次到全局
+//===================================================================
+#if MEMPOOL_STATS_EN
+static MEMPOOL_THREAD_LOCAL unsigned mempool_stats_slot;    // 本线程分片号+1(0表示未分配)
+static unsigned mempool_stats_next_slot;
+
+static inline struct mempool_stats_shard *mempool_stats_shard(mempool_t *pool)
+{
+    if (mempool_stats_slot == 0) {
+        mempool_stats_slot = MEMPOOL_ATOMIC_FETCH_ADD(&mempool_stats_next_slot, 1) + 1;
+    }
+    return &pool->stats[(mempool_stats_slot - 1) & (MEMPOOL_STATS_SHARDS - 1)];
+}
+
+// 峰值只增不减, 仅在超过当前峰值时写入
+static inline void mempool_stats_peak(size_t *peak, long value)
+{
+    size_t old = MEMPOOL_ATOMIC_LOAD_RELAXED(peak);
+    while (value > 0 && (size_t)value > old && !MEMPOOL_ATOMIC_CAS(peak, &old, (size_t)value))
+        ;
+}
+
+// 分配计数; 占用估计(全局值+本分片增量)超过峰值时更新峰值, 两者平时只读, 不产生缓存行争用
+static inline void mempool_stats_alloc(mempool_t *pool, size_t got, size_t requested, bool for_hw)
+{
+    struct mempool_stats_shard *shard = mempool_stats_shard(pool);
+
+    if (got < requested) {
+        MEMPOOL_ATOMIC_ADD_RELAXED(&shard->alloc_failures, 1);
+    }
+    if (got == 0) return;
+
+    MEMPOOL_ATOMIC_ADD_RELAXED(&shard->allocs, got);
+    if (for_hw) {
+        MEMPOOL_ATOMIC_ADD_RELAXED(&shard->hw_allocs, got);
+    }
+
+    long delta = MEMPOOL_ATOMIC_ADD_RELAXED(&shard->usage_delta, (long)got) + (long)got;
+    long in_use;
+    if (delta >= MEMPOOL_STATS_BATCH) {
+        delta = MEMPOOL_ATOMIC_EXCHANGE_RELAXED(&shard->usage_delta, 0);
+        in_use = MEMPOOL_ATOMIC_ADD_RELAXED(&pool->stats_in_use, delta) + delta;
+    } else {
+        in_use = MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->stats_in_use) + delta;
+    }
+    if (in_use > 0 && (size_t)in_use > MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->stats_peak)) {
+        mempool_stats_peak(&pool->stats_peak, in_use);
+    }
+}
+
+static inline void mempool_stats_free(mempool_t *pool, size_t n)
+{
+    if (n == 0) return;
+
+    struct mempool_stats_shard *shard = mempool_stats_shard(pool);
+    MEMPOOL_ATOMIC_ADD_RELAXED(&shard->frees, n);
+
+    long delta = MEMPOOL_ATOMIC_ADD_RELAXED(&shard->usage_delta, -(long)n) - (long)n;
+    if (delta <= -MEMPOOL_STATS_BATCH) {
+        delta = MEMPOOL_ATOMIC_EXCHANGE_RELAXED(&shard->usage_delta, 0);
+        MEMPOOL_ATOMIC_ADD_RELAXED(&pool->stats_in_use, delta);
+    }
+}
+
+// 硬件持有的块被释放
+static inline void mempool_stats_hw_free(mempool_t *pool, BITMAP_TYPE released)
+{
+    if (released) {
+        MEMPOOL_ATOMIC_ADD_RELAXED(&mempool_stats_shard(pool)->hw_frees, (size_t)POPCOUNT_LL(released));
+    }
+}
+
+// 加锁, 锁已被占用时计一次竞争
+#define MEMPOOL_LOCK_STAT(pool, lock)                                             \
+    do {                                                                          \
+        if (MEMPOOL_TRYLOCK(lock) != 0) {                                         \
+            MEMPOOL_ATOMIC_ADD_RELAXED(&mempool_stats_shard(pool)->lock_contended, 1); \
+            MEMPOOL_LOCK(lock);                                                   \
+        }                                                                         \
+    } while (0)
+
+// 入队后的深度更新深度峰值
+static inline void mempool_queue_stats_depth(mempool_queue_t *queue, size_t depth)
+{
+    if (depth > MEMPOOL_ATOMIC_LOAD_RELAXED(&queue->stats_peak_depth)) {
+        mempool_stats_peak(&queue->stats_peak_depth, (long)depth);
+    }
+}
+
+static inline void mempool_queue_stats_reject(mempool_queue_t *queue)
+{
+    MEMPOOL_ATOMIC_ADD_RELAXED(&queue->stats_rejected, 1);
+}
+
+static int mempool_stats_init(mempool_t *pool)
+{
+    pool->stats = MEMPOOL_MEMALIGN(MEMPOOL_ALIGNMENT, sizeof(struct mempool_stats_shard) * MEMPOOL_STATS_SHARDS);
+    if (!pool->stats) {
+        ERROR_PRINT("Failed to allocate stats shards");
+        return -1;
+    }
+    memset(pool->stats, 0, sizeof(struct mempool_stats_shard) * MEMPOOL_STATS_SHARDS);
+    return 0;
+}
+#else
+// 关闭统计时为空函数(参数中可能带有必须执行的原子操作, 不能用空宏丢弃)
+static inline void mempool_stats_alloc(mempool_t *pool, size_t got, size_t requested, bool for_hw)
+{
+    (void)pool; (void)got; (void)requested; (void)for_hw;
+}
+static inline void mempool_stats_free(mempool_t *pool, size_t n) { (void)pool; (void)n; }
+static inline void mempool_stats_hw_free(mempool_t *pool, BITMAP_TYPE released) { (void)pool; (void)released; }
+static inline void mempool_queue_stats_depth(mempool_queue_t *queue, size_t depth) { (void)queue; (void)depth; }
+static inline void mempool_queue_stats_reject(mempool_queue_t *queue) { (void)queue; }
+static inline int mempool_stats_init(mempool_t *pool) { (void)pool; return 0; }
+#define MEMPOOL_LOCK_STAT(pool, lock)                       MEMPOOL_LOCK(lock)
+#endif
+
+//===================================================================
+//  内存区域后端(大页/预取/锁定)
+//===================================================================
+// 逐页写入一次, 使缺页发生在创建阶段而不是数据路径上
+static void mempool_area_prefault(uint8_t *addr, size_t size, size_t page)
+{
+    for (size_t off = 0; off < size; off += page) {
+        ((volatile uint8_t *)addr)[off] = 0;
+    }
+}
+
+// 对已映射的区域应用预取/锁定, 返回实际生效的标志
+static uint32_t mempool_area_apply(uint8_t *addr, size_t size, uint32_t flags)
+{
+    uint32_t applied = 0;
+
+    if (flags & MEMPOOL_FLAG_MLOCK) {
+        // mlock本身会触发所有页的缺页
+        if (MEMPOOL_VM_LOCK(addr, size) == 0) {
+            applied |= MEMPOOL_FLAG_MLOCK | MEMPOOL_FLAG_PREFAULT;
+        } else {
+            WARNING_PRINT("mlock of %zu bytes failed, memory area is not locked", size);
+        }
+    }
+    if ((flags & MEMPOOL_FLAG_PREFAULT) && !(applied & MEMPOOL_FLAG_PREFAULT)) {
+        mempool_area_prefault(addr, size, MEMPOOL_VM_PAGE_SIZE());
+        applied |= MEMPOOL_FLAG_PREFAULT;
+    }
+    return applied;
+}
+
+// 按后端标志映射内存区域: MAP_HUGETLB -> 透明大页 -> 普通页
+static uint8_t *mempool_area_map(size_t size, uint32_t flags, size_t *mapped, uint32_t *applied)
+{
+    uint8_t *area = NULL;
+
+    *applied = 0;
+    if (flags & MEMPOOL_FLAG_HUGEPAGE) {
+        *mapped = (size + MEMPOOL_HUGEPAGE_SIZE - 1) & ~(MEMPOOL_HUGEPAGE_SIZE - 1);
+        area = MEMPOOL_VM_MAP(*mapped, true);
+        if (area) {
+            *applied |= MEMPOOL_FLAG_HUGEPAGE;
+        } else {
+            WARNING_PRINT("MAP_HUGETLB unavailable for %zu bytes, falling back to transparent huge pages", *mapped);
+            flags |= MEMPOOL_FLAG_THP;
+        }
+    }
+
+    if (!area) {
+        // 透明大页需要按大页对齐的长度才有机会整页映射
+        size_t page = (flags & MEMPOOL_FLAG_THP) ? MEMPOOL_HUGEPAGE_SIZE : MEMPOOL_VM_PAGE_SIZE();
+        *mapped = (size + page - 1) & ~(page - 1);
+        area = MEMPOOL_VM_MAP(*mapped, false);
+        if (!area) return NULL;
+
+        if (flags & MEMPOOL_FLAG_THP) {
+            if (MEMPOOL_VM_ADVISE_HUGE(area, *mapped) == 0) {
+                *applied |= MEMPOOL_FLAG_THP;
+            } else {
+                WARNING_PRINT("Transparent huge pages unavailable, using normal pages");
+            }
+        }
+    }
+
+    *applied |= mempool_area_apply(area, *mapped, flags);
+    return area;
+}
+
+// 位图区域大小: [空闲位图 | 硬件位图 | 摘要位图 | 引用计数(MEMPOOL_FLAG_REFCOUNT) | 空闲链表(MEMPOOL_FLAG_FREELIST)],
+// 各位图按缓存行对齐, 避免空闲位图与硬件位图伪共享
+static size_t mempool_bitmap_area_size(size_t num_blocks, uint32_t flags)
+{
+    size_t leaf_words = MEMPOOL_BITMAP_WORDS(num_blocks);
+    size_t leaf_bytes = (leaf_words * sizeof(BITMAP_TYPE) + MEMPOOL_ALIGNMENT - 1) & ~(MEMPOOL_ALIGNMENT - 1);
+    size_t summary_bytes = (MEMPOOL_BITMAP_WORDS(leaf_words) * sizeof(BITMAP_TYPE) + MEMPOOL_ALIGNMENT - 1) & ~(MEMPOOL_ALIGNMENT - 1);
+    size_t refcount_bytes = (flags & MEMPOOL_FLAG_REFCOUNT) ? num_blocks * sizeof(uint32_t) : 0;
+    size_t freelist_bytes = (flags & MEMPOOL_FLAG_FREELIST) ? num_blocks * sizeof(uint32_t) : 0;
+    return leaf_bytes * 2 + summary_bytes + refcount_bytes + freelist_bytes;
+}
+
+// 初始化控制结构参数并划分位图区域(不修改位图内容, memory_area与area_*由调用者设置)
+static void mempool_init_fields(mempool_t *pool, size_t data_size, size_t num_blocks, uint32_t flags, uint8_t *bitmap_area)
+{
+    size_t leaf_words = MEMPOOL_BITMAP_WORDS(num_blocks);
+    size_t leaf_bytes = (leaf_words * sizeof(BITMAP_TYPE) + MEMPOOL_ALIGNMENT - 1) & ~(MEMPOOL_ALIGNMENT - 1);
+    size_t summary_bytes = (MEMPOOL_BITMAP_WORDS(leaf_words) * sizeof(BITMAP_TYPE) + MEMPOOL_ALIGNMENT - 1) & ~(MEMPOOL_ALIGNMENT - 1);
+
+#ifdef MEMPOOL_LOCK_INIT
+    MEMPOOL_LOCK_INIT(&pool->lock);
+#endif
+    
+    // 初始化参数
+    pool->block_size_unaligned = data_size;
+    pool->block_size = (data_size + MEMPOOL_ALIGNMENT - 1) & ~(MEMPOOL_ALIGNMENT - 1);
+    pool->block_count = num_blocks;
+    pool->flags = flags;
+    pool->pool_id = 0;
+    pool->shared = NULL;
+    pool->wait_local.seq = 0;
+    pool->wait_local.waiters = 0;
+    pool->wait = &pool->wait_local;
+    pool->magazine_size = 0;
+    pool->magazines = NULL;
+    pool->magazine_cached = NULL;
+    pool->stats = NULL;
+    pool->stats_in_use = 0;
+    pool->stats_peak = 0;
+    pool->slab_blocks = 0;
+    pool->slab_max = 0;
+    pool->slab_min = 0;
+    pool->slab_committed = 0;
+    pool->slab_generation = 0;
+    pool->slab_state = NULL;
+    pool->placement = MEMPOOL_PLACEMENT_FIRST_FIT;
+    pool->next_fit_cursor = 0;
+    pool->lifo_hints = NULL;
+    pool->lifo_top = 0;
+
+    pool->bitmap_words = leaf_words;
+    pool->summary_words = MEMPOOL_BITMAP_WORDS(leaf_words);
+    pool->free_bitmap = (BITMAP_TYPE *)bitmap_area;
+    pool->hw_owned_bitmap = (BITMAP_TYPE *)(bitmap_area + leaf_bytes);
+    pool->free_summary = (BITMAP_TYPE *)(bitmap_area + leaf_bytes * 2);
+    pool->refcount = (flags & MEMPOOL_FLAG_REFCOUNT) ? (uint32_t *)(bitmap_area + leaf_bytes * 2 + summary_bytes) : NULL;
+    pool->freelist_next = (flags & MEMPOOL_FLAG_FREELIST) ?
+        (uint32_t *)(bitmap_area + leaf_bytes * 2 + summary_bytes) + (pool->refcount ? num_blocks : 0) : NULL;
+    pool->freelist_head = 0;
+}
+
+// 初始化位图(全1表示空闲, 超出实际块数的位保持为0)
+static void mempool_bitmap_reset(mempool_t *pool)
+{
+    bitmap_fill(pool->free_bitmap, pool->bitmap_words, pool->block_count);
+    bitmap_fill(pool->free_summary, pool->summary_words, pool->bitmap_words);
+    memset(pool->hw_owned_bitmap, 0, pool->bitmap_words * sizeof(BITMAP_TYPE));
+    if (pool->refcount) {
+        memset(pool->refcount, 0, pool->block_count * sizeof(uint32_t));
+    }
+
+    // 空闲链表按下标升序串起所有块; 不做重复释放检查时不维护空闲位图
+    if (pool->freelist_next) {
+        for (size_t i = 0; i < pool->block_count; i++) {
+            pool->freelist_next[i] = i + 1 < pool->block_count ? (uint32_t)(i + 2) : 0;
+        }
+        pool->freelist_head = ((uint64_t)pool->block_count << FREELIST_FIELD_BITS) | 1;
+#if !MEMPOOL_FREELIST_CHECK
+        memset(pool->free_bitmap, 0, pool->bitmap_words * sizeof(BITMAP_TYPE));
+#endif
+    }
+
+    DEBUG_PRINT("Bitmap initialized: %zu leaf words, %zu summary words", pool->bitmap_words, pool->summary_words);
+}
+
 // 创建内存池
 mempool_t *mempool_create(size_t data_size, size_t num_blocks)
+{
+    return mempool_create_flags(data_size, num_blocks, MEMPOOL_DEFAULT_FLAGS);
+}
+
+// 创建内存池(指定创建标志)
+mempool_t *mempool_create_flags(size_t data_size, size_t num_blocks, uint32_t flags)
+{
+    return mempool_create_with_area(NULL, data_size, num_blocks, flags & ~MEMPOOL_FLAG_EXTERNAL_AREA);
+}
+
+// 在调用者提供的内存区域上创建内存池(area为NULL时自行分配)
+mempool_t *mempool_create_with_area(uint8_t *area, size_t data_size, size_t num_blocks, uint32_t flags)
 {
     if (data_size == 0 || num_blocks == 0 || num_blocks > MEMPOOL_MAX_BLOCKS) {
         return NULL;
     }
+    if (flags & MEMPOOL_FLAG_INTERNAL_MASK) {
+        ERROR_PRINT("Flags 0x%x can only be set by mempool_create_elastic/mempool_create_shared",
+                    flags & MEMPOOL_FLAG_INTERNAL_MASK);
+        return NULL;
+    }
+    if (((uintptr_t)area & (MEMPOOL_ALIGNMENT - 1)) != 0) {
+        ERROR_PRINT("Memory area %p is not %d-byte aligned", area, MEMPOOL_ALIGNMENT);
+        return NULL;
+    }
+    if ((flags & MEMPOOL_FLAG_FREELIST) && ((flags & MEMPOOL_FLAG_REFCOUNT) || num_blocks > FREELIST_MAX_BLOCKS)) {
+        ERROR_PRINT("Free-list engine does not support refcounted pools or more than %zu blocks", FREELIST_MAX_BLOCKS);
+        return NULL;
+    }
+    if (area) {
+        flags |= MEMPOOL_FLAG_EXTERNAL_AREA;
+    }
 
-    DEBUG_PRINT("Creating mempool: data_size=%zu, num_blocks=%zu", data_size, num_blocks);
+    DEBUG_PRINT("Creating mempool: data_size=%zu, num_blocks=%zu, flags=0x%x", data_size, num_blocks, flags);
 
     // 计算对齐后的块大小
     size_t aligned_size = (data_size + MEMPOOL_ALIGNMENT - 1) & ~(MEMPOOL_ALIGNMENT - 1);
 
     DEBUG_PRINT("Aligned block size: %zu", aligned_size);
-    
+
     // 分配控制结构
     mempool_t *pool = MEMPOOL_MALLOC(sizeof(mempool_t));
     if (!pool) {
@@ -75,160 +540,1712 @@ mempool_t *mempool_create(size_t data_size, size_t num_blocks)
         return NULL;
     }
     
-    // 分配内存区域(保证对齐)
-    pool->memory_area = MEMPOOL_MEMALIGN(MEMPOOL_ALIGNMENT, aligned_size * num_blocks);
+    // 分配内存区域(保证对齐), 外部区域直接使用, 指定后端标志时改用mmap
+    pool->area_flags = 0;
+    pool->area_size = 0;
+    if (area) {
+        pool->memory_area = area;
+    } else if (flags & MEMPOOL_FLAG_AREA_MASK) {
+        pool->memory_area = mempool_area_map(aligned_size * num_blocks, flags, &pool->area_size, &pool->area_flags);
+    } else {
+        pool->memory_area = MEMPOOL_MEMALIGN(MEMPOOL_ALIGNMENT, aligned_size * num_blocks);
+    }
     if (!pool->memory_area) {
         ERROR_PRINT("Failed to allocate memory area");
         MEMPOOL_FREE(pool);
         return NULL;
     }
 
-#ifdef MEMPOOL_LOCK_INIT
-    MEMPOOL_LOCK_INIT(&pool->lock);
-#endif
-    
-    // 初始化参数
-    pool->block_size_unaligned = data_size;
-    pool->block_size = aligned_size;
-    pool->block_count = num_blocks;
-    
-    // 初始化位图(全1表示空闲)
-    for (int i = 0; i < BITMAP_WORDS; i++) {
-        pool->free_bitmap[i] = (BITMAP_TYPE)(-1);
-        pool->hw_owned_bitmap[i] = 0;
-
-        DEBUG_PRINT("Free bitmap[%d] initialized to 0x%lx", i, pool->free_bitmap[i]);
+    // 分配位图区域: [空闲位图 | 硬件位图 | 摘要位图 | 引用计数]
+    uint8_t *bitmap_area = MEMPOOL_MEMALIGN(MEMPOOL_ALIGNMENT, mempool_bitmap_area_size(num_blocks, flags));
+    if (!bitmap_area) {
+        ERROR_PRINT("Failed to allocate bitmaps");
+        if (pool->area_size) {
+            MEMPOOL_VM_RELEASE(pool->memory_area, pool->area_size);
+        } else if (!area) {
+            MEMPOOL_FREE(pool->memory_area);
+        }
+        MEMPOOL_FREE(pool);
+        return NULL;
     }
-    
-    // 处理非对齐的块数量(屏蔽多余位)
-    if (num_blocks % (sizeof(BITMAP_TYPE)*8) != 0) {
-        int used_bits = num_blocks % (sizeof(BITMAP_TYPE)*8);
-        int last_word = (num_blocks - 1) / (sizeof(BITMAP_TYPE)*8);
-        pool->free_bitmap[last_word] &= ((BITMAP_TYPE)1 << used_bits) - 1;
-        DEBUG_PRINT("Adjusted bitmap[%d] to 0x%lx (used_bits=%d)", 
-                last_word, (unsigned long)pool->free_bitmap[last_word], used_bits);
+
+    mempool_init_fields(pool, data_size, num_blocks, flags, bitmap_area);
+    mempool_bitmap_reset(pool);
+    if (mempool_stats_init(pool) != 0) {
+        mempool_destroy(pool);
+        return NULL;
     }
-    
+
     return pool;
 }
 
-// 销毁内存池
-void mempool_destroy(mempool_t *pool)
+//===================================================================
+//  弹性扩展(slab)
+//===================================================================
+// 第slab个slab的内存范围(按页取整: 提交时覆盖首尾所在页, 归还时只归还完全属于该slab的页)
+static void mempool_slab_range(mempool_t *pool, size_t slab, bool inner, uint8_t **addr, size_t *len)
 {
-    MEMPOOL_ASSERT(pool != NULL);
-
-    DEBUG_PRINT("Destroying mempool at %p", pool);
-    
-    if (pool->memory_area) {
-        MEMPOOL_FREE(pool->memory_area);
+    size_t page = MEMPOOL_VM_PAGE_SIZE();
+    uintptr_t start = (uintptr_t)(pool->memory_area + slab * pool->slab_blocks * pool->block_size);
+    uintptr_t end = start + pool->slab_blocks * pool->block_size;
+
+    if (inner) {
+        start = (start + page - 1) & ~(page - 1);
+        end &= ~(page - 1);
+    } else {
+        start &= ~(page - 1);
+        end = (end + page - 1) & ~(page - 1);
     }
-    MEMPOOL_FREE(pool);
+    *addr = (uint8_t *)start;
+    *len = end > start ? end - start : 0;
 }
 
-// 分配内存块
-uint8_t *mempool_alloc(mempool_t *pool, bool for_hw)
+// 提交一个slab并将其块标记为空闲(调用者持有池锁)
+static int mempool_slab_commit_locked(mempool_t *pool, size_t slab)
 {
-    MEMPOOL_ASSERT(pool != NULL);
+    uint8_t *addr;
+    size_t len;
 
-    BITMAP_TYPE bitmap;
-    int bit_pos;
-    int block_idx;
-    uint8_t *block = NULL;
+    mempool_slab_range(pool, slab, false, &addr, &len);
+    if (MEMPOOL_VM_COMMIT(addr, len) != 0) {
+        ERROR_PRINT("Failed to commit slab %zu of pool %p", slab, pool);
+        return -1;
+    }
+    // 任一slab未能预取/锁定时清除对应的生效标志
+    if (pool->flags & (MEMPOOL_FLAG_PREFAULT | MEMPOOL_FLAG_MLOCK)) {
+        pool->area_flags &= ~(MEMPOOL_FLAG_PREFAULT | MEMPOOL_FLAG_MLOCK) | mempool_area_apply(addr, len, pool->flags);
+    }
+
+    // 先标记为已提交再发布空闲位, 否则其他线程可能在标记前分配并释放该slab中的块而被拒绝
+    MEMPOOL_ATOMIC_STORE(&pool->slab_state[slab], 1);
+    size_t words = pool->slab_blocks / MEMPOOL_BITMAP_EACH_NUM;
+    for (size_t w = slab * words; w < (slab + 1) * words; w++) {
+        if (pool->flags & MEMPOOL_FLAG_LOCKFREE) {
+            bitmap_give_lockfree(pool, w, (BITMAP_TYPE)(-1));
+        } else {
+            bitmap_give_locked(pool, w, (BITMAP_TYPE)(-1));
+        }
+    }
+
+    MEMPOOL_ATOMIC_FETCH_ADD(&pool->slab_committed, 1);
+    MEMPOOL_ATOMIC_FETCH_ADD(&pool->slab_generation, 1);
+    DEBUG_PRINT("Pool %p grew to %zu slabs (slab %zu)", pool, pool->slab_committed, slab);
+    return 0;
+}
 
+// 扩展一个slab; generation为调用者分配失败前读取的slab变化计数,
+// 若期间其他线程已扩展或收缩则直接返回0由调用者重试, 已达上限时返回-1
+static int mempool_slab_grow(mempool_t *pool, size_t generation)
+{
 #ifdef MEMPOOL_LOCK_INIT
     MEMPOOL_LOCK_TYPE *lock = &pool->lock;
 #else
     MEMPOOL_LOCK_TYPE lock;
 #endif
-
-    DEBUG_PRINT("Allocating block (for_hw=%d)", for_hw);
+    int ret = -1;
 
     MEMPOOL_LOCK(lock);
+    if (MEMPOOL_ATOMIC_LOAD(&pool->slab_generation) != generation) {
+        ret = 0;
+    } else {
+        for (size_t slab = 0; slab < pool->slab_max; slab++) {
+            if (!pool->slab_state[slab]) {
+                ret = mempool_slab_commit_locked(pool, slab);
+                break;
+            }
+        }
+    }
+    MEMPOOL_UNLOCK(lock);
 
-    for (int i = 0; i < BITMAP_WORDS; i++)
-    {
-        if ((bitmap = pool->free_bitmap[i]) == 0)
-            continue;
-
-        if ((bit_pos = find_first_set_bit(bitmap)) < 0)
-            continue;
-
-        // 超出实际块数
-        if ((block_idx = i * MEMPOOL_BITMAP_EACH_NUM + bit_pos) >= pool->block_count)
-            continue;
+    return ret;
+}
 
-        // 标记块为已分配
-        pool->free_bitmap[i] &= ~((BITMAP_TYPE)1 << bit_pos);
-        if (for_hw)
-        {
-            pool->hw_owned_bitmap[i] |= ((BITMAP_TYPE)1 << bit_pos);
-        }
+// 创建弹性内存池
+mempool_t *mempool_create_elastic(size_t data_size, size_t slab_blocks, size_t initial_slabs,
+                                  size_t max_slabs, uint32_t flags)
+{
+    if (data_size == 0 || slab_blocks == 0 || initial_slabs == 0 || initial_slabs > max_slabs) {
+        return NULL;
+    }
+    if (flags & MEMPOOL_FLAG_FREELIST) {
+        ERROR_PRINT("Free-list engine does not support elastic pools");
+        return NULL;
+    }
 
-        // 返回内存块地址
-        block = pool->memory_area + block_idx * pool->block_size;
-        MEMPOOL_UNLOCK(lock);
+    // slab块数按位图字对齐, 使每个slab独占整数个位图字
+    slab_blocks = (slab_blocks + MEMPOOL_BITMAP_EACH_NUM - 1) & ~(MEMPOOL_BITMAP_EACH_NUM - 1);
+    if (max_slabs > MEMPOOL_MAX_BLOCKS / slab_blocks) {
+        ERROR_PRINT("Elastic pool exceeds MEMPOOL_MAX_BLOCKS (%zu x %zu blocks)", max_slabs, slab_blocks);
+        return NULL;
+    }
 
-        DEBUG_PRINT("Found free block at index %d (bitmap %d, bit %d)", block_idx, i, bit_pos);
+    size_t aligned_size = (data_size + MEMPOOL_ALIGNMENT - 1) & ~(MEMPOOL_ALIGNMENT - 1);
+    size_t num_blocks = slab_blocks * max_slabs;
+    uint8_t *area = MEMPOOL_VM_RESERVE(aligned_size * num_blocks);
+    if (!area) {
+        ERROR_PRINT("Failed to reserve %zu bytes for elastic pool", aligned_size * num_blocks);
+        return NULL;
+    }
 
-        return block;
+    // 大页提示作用于整个预留区域, 预取/锁定在提交slab时进行
+    uint32_t area_flags = 0;
+    if ((flags & (MEMPOOL_FLAG_HUGEPAGE | MEMPOOL_FLAG_THP)) &&
+        MEMPOOL_VM_ADVISE_HUGE(area, aligned_size * num_blocks) == 0) {
+        area_flags |= MEMPOOL_FLAG_THP;
     }
 
-    MEMPOOL_UNLOCK(lock);
+    mempool_t *pool = mempool_create_with_area(area, data_size, num_blocks, flags & ~MEMPOOL_FLAG_ELASTIC);
+    uint8_t *slab_state = MEMPOOL_MALLOC(max_slabs);
+    if (!pool || !slab_state) {
+        ERROR_PRINT("Failed to create elastic pool");
+        if (pool) mempool_destroy(pool);
+        MEMPOOL_FREE(slab_state);
+        MEMPOOL_VM_RELEASE(area, aligned_size * num_blocks);
+        return NULL;
+    }
 
-    DEBUG_PRINT("No free blocks available");
+    // 未提交的slab在位图中保持为已占用
+    memset(pool->free_bitmap, 0, pool->bitmap_words * sizeof(BITMAP_TYPE));
+    memset(pool->free_summary, 0, pool->summary_words * sizeof(BITMAP_TYPE));
+    memset(slab_state, 0, max_slabs);
+    pool->flags |= MEMPOOL_FLAG_ELASTIC;
+    pool->area_size = aligned_size * num_blocks;
+    pool->area_flags = area_flags | (flags & (MEMPOOL_FLAG_PREFAULT | MEMPOOL_FLAG_MLOCK));
+    pool->slab_blocks = slab_blocks;
+    pool->slab_max = max_slabs;
+    pool->slab_min = initial_slabs;
+    pool->slab_state = slab_state;
+
+    for (size_t slab = 0; slab < initial_slabs; slab++) {
+        if (mempool_slab_commit_locked(pool, slab) != 0) {
+            mempool_destroy(pool);
+            return NULL;
+        }
+    }
 
-    return NULL; // 无可用块
+    return pool;
 }
 
-// 释放内存块
-void mempool_free(mempool_t *pool, uint8_t *ptr)
+// 从位图中整体取走一个完全空闲的slab(调用者持有池锁), slab中有已分配块时返回false
+static bool mempool_slab_take_locked(mempool_t *pool, size_t slab)
 {
-    DEBUG_PRINT("Freeing block at %p", ptr);
+    size_t words = pool->slab_blocks / MEMPOOL_BITMAP_EACH_NUM;
+    size_t first = slab * words;
 
-    if (!pool || !ptr) return;
+    if (!(pool->flags & MEMPOOL_FLAG_LOCKFREE)) {
+        for (size_t w = first; w < first + words; w++) {
+            if (pool->free_bitmap[w] != (BITMAP_TYPE)(-1)) return false;
+        }
+        for (size_t w = first; w < first + words; w++) {
+            bitmap_take_locked(pool, w, (BITMAP_TYPE)(-1));
+        }
+        return true;
+    }
 
-    if (ptr < pool->memory_area || ptr >= pool->memory_area + pool->block_size * pool->block_count) {
-        ERROR_PRINT("Invalid pointer %p (outside pool range)", ptr);
-        return;
+    // 无锁模式逐字CAS取走, 中途失败时归还已取走的字
+    for (size_t w = first; w < first + words; w++) {
+        BITMAP_TYPE bitmap = (BITMAP_TYPE)(-1);
+        while (!MEMPOOL_ATOMIC_CAS(&pool->free_bitmap[w], &bitmap, 0) && bitmap == (BITMAP_TYPE)(-1))
+            ; // 弱CAS可能伪失败, 字仍为全空闲时重试
+        if (bitmap != (BITMAP_TYPE)(-1)) {
+            while (w-- > first) {
+                bitmap_give_lockfree(pool, w, (BITMAP_TYPE)(-1));
+            }
+            return false;
+        }
     }
-    
+    for (size_t w = first; w < first + words; w++) {
+        summary_clear_lockfree(pool, w);
+    }
+    return true;
+}
+
+// 归还完全空闲的slab(保留常驻slab), 返回归还数量;
+// 线程缓存中的块视为已分配, 需要时先调用mempool_magazine_flush
+size_t mempool_shrink(mempool_t *pool)
+{
+    if (!pool || !(pool->flags & MEMPOOL_FLAG_ELASTIC)) return 0;
+
 #ifdef MEMPOOL_LOCK_INIT
     MEMPOOL_LOCK_TYPE *lock = &pool->lock;
 #else
     MEMPOOL_LOCK_TYPE lock;
 #endif
+    size_t released = 0;
 
     MEMPOOL_LOCK(lock);
-    
-    // 计算块索引
-    size_t offset = ptr - pool->memory_area;
-    size_t block_idx = offset / pool->block_size;
-    
-    if (block_idx >= pool->block_count) {
-        MEMPOOL_UNLOCK(lock);
-        return; // 非法指针
+    for (size_t slab = pool->slab_max; slab-- > 0 && pool->slab_committed > pool->slab_min; ) {
+        if (!pool->slab_state[slab] || !mempool_slab_take_locked(pool, slab)) continue;
+
+        uint8_t *addr;
+        size_t len;
+        mempool_slab_range(pool, slab, true, &addr, &len);
+        if (len && MEMPOOL_VM_DECOMMIT(addr, len) != 0) {
+            ERROR_PRINT("Failed to decommit slab %zu of pool %p", slab, pool);
+        }
+
+        MEMPOOL_ATOMIC_STORE(&pool->slab_state[slab], 0);
+        MEMPOOL_ATOMIC_FETCH_ADD(&pool->slab_committed, (size_t)-1);
+        MEMPOOL_ATOMIC_FETCH_ADD(&pool->slab_generation, 1);
+        released++;
+    }
+    MEMPOOL_UNLOCK(lock);
+
+    DEBUG_PRINT("Pool %p released %zu slabs (%zu remain)", pool, released, pool->slab_committed);
+    return released;
+}
+
+// 弹性池中块所在slab是否已提交(已归还slab中的指针视为非法)
+static inline bool mempool_slab_valid(mempool_t *pool, size_t block_idx)
+{
+    return !(pool->flags & MEMPOOL_FLAG_ELASTIC) || MEMPOOL_ATOMIC_LOAD(&pool->slab_state[block_idx / pool->slab_blocks]);
+}
+
+//===================================================================
+//  跨进程共享池
+//===================================================================
+#define MEMPOOL_SHARED_MAGIC    0x4D454D504F4F4C31ull  // "MEMPOOL1"
+
+// 共享映射头部: 只保存偏移和参数, 不含指针(各进程映射地址不同)
+// 映射布局: [头部 | 位图区域 | 内存区域]
+struct mempool_shared_hdr {
+    uint64_t magic;
+    uint32_t pool_id;
+    uint32_t ready;             // 创建者初始化完成后置1
+    uint64_t data_size;
+    uint64_t num_blocks;
+    uint64_t bitmap_offset;
+    uint64_t area_offset;
+    uint64_t total_size;
+    struct mempool_wait wait;   // 跨进程阻塞分配等待状态
+};
+
+// 由映射建立本进程的池视图
+static mempool_t *mempool_shared_view(struct mempool_shared_hdr *hdr)
+{
+    mempool_t *pool = MEMPOOL_MALLOC(sizeof(mempool_t));
+    if (!pool) {
+        ERROR_PRINT("Failed to allocate pool control structure");
+        return NULL;
+    }
+
+    uint8_t *base = (uint8_t *)hdr;
+    pool->memory_area = base + hdr->area_offset;
+    pool->area_flags = 0;
+    pool->area_size = 0;
+    mempool_init_fields(pool, hdr->data_size, hdr->num_blocks,
+                        MEMPOOL_FLAG_SHARED | MEMPOOL_FLAG_LOCKFREE | MEMPOOL_FLAG_EXTERNAL_AREA,
+                        base + hdr->bitmap_offset);
+    pool->pool_id = hdr->pool_id;
+    pool->shared = hdr;
+    pool->wait = &hdr->wait;
+    if (mempool_stats_init(pool) != 0) {
+        MEMPOOL_FREE(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+// 创建共享池; 位图操作全部为原子操作, 对映射同一内存的多个进程天然安全,
+// 也不存在进程崩溃后遗留未释放的锁
+mempool_t *mempool_create_shared(const char *name, size_t data_size, size_t num_blocks)
+{
+    if (data_size == 0 || num_blocks == 0 || num_blocks > MEMPOOL_MAX_BLOCKS) {
+        return NULL;
+    }
+
+    size_t block_size = (data_size + MEMPOOL_ALIGNMENT - 1) & ~(MEMPOOL_ALIGNMENT - 1);
+    size_t bitmap_offset = (sizeof(struct mempool_shared_hdr) + MEMPOOL_ALIGNMENT - 1) & ~(MEMPOOL_ALIGNMENT - 1);
+    size_t area_offset = bitmap_offset + mempool_bitmap_area_size(num_blocks, 0);
+    size_t total_size = area_offset + block_size * num_blocks;
+
+    int fd = name ? MEMPOOL_SHM_CREATE(name) : MEMPOOL_SHM_ANON();
+    if (fd < 0) {
+        ERROR_PRINT("Failed to create shared memory %s", name ? name : "(memfd)");
+        return NULL;
+    }
+
+    struct mempool_shared_hdr *hdr = NULL;
+    if (MEMPOOL_SHM_RESIZE(fd, total_size) == 0) {
+        hdr = MEMPOOL_SHM_MAP(fd, total_size);
+    }
+    MEMPOOL_SHM_CLOSE(fd);
+    if (!hdr) {
+        ERROR_PRINT("Failed to map %zu bytes of shared memory", total_size);
+        if (name) MEMPOOL_SHM_UNLINK(name);
+        return NULL;
+    }
+
+    // 标识由进程号、时间与映射地址混合生成, 只用于拒绝其他池的句柄
+    uint32_t pool_id = MEMPOOL_PROCESS_ID() * 2654435761u ^ MEMPOOL_WALL_TIME() ^ (uint32_t)((uintptr_t)hdr >> 12);
+    hdr->magic = MEMPOOL_SHARED_MAGIC;
+    hdr->pool_id = pool_id ? pool_id : 1;
+    hdr->data_size = data_size;
+    hdr->num_blocks = num_blocks;
+    hdr->bitmap_offset = bitmap_offset;
+    hdr->area_offset = area_offset;
+    hdr->total_size = total_size;
+
+    mempool_t *pool = mempool_shared_view(hdr);
+    if (!pool) {
+        MEMPOOL_VM_RELEASE(hdr, total_size);
+        if (name) MEMPOOL_SHM_UNLINK(name);
+        return NULL;
+    }
+    mempool_bitmap_reset(pool);
+    MEMPOOL_ATOMIC_STORE(&hdr->ready, 1);
+
+    DEBUG_PRINT("Shared mempool %s created: id=0x%x, %zu bytes", name ? name : "(memfd)", hdr->pool_id, total_size);
+    return pool;
+}
+
+// 连接已存在的共享池
+mempool_t *mempool_attach_shared(const char *name)
+{
+    int fd = MEMPOOL_SHM_OPEN(name);
+    if (fd < 0) {
+        ERROR_PRINT("Shared mempool %s does not exist", name);
+        return NULL;
+    }
+
+    size_t size = MEMPOOL_SHM_SIZE(fd);
+    struct mempool_shared_hdr *hdr = size >= sizeof(*hdr) ? MEMPOOL_SHM_MAP(fd, size) : NULL;
+    MEMPOOL_SHM_CLOSE(fd);
+    if (!hdr) {
+        ERROR_PRINT("Failed to map shared mempool %s", name);
+        return NULL;
+    }
+
+    if (hdr->magic != MEMPOOL_SHARED_MAGIC || hdr->total_size != size || !MEMPOOL_ATOMIC_LOAD(&hdr->ready)) {
+        ERROR_PRINT("Shared mempool %s is not initialized", name);
+        MEMPOOL_VM_RELEASE(hdr, size);
+        return NULL;
+    }
+
+    mempool_t *pool = mempool_shared_view(hdr);
+    if (!pool) {
+        MEMPOOL_VM_RELEASE(hdr, size);
+    }
+    return pool;
+}
+
+// 删除共享池名字(已连接的进程不受影响, 映射在最后一个进程销毁视图后释放)
+int mempool_unlink_shared(const char *name)
+{
+    return MEMPOOL_SHM_UNLINK(name);
+}
+
+// 块指针转换为句柄, 非共享池或非法指针返回无效句柄
+mempool_handle_t mempool_to_handle(mempool_t *pool, uint8_t *ptr)
+{
+    mempool_handle_t handle = { 0, 0 };
+
+    if (!pool || !pool->pool_id || ptr < pool->memory_area ||
+        ptr >= pool->memory_area + pool->block_size * pool->block_count) {
+        return handle;
+    }
+    handle.pool_id = pool->pool_id;
+    handle.block_index = (uint32_t)((size_t)(ptr - pool->memory_area) / pool->block_size);
+    return handle;
+}
+
+// 句柄解析为本进程中的块地址, 句柄不属于该池时返回NULL
+uint8_t *mempool_from_handle(mempool_t *pool, mempool_handle_t handle)
+{
+    if (!pool || !handle.pool_id || handle.pool_id != pool->pool_id || handle.block_index >= pool->block_count) {
+        return NULL;
+    }
+    return pool->memory_area + (size_t)handle.block_index * pool->block_size;
+}
+
+// 销毁内存池
+void mempool_destroy(mempool_t *pool)
+{
+    MEMPOOL_ASSERT(pool != NULL);
+
+    DEBUG_PRINT("Destroying mempool at %p", pool);
+
+    // 回收各线程缓存(缓存中的块随内存区域一并释放)
+    if (pool->magazine_size) {
+        MEMPOOL_TLS_KEY_DELETE(pool->magazine_key);
+        while (pool->magazines) {
+            struct mempool_magazine *mag = pool->magazines;
+            pool->magazines = mag->next;
+            MEMPOOL_FREE(mag);
+        }
+        MEMPOOL_FREE(pool->magazine_cached);
     }
     
-    // 计算位图位置
-    int word_idx = block_idx / (sizeof(BITMAP_TYPE)*8);
-    int bit_pos = block_idx % (sizeof(BITMAP_TYPE)*8);
-    
-    // 验证状态
-    if ((pool->free_bitmap[word_idx] & ((BITMAP_TYPE)1 << bit_pos)) != 0) {
+    MEMPOOL_FREE(pool->stats);
+    MEMPOOL_FREE(pool->lifo_hints);
+
+    // 共享池的位图与内存区域都在共享映射中, 只解除本进程的映射
+    if (pool->shared) {
+        MEMPOOL_VM_RELEASE(pool->shared, pool->shared->total_size);
+        MEMPOOL_FREE(pool);
+        return;
+    }
+
+    if (pool->area_size) {
+        MEMPOOL_VM_RELEASE(pool->memory_area, pool->area_size);
+    } else if (pool->memory_area && !(pool->flags & MEMPOOL_FLAG_EXTERNAL_AREA)) {
+        MEMPOOL_FREE(pool->memory_area);
+    }
+    if (pool->flags & MEMPOOL_FLAG_ELASTIC) {
+        MEMPOOL_FREE(pool->slab_state);
+    }
+    MEMPOOL_FREE(pool->free_bitmap); // 位图区域起始地址
+    MEMPOOL_FREE(pool);
+}
+
+// 无锁分配: 经摘要位图定位叶子字后对叶子字做CAS, 失败时重新读取该字后重试
+static uint8_t *mempool_alloc_lockfree(mempool_t *pool, bool for_hw)
+{
+    for (size_t s = bitmap_next_summary(pool, 0); s < pool->summary_words; s = bitmap_next_summary(pool, s + 1))
+    {
+        BITMAP_TYPE summary = MEMPOOL_ATOMIC_LOAD(&pool->free_summary[s]);
+
+        while (summary != 0)
+        {
+            int summary_bit = find_first_set_bit(summary);
+            size_t word = s * MEMPOOL_BITMAP_EACH_NUM + summary_bit;
+            BITMAP_TYPE bitmap = MEMPOOL_ATOMIC_LOAD(&pool->free_bitmap[word]);
+
+            while (bitmap != 0)
+            {
+                int bit_pos = find_first_set_bit(bitmap);
+                BITMAP_TYPE mask = (BITMAP_TYPE)1 << bit_pos;
+                if (!MEMPOOL_ATOMIC_CAS(&pool->free_bitmap[word], &bitmap, bitmap & ~mask))
+                    continue; // bitmap已被CAS更新为最新值
+
+                if ((bitmap & ~mask) == 0)
+                {
+                    summary_clear_lockfree(pool, word);
+                }
+                if (for_hw)
+                {
+                    MEMPOOL_ATOMIC_FETCH_OR(&pool->hw_owned_bitmap[word], mask);
+                }
+
+                size_t block_idx = word * MEMPOOL_BITMAP_EACH_NUM + bit_pos;
+                DEBUG_PRINT("Found free block at index %zu (bitmap %zu, bit %d, lockfree)", block_idx, word, bit_pos);
+
+                return pool->memory_area + block_idx * pool->block_size;
+            }
+
+            // 叶子字已被其他线程取空(摘要位过期), 继续查找下一个
+            summary &= ~((BITMAP_TYPE)1 << summary_bit);
+        }
+    }
+
+    DEBUG_PRINT("No free blocks available");
+
+    return NULL; // 无可用块
+}
+
+//===================================================================
+//  分配位置策略(next-fit / LIFO)
+//  两种模式共用同一套查找代码: 有锁模式在池锁内执行, 无锁模式下位图读取为快照,
+//  最终以叶子字CAS取块, 取块失败(被其他线程抢先)时从该位置继续查找
+//===================================================================
+
+#define MEMPOOL_LIFO_HINTS   64    // 提示环槽数(2的幂)
+#define MEMPOOL_LIFO_PROBES  8     // 每次分配最多检查的最近释放块数
+
+// 从第w个叶子字开始查找摘要位为1的叶子字(摘要位可能已过期), 不存在时返回-1
+static long bitmap_next_word(mempool_t *pool, size_t w)
+{
+    if (w >= pool->bitmap_words) {
+        return -1;
+    }
+
+    size_t s = BITMAP_WORD_OF(w);
+    BITMAP_TYPE summary = MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->free_summary[s]) &
+                          ((BITMAP_TYPE)-1 << (w % MEMPOOL_BITMAP_EACH_NUM));
+    while (summary == 0) {
+        s = bitmap_next_summary(pool, s + 1);
+        if (s >= pool->summary_words) {
+            return -1;
+        }
+        summary = MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->free_summary[s]);
+    }
+    return (long)(s * MEMPOOL_BITMAP_EACH_NUM + find_first_set_bit(summary));
+}
+
+// 查找下标不小于start的第一个空闲块, 到末尾后从头回绕, 无空闲块时返回-1
+static long bitmap_find_from(mempool_t *pool, size_t start)
+{
+    size_t w = BITMAP_WORD_OF(start);
+    BITMAP_TYPE bits = MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->free_bitmap[w]) &
+                       ((BITMAP_TYPE)-1 << (start % MEMPOOL_BITMAP_EACH_NUM));
+    if (bits) {
+        return (long)(w * MEMPOOL_BITMAP_EACH_NUM + find_first_set_bit(bits));
+    }
+
+    // 先查w之后的叶子字, 再回绕查[0, w]
+    for (int pass = 0; pass < 2; pass++) {
+        for (long word = bitmap_next_word(pool, pass ? 0 : w + 1); word >= 0;
+             word = bitmap_next_word(pool, (size_t)word + 1)) {
+            if (pass && (size_t)word > w) {
+                break;
+            }
+            bits = MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->free_bitmap[word]);
+            if (bits) {
+                return (long)((size_t)word * MEMPOOL_BITMAP_EACH_NUM + find_first_set_bit(bits));
+            }
+        }
+    }
+    return -1;
+}
+
+// 取走指定的空闲块, 块已不空闲时返回false(有锁模式调用者持有池锁)
+static bool bitmap_take_index(mempool_t *pool, size_t block_idx, bool for_hw)
+{
+    size_t word = BITMAP_WORD_OF(block_idx);
+    BITMAP_TYPE mask = BITMAP_MASK_OF(block_idx);
+
+    if (!(pool->flags & MEMPOOL_FLAG_LOCKFREE)) {
+        if (!(pool->free_bitmap[word] & mask)) {
+            return false;
+        }
+        bitmap_take_locked(pool, word, mask);
+        if (for_hw) {
+            BITMAP_SET_LOCKED(&pool->hw_owned_bitmap[word], mask);
+        }
+        return true;
+    }
+
+    BITMAP_TYPE bitmap = MEMPOOL_ATOMIC_LOAD(&pool->free_bitmap[word]);
+    do {
+        if (!(bitmap & mask)) {
+            return false;
+        }
+    } while (!MEMPOOL_ATOMIC_CAS(&pool->free_bitmap[word], &bitmap, bitmap & ~mask));
+
+    if ((bitmap & ~mask) == 0) {
+        summary_clear_lockfree(pool, word);
+    }
+    if (for_hw) {
+        MEMPOOL_ATOMIC_FETCH_OR(&pool->hw_owned_bitmap[word], mask);
+    }
+    return true;
+}
+
+// 依次尝试最近释放的块; 提示环只是提示, 块是否可取以位图为准,
+// 因此槽位被取用后不清除, 已分配的块在下次检查时被跳过
+static long mempool_alloc_lifo_hint(mempool_t *pool, bool for_hw)
+{
+    size_t top = MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->lifo_top);
+
+    for (size_t k = 1; k <= MEMPOOL_LIFO_PROBES && k <= top; k++) {
+        uint32_t hint = MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->lifo_hints[(top - k) & (MEMPOOL_LIFO_HINTS - 1)]);
+        if (hint != 0 && bitmap_take_index(pool, hint - 1, for_hw)) {
+            return (long)(hint - 1);
+        }
+    }
+    return -1;
+}
+
+// 按next-fit/LIFO策略分配一个块
+static uint8_t *mempool_alloc_placed(mempool_t *pool, bool for_hw)
+{
+#ifdef MEMPOOL_LOCK_INIT
+    MEMPOOL_LOCK_TYPE *lock = &pool->lock;
+#else
+    MEMPOOL_LOCK_TYPE lock;
+#endif
+    bool locked = !(pool->flags & MEMPOOL_FLAG_LOCKFREE);
+    long block_idx = -1;
+
+    if (locked) {
+        MEMPOOL_LOCK_STAT(pool, lock);
+    }
+
+    if (pool->placement == MEMPOOL_PLACEMENT_LIFO) {
+        block_idx = mempool_alloc_lifo_hint(pool, for_hw);
+    }
+
+    if (block_idx < 0) {
+        size_t start = 0;
+        if (pool->placement == MEMPOOL_PLACEMENT_NEXT_FIT) {
+            start = MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->next_fit_cursor);
+        }
+        while ((block_idx = bitmap_find_from(pool, start)) >= 0 &&
+               !bitmap_take_index(pool, (size_t)block_idx, for_hw)) {
+            start = (size_t)block_idx; // 被其他线程抢先, 从该位置继续
+        }
+    }
+
+    if (block_idx >= 0 && pool->placement == MEMPOOL_PLACEMENT_NEXT_FIT) {
+        size_t next = (size_t)block_idx + 1;
+        MEMPOOL_ATOMIC_STORE_RELAXED(&pool->next_fit_cursor,
+                                     next < pool->bitmap_words * MEMPOOL_BITMAP_EACH_NUM ? next : 0);
+    }
+
+    if (locked) {
         MEMPOOL_UNLOCK(lock);
-        DEBUG_PRINT("Block already free at %p", ptr);
-        return; // 已经是空闲状态
     }
-    
-    // 清除硬件占用标记(如果存在)
-    if (pool->hw_owned_bitmap[word_idx] & ((BITMAP_TYPE)1 << bit_pos)) {
-        pool->hw_owned_bitmap[word_idx] &= ~((BITMAP_TYPE)1 << bit_pos);
+
+    if (block_idx < 0) {
+        DEBUG_PRINT("No free blocks available");
+        return NULL;
+    }
+    return pool->memory_area + (size_t)block_idx * pool->block_size;
+}
+
+// 记录刚释放的块(仅LIFO策略), 覆盖提示环中最旧的槽.
+// 无锁模式下并发释放可能互相覆盖, 只会丢失提示, 不需要原子加
+static inline void mempool_placement_freed(mempool_t *pool, size_t block_idx)
+{
+    if (pool->placement == MEMPOOL_PLACEMENT_LIFO) {
+        size_t top = MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->lifo_top);
+        MEMPOOL_ATOMIC_STORE_RELAXED(&pool->lifo_hints[top & (MEMPOOL_LIFO_HINTS - 1)], (uint32_t)block_idx + 1);
+        MEMPOOL_ATOMIC_STORE_RELAXED(&pool->lifo_top, top + 1);
+    }
+}
+
+// 设置单块分配位置策略
+int mempool_set_placement(mempool_t *pool, uint32_t placement)
+{
+    if (!pool || placement > MEMPOOL_PLACEMENT_LIFO || (pool->flags & MEMPOOL_FLAG_FREELIST)) {
+        return -1;
+    }
+
+    if (placement == MEMPOOL_PLACEMENT_LIFO && !pool->lifo_hints) {
+        pool->lifo_hints = (uint32_t *)MEMPOOL_MALLOC(sizeof(uint32_t) * MEMPOOL_LIFO_HINTS);
+        if (!pool->lifo_hints) {
+            ERROR_PRINT("Failed to allocate LIFO hints");
+            return -1;
+        }
+        memset(pool->lifo_hints, 0, sizeof(uint32_t) * MEMPOOL_LIFO_HINTS);
+    }
+
+    pool->placement = placement;
+    DEBUG_PRINT("Placement policy of pool %p set to %u", pool, placement);
+    return 0;
+}
+
+//===================================================================
+//  空闲链表引擎(MEMPOOL_FLAG_FREELIST)
+//  空闲块按下标串成单链表, 分配/释放只操作链表头, 与池大小无关.
+//  有锁模式在池锁内修改链表头; 无锁模式对带标签的链表头做64位CAS,
+//  标签每次修改加1, 防止弹出时首块被取走又放回造成的ABA问题.
+//  重复释放检查(MEMPOOL_FREELIST_CHECK)借用free_bitmap, 只在释放/分配时各做一次位操作
+//===================================================================
+
+// 弹出一个空闲块, 链表为空时返回-1(有锁模式调用者持有池锁)
+static long freelist_pop(mempool_t *pool)
+{
+    uint32_t first;
+
+    if (!(pool->flags & MEMPOOL_FLAG_LOCKFREE)) {
+        uint64_t head = pool->freelist_head;
+        first = FREELIST_FIRST(head);
+        if (first == 0) {
+            return -1;
+        }
+        pool->freelist_head = FREELIST_HEAD(head, pool->freelist_next[first - 1], FREELIST_COUNT(head) - 1);
+    } else {
+        uint64_t head = MEMPOOL_ATOMIC_LOAD(&pool->freelist_head);
+        do {
+            first = FREELIST_FIRST(head);
+            if (first == 0) {
+                return -1;
+            }
+            // 首块可能已被其他线程弹出并改写链接, 此时标签已变, CAS失败后重读
+        } while (!MEMPOOL_ATOMIC_CAS(&pool->freelist_head, &head,
+                                     FREELIST_HEAD(head, MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->freelist_next[first - 1]),
+                                                   FREELIST_COUNT(head) - 1)));
+    }
+
+#if MEMPOOL_FREELIST_CHECK
+    MEMPOOL_ATOMIC_FETCH_AND(&pool->free_bitmap[BITMAP_WORD_OF(first - 1)], ~BITMAP_MASK_OF(first - 1));
+#endif
+    return (long)(first - 1);
+}
+
+// 把first..last(已由freelist_next串好)共count个块压入链表(有锁模式调用者持有池锁)
+static void freelist_push_chain(mempool_t *pool, uint32_t first, uint32_t last, size_t count)
+{
+    if (!(pool->flags & MEMPOOL_FLAG_LOCKFREE)) {
+        uint64_t head = pool->freelist_head;
+        pool->freelist_next[last] = FREELIST_FIRST(head);
+        pool->freelist_head = FREELIST_HEAD(head, first + 1, FREELIST_COUNT(head) + count);
+        return;
+    }
+
+    uint64_t head = MEMPOOL_ATOMIC_LOAD(&pool->freelist_head);
+    do {
+        MEMPOOL_ATOMIC_STORE_RELAXED(&pool->freelist_next[last], FREELIST_FIRST(head));
+    } while (!MEMPOOL_ATOMIC_CAS(&pool->freelist_head, &head,
+                                 FREELIST_HEAD(head, first + 1, FREELIST_COUNT(head) + count)));
+}
+
+// 释放前的状态处理: 重复释放检查与清除硬件标记, 块已空闲时返回false
+static bool freelist_release(mempool_t *pool, size_t block_idx)
+{
+    size_t word = BITMAP_WORD_OF(block_idx);
+    BITMAP_TYPE mask = BITMAP_MASK_OF(block_idx);
+
+#if MEMPOOL_FREELIST_CHECK
+    if (MEMPOOL_ATOMIC_FETCH_OR(&pool->free_bitmap[word], mask) & mask) {
+        ERROR_PRINT("Double free of block %zu in pool %p", block_idx, pool);
+        return false;
+    }
+#endif
+    if (MEMPOOL_ATOMIC_LOAD(&pool->hw_owned_bitmap[word]) & mask) {
+        mempool_stats_hw_free(pool, MEMPOOL_ATOMIC_FETCH_AND(&pool->hw_owned_bitmap[word], ~mask) & mask);
+    }
+    return true;
+}
+
+static uint8_t *mempool_freelist_alloc(mempool_t *pool, bool for_hw)
+{
+#ifdef MEMPOOL_LOCK_INIT
+    MEMPOOL_LOCK_TYPE *lock = &pool->lock;
+#else
+    MEMPOOL_LOCK_TYPE lock;
+#endif
+    bool locked = !(pool->flags & MEMPOOL_FLAG_LOCKFREE);
+
+    if (locked) MEMPOOL_LOCK_STAT(pool, lock);
+    long block_idx = freelist_pop(pool);
+    if (locked) MEMPOOL_UNLOCK(lock);
+
+    if (block_idx < 0) {
+        DEBUG_PRINT("No free blocks available");
+        return NULL;
+    }
+    if (for_hw) {
+        MEMPOOL_ATOMIC_FETCH_OR(&pool->hw_owned_bitmap[BITMAP_WORD_OF(block_idx)], BITMAP_MASK_OF(block_idx));
+    }
+    return pool->memory_area + (size_t)block_idx * pool->block_size;
+}
+
+static size_t mempool_freelist_alloc_batch(mempool_t *pool, uint8_t **bufs, size_t n, bool for_hw)
+{
+#ifdef MEMPOOL_LOCK_INIT
+    MEMPOOL_LOCK_TYPE *lock = &pool->lock;
+#else
+    MEMPOOL_LOCK_TYPE lock;
+#endif
+    bool locked = !(pool->flags & MEMPOOL_FLAG_LOCKFREE);
+    size_t got = 0;
+    long block_idx;
+
+    if (locked) MEMPOOL_LOCK_STAT(pool, lock);
+    while (got < n && (block_idx = freelist_pop(pool)) >= 0) {
+        if (for_hw) {
+            MEMPOOL_ATOMIC_FETCH_OR(&pool->hw_owned_bitmap[BITMAP_WORD_OF(block_idx)], BITMAP_MASK_OF(block_idx));
+        }
+        bufs[got++] = pool->memory_area + (size_t)block_idx * pool->block_size;
+    }
+    if (locked) MEMPOOL_UNLOCK(lock);
+
+    return got;
+}
+
+// 批量释放: 先在旁路数组中把待释放块串成一条链, 再一次性接到链表头
+static size_t mempool_freelist_free_batch(mempool_t *pool, uint8_t **bufs, size_t n)
+{
+#ifdef MEMPOOL_LOCK_INIT
+    MEMPOOL_LOCK_TYPE *lock = &pool->lock;
+#else
+    MEMPOOL_LOCK_TYPE lock;
+#endif
+    bool locked = !(pool->flags & MEMPOOL_FLAG_LOCKFREE);
+    uint32_t first = 0, last = 0;
+    size_t freed = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        uint8_t *ptr = bufs[i];
+        if (!ptr) continue;
+
+        if (ptr < pool->memory_area || ptr >= pool->memory_area + pool->block_size * pool->block_count) {
+            ERROR_PRINT("Invalid pointer %p (outside pool range)", ptr);
+            continue;
+        }
+
+        uint32_t block_idx = (uint32_t)((size_t)(ptr - pool->memory_area) / pool->block_size);
+        if (mempool_magazine_cached(pool, block_idx) || !freelist_release(pool, block_idx)) continue;
+
+        if (freed++ == 0) {
+            first = block_idx;
+        } else {
+            MEMPOOL_ATOMIC_STORE_RELAXED(&pool->freelist_next[last], block_idx + 1);
+        }
+        last = block_idx;
+    }
+
+    if (freed) {
+        if (locked) MEMPOOL_LOCK_STAT(pool, lock);
+        freelist_push_chain(pool, first, last, freed);
+        if (locked) MEMPOOL_UNLOCK(lock);
+    }
+    return freed;
+}
+
+static bool mempool_freelist_free(mempool_t *pool, uint8_t *ptr)
+{
+    size_t block_idx = (size_t)(ptr - pool->memory_area) / pool->block_size;
+    if (!freelist_release(pool, block_idx)) {
+        return false;
+    }
+
+#ifdef MEMPOOL_LOCK_INIT
+    MEMPOOL_LOCK_TYPE *lock = &pool->lock;
+#else
+    MEMPOOL_LOCK_TYPE lock;
+#endif
+    bool locked = !(pool->flags & MEMPOOL_FLAG_LOCKFREE);
+
+    if (locked) MEMPOOL_LOCK_STAT(pool, lock);
+    freelist_push_chain(pool, (uint32_t)block_idx, (uint32_t)block_idx, 1);
+    if (locked) MEMPOOL_UNLOCK(lock);
+    return true;
+}
+
+// 从位图分配内存块
+static uint8_t *mempool_alloc_bitmap(mempool_t *pool, bool for_hw)
+{
+    if (pool->flags & MEMPOOL_FLAG_FREELIST) {
+        return mempool_freelist_alloc(pool, for_hw);
+    }
+    if (pool->placement != MEMPOOL_PLACEMENT_FIRST_FIT) {
+        return mempool_alloc_placed(pool, for_hw);
+    }
+
+    if (pool->flags & MEMPOOL_FLAG_LOCKFREE) {
+        return mempool_alloc_lockfree(pool, for_hw);
+    }
+
+#ifdef MEMPOOL_LOCK_INIT
+    MEMPOOL_LOCK_TYPE *lock = &pool->lock;
+#else
+    MEMPOOL_LOCK_TYPE lock;
+#endif
+
+    DEBUG_PRINT("Allocating block (for_hw=%d)", for_hw);
+
+    MEMPOOL_LOCK_STAT(pool, lock);
+
+    long word = bitmap_find_word_locked(pool);
+    if (word < 0)
+    {
+        MEMPOOL_UNLOCK(lock);
+        DEBUG_PRINT("No free blocks available");
+        return NULL; // 无可用块
+    }
+
+    // 标记块为已分配
+    int bit_pos = find_first_set_bit(pool->free_bitmap[word]);
+    BITMAP_TYPE mask = (BITMAP_TYPE)1 << bit_pos;
+    bitmap_take_locked(pool, word, mask);
+    if (for_hw)
+    {
+        BITMAP_SET_LOCKED(&pool->hw_owned_bitmap[word], mask);
+    }
+
+    // 返回内存块地址
+    size_t block_idx = (size_t)word * MEMPOOL_BITMAP_EACH_NUM + bit_pos;
+    uint8_t *block = pool->memory_area + block_idx * pool->block_size;
+    MEMPOOL_UNLOCK(lock);
+
+    DEBUG_PRINT("Found free block at index %zu (bitmap %ld, bit %d)", block_idx, word, bit_pos);
+
+    return block;
+}
+
+// 无锁释放: 先清硬件标记再置空闲位, 避免清掉块被重新分配后的硬件标记; 块已空闲时返回false
+static bool mempool_free_lockfree(mempool_t *pool, size_t block_idx)
+{
+    size_t word_idx = BITMAP_WORD_OF(block_idx);
+    BITMAP_TYPE mask = BITMAP_MASK_OF(block_idx);
+
+    // 验证状态
+    if (MEMPOOL_ATOMIC_LOAD(&pool->free_bitmap[word_idx]) & mask) {
+        DEBUG_PRINT("Block %zu already free", block_idx);
+        return false; // 已经是空闲状态
+    }
+
+    // 清除硬件占用标记(如果存在)
+    if (MEMPOOL_ATOMIC_LOAD(&pool->hw_owned_bitmap[word_idx]) & mask) {
+        mempool_stats_hw_free(pool, MEMPOOL_ATOMIC_FETCH_AND(&pool->hw_owned_bitmap[word_idx], ~mask) & mask);
+    }
+
+    // 标记为空闲
+    if (bitmap_give_lockfree(pool, word_idx, mask) & mask) {
+        DEBUG_PRINT("Block %zu freed concurrently", block_idx);
+        return false;
+    }
+    mempool_placement_freed(pool, block_idx);
+    return true;
+}
+
+// 将内存块归还位图(调用者已校验指针范围), 块已空闲(重复释放)时返回false
+static bool mempool_free_bitmap(mempool_t *pool, uint8_t *ptr)
+{
+    if (pool->flags & MEMPOOL_FLAG_FREELIST) {
+        return mempool_freelist_free(pool, ptr);
+    }
+    if (pool->flags & MEMPOOL_FLAG_LOCKFREE) {
+        return mempool_free_lockfree(pool, (size_t)(ptr - pool->memory_area) / pool->block_size);
+    }
+    
+#ifdef MEMPOOL_LOCK_INIT
+    MEMPOOL_LOCK_TYPE *lock = &pool->lock;
+#else
+    MEMPOOL_LOCK_TYPE lock;
+#endif
+
+    MEMPOOL_LOCK_STAT(pool, lock);
+    
+    // 计算块索引
+    size_t offset = ptr - pool->memory_area;
+    size_t block_idx = offset / pool->block_size;
+    
+    if (block_idx >= pool->block_count) {
+        MEMPOOL_UNLOCK(lock);
+        return false; // 非法指针
+    }
+    
+    // 计算位图位置
+    size_t word_idx = BITMAP_WORD_OF(block_idx);
+    BITMAP_TYPE mask = BITMAP_MASK_OF(block_idx);
+    
+    // 验证状态
+    if ((pool->free_bitmap[word_idx] & mask) != 0) {
+        MEMPOOL_UNLOCK(lock);
+        DEBUG_PRINT("Block already free at %p", ptr);
+        return false; // 已经是空闲状态
+    }
+    
+    // 清除硬件占用标记(如果存在)
+    if (pool->hw_owned_bitmap[word_idx] & mask) {
+        BITMAP_CLEAR_LOCKED(&pool->hw_owned_bitmap[word_idx], mask);
+        mempool_stats_hw_free(pool, mask);
+    }
+    
+    // 标记为空闲
+    bitmap_give_locked(pool, word_idx, mask);
+    mempool_placement_freed(pool, block_idx);
+    
+    MEMPOOL_UNLOCK(lock);
+    return true;
+}
+
+//===================================================================
+//  批量分配/释放(一次加锁, 按位图字整体操作)
+//===================================================================
+// 提取bitmap中最低的n个置位(n小于bitmap的置位数)
+static inline BITMAP_TYPE bitmap_lowest_bits(BITMAP_TYPE bitmap, size_t n)
+{
+#if defined(__BMI2__) && defined(__x86_64__)
+    if (sizeof(BITMAP_TYPE) == 8) {
+        return (BITMAP_TYPE)_pdep_u64((1ull << n) - 1, bitmap);
+    }
+#endif
+    BITMAP_TYPE rest = bitmap;
+    while (n--) {
+        rest &= rest - 1; // 清除最低置位
+    }
+    return bitmap & ~rest;
+}
+
+// 将一个叶子字中取走的块展开为块地址, 返回展开数量
+static inline size_t bitmap_emit_blocks(mempool_t *pool, size_t word, BITMAP_TYPE taken, uint8_t **out)
+{
+    uint8_t *base = pool->memory_area + word * MEMPOOL_BITMAP_EACH_NUM * pool->block_size;
+    size_t n = 0;
+
+    while (taken != 0) {
+        out[n++] = base + (size_t)find_first_set_bit(taken) * pool->block_size;
+        taken &= taken - 1;
+    }
+    return n;
+}
+
+// 无锁批量分配: 每个叶子字一次CAS取走所需的全部块
+static size_t mempool_alloc_batch_lockfree(mempool_t *pool, uint8_t **bufs, size_t n, bool for_hw)
+{
+    size_t got = 0;
+
+    for (size_t s = bitmap_next_summary(pool, 0); s < pool->summary_words && got < n;
+         s = bitmap_next_summary(pool, s + 1))
+    {
+        BITMAP_TYPE summary = MEMPOOL_ATOMIC_LOAD(&pool->free_summary[s]);
+
+        while (summary != 0 && got < n)
+        {
+            size_t word = s * MEMPOOL_BITMAP_EACH_NUM + find_first_set_bit(summary);
+            BITMAP_TYPE bitmap = MEMPOOL_ATOMIC_LOAD(&pool->free_bitmap[word]);
+            BITMAP_TYPE taken = 0;
+
+            while (bitmap != 0)
+            {
+                size_t need = n - got;
+                taken = ((size_t)POPCOUNT_LL(bitmap) <= need) ? bitmap : bitmap_lowest_bits(bitmap, need);
+                if (MEMPOOL_ATOMIC_CAS(&pool->free_bitmap[word], &bitmap, bitmap & ~taken))
+                    break;
+                taken = 0; // bitmap已被CAS更新为最新值
+            }
+
+            if (taken != 0)
+            {
+                if ((bitmap & ~taken) == 0)
+                {
+                    summary_clear_lockfree(pool, word);
+                }
+                if (for_hw)
+                {
+                    MEMPOOL_ATOMIC_FETCH_OR(&pool->hw_owned_bitmap[word], taken);
+                }
+                got += bitmap_emit_blocks(pool, word, taken, &bufs[got]);
+            }
+
+            summary &= summary - 1;
+        }
+    }
+
+    return got;
+}
+
+// 从现有空闲块中批量分配
+static size_t mempool_alloc_batch_bitmap(mempool_t *pool, uint8_t **bufs, size_t n, bool for_hw)
+{
+    DEBUG_PRINT("Allocating batch of %zu blocks (for_hw=%d)", n, for_hw);
+
+    if (pool->flags & MEMPOOL_FLAG_FREELIST) {
+        return mempool_freelist_alloc_batch(pool, bufs, n, for_hw);
+    }
+    if (pool->flags & MEMPOOL_FLAG_LOCKFREE) {
+        return mempool_alloc_batch_lockfree(pool, bufs, n, for_hw);
+    }
+
+#ifdef MEMPOOL_LOCK_INIT
+    MEMPOOL_LOCK_TYPE *lock = &pool->lock;
+#else
+    MEMPOOL_LOCK_TYPE lock;
+#endif
+
+    size_t got = 0;
+    long word;
+
+    MEMPOOL_LOCK_STAT(pool, lock);
+
+    while (got < n && (word = bitmap_find_word_locked(pool)) >= 0)
+    {
+        BITMAP_TYPE bitmap = pool->free_bitmap[word];
+        size_t need = n - got;
+
+        // 空闲块不超过所需数量时整字取走, 否则只取最低的need个
+        BITMAP_TYPE taken = ((size_t)POPCOUNT_LL(bitmap) <= need) ? bitmap : bitmap_lowest_bits(bitmap, need);
+        bitmap_take_locked(pool, word, taken);
+        if (for_hw)
+        {
+            BITMAP_SET_LOCKED(&pool->hw_owned_bitmap[word], taken);
+        }
+        got += bitmap_emit_blocks(pool, word, taken, &bufs[got]);
+    }
+
+    MEMPOOL_UNLOCK(lock);
+
+    DEBUG_PRINT("Allocated %zu of %zu blocks", got, n);
+    return got;
+}
+
+// 批量分配(弹性池空闲块不足时先尝试扩展), 不计入统计(线程缓存补充也使用)
+static size_t mempool_alloc_batch_grow(mempool_t *pool, uint8_t **bufs, size_t n, bool for_hw)
+{
+    if (!(pool->flags & MEMPOOL_FLAG_ELASTIC)) {
+        return mempool_alloc_batch_bitmap(pool, bufs, n, for_hw);
+    }
+
+    size_t got = 0;
+    for (;;) {
+        size_t generation = MEMPOOL_ATOMIC_LOAD(&pool->slab_generation);
+        got += mempool_alloc_batch_bitmap(pool, &bufs[got], n - got, for_hw);
+        if (got == n || mempool_slab_grow(pool, generation) != 0) {
+            return got;
+        }
+    }
+}
+
+// 批量分配内存块, 返回实际分配数量(池中空闲块不足时少于n, 弹性池先尝试扩展)
+size_t mempool_alloc_batch(mempool_t *pool, uint8_t **bufs, size_t n, bool for_hw)
+{
+    if (!pool || !bufs || n == 0) return 0;
+
+    size_t got = mempool_alloc_batch_grow(pool, bufs, n, for_hw);
+    mempool_stats_alloc(pool, got, n, for_hw);
+    return got;
+}
+
+// 位区间[first, first + n)落在第word个叶子字中的掩码
+static inline BITMAP_TYPE bitmap_range_mask(size_t word, size_t first, size_t n)
+{
+    size_t lo = word * MEMPOOL_BITMAP_EACH_NUM;
+    size_t from = first > lo ? first - lo : 0;
+    size_t to = first + n - lo < MEMPOOL_BITMAP_EACH_NUM ? first + n - lo : MEMPOOL_BITMAP_EACH_NUM;
+    BITMAP_TYPE high = to == MEMPOOL_BITMAP_EACH_NUM ? (BITMAP_TYPE)-1 : ((BITMAP_TYPE)1 << to) - 1;
+    return high & ~(((BITMAP_TYPE)1 << from) - 1);
+}
+
+// 无锁连续分配的最大重试次数(区间被并发分配走时重新查找)
+#define MEMPOOL_CONTIGUOUS_RETRIES 8
+
+// 从位图取走n个地址连续的空闲块, 返回起始块下标, 不存在时返回-1
+static long mempool_alloc_run_bitmap(mempool_t *pool, size_t n, bool for_hw)
+{
+    size_t nbits = pool->bitmap_words * MEMPOOL_BITMAP_EACH_NUM;
+
+    if (!(pool->flags & MEMPOOL_FLAG_LOCKFREE)) {
+#ifdef MEMPOOL_LOCK_INIT
+        MEMPOOL_LOCK_TYPE *lock = &pool->lock;
+#else
+        MEMPOOL_LOCK_TYPE lock;
+#endif
+        MEMPOOL_LOCK_STAT(pool, lock);
+        long first = mempool_bitmap_find_run(pool->free_bitmap, nbits, n);
+        if (first >= 0) {
+            for (size_t w = BITMAP_WORD_OF(first); w <= BITMAP_WORD_OF(first + n - 1); w++) {
+                BITMAP_TYPE mask = bitmap_range_mask(w, (size_t)first, n);
+                bitmap_take_locked(pool, w, mask);
+                if (for_hw) {
+                    BITMAP_SET_LOCKED(&pool->hw_owned_bitmap[w], mask);
+                }
+            }
+        }
+        MEMPOOL_UNLOCK(lock);
+        return first;
+    }
+
+    // 无锁模式: 逐字CAS取走区间, 某个字已被并发取走时归还已取的字后重新查找
+    for (int retry = 0; retry < MEMPOOL_CONTIGUOUS_RETRIES; retry++) {
+        long first = mempool_bitmap_find_run(pool->free_bitmap, nbits, n);
+        if (first < 0) {
+            return -1;
+        }
+
+        size_t w_first = BITMAP_WORD_OF(first);
+        size_t w_last = BITMAP_WORD_OF(first + n - 1);
+        size_t w = w_first;
+        for (; w <= w_last; w++) {
+            BITMAP_TYPE mask = bitmap_range_mask(w, (size_t)first, n);
+            BITMAP_TYPE bitmap = MEMPOOL_ATOMIC_LOAD(&pool->free_bitmap[w]);
+            while ((bitmap & mask) == mask &&
+                   !MEMPOOL_ATOMIC_CAS(&pool->free_bitmap[w], &bitmap, bitmap & ~mask)) {
+            }
+            if ((bitmap & mask) != mask) {
+                break;
+            }
+            if ((bitmap & ~mask) == 0) {
+                summary_clear_lockfree(pool, w);
+            }
+        }
+
+        if (w > w_last) {
+            if (for_hw) {
+                for (w = w_first; w <= w_last; w++) {
+                    MEMPOOL_ATOMIC_FETCH_OR(&pool->hw_owned_bitmap[w], bitmap_range_mask(w, (size_t)first, n));
+                }
+            }
+            return first;
+        }
+
+        while (w-- > w_first) {
+            bitmap_give_lockfree(pool, w, bitmap_range_mask(w, (size_t)first, n));
+        }
+    }
+
+    return -1;
+}
+
+// 分配n个地址连续的块, 返回第一个块的地址; 各块仍需分别释放
+uint8_t *mempool_alloc_contiguous(mempool_t *pool, size_t n, bool for_hw)
+{
+    if (!pool || n == 0) return NULL;
+    if (pool->flags & MEMPOOL_FLAG_FREELIST) {
+        ERROR_PRINT("Free-list engine does not support contiguous allocation");
+        return NULL;
+    }
+
+    long first;
+    for (;;) {
+        size_t generation = MEMPOOL_ATOMIC_LOAD(&pool->slab_generation);
+        first = mempool_alloc_run_bitmap(pool, n, for_hw);
+        if (first >= 0 || !(pool->flags & MEMPOOL_FLAG_ELASTIC) || mempool_slab_grow(pool, generation) != 0) {
+            break;
+        }
+    }
+
+    mempool_stats_alloc(pool, first >= 0 ? n : 0, n, for_hw);
+    if (first < 0) {
+        DEBUG_PRINT("No run of %zu free blocks available", n);
+        return NULL;
+    }
+    return pool->memory_area + (size_t)first * pool->block_size;
+}
+
+// 释放一个引用, 返回true表示这是最后一个引用(块应归还位图).
+// 计数为0时调用者是唯一持有者, 不会有并发的mempool_ref, 无需原子修改;
+// 多个持有者同时释放时, 把计数从0减到下溢的一方为最后一个, 由它恢复为0
+static inline bool mempool_ref_drop(mempool_t *pool, size_t block_idx)
+{
+    if (!pool->refcount || MEMPOOL_ATOMIC_LOAD(&pool->refcount[block_idx]) == 0) {
+        return true;
+    }
+    if (MEMPOOL_ATOMIC_FETCH_ADD(&pool->refcount[block_idx], (uint32_t)-1) != 0) {
+        return false;
+    }
+    MEMPOOL_ATOMIC_STORE(&pool->refcount[block_idx], 0);
+    return true;
+}
+
+// 将同一叶子字中待释放的块一次性还回位图, 返回实际由已分配变为空闲的块数(已空闲的块跳过)
+static size_t mempool_free_word(mempool_t *pool, size_t word, BITMAP_TYPE mask)
+{
+    if (pool->flags & MEMPOOL_FLAG_LOCKFREE) {
+        // 跳过已空闲的块
+        mask &= ~MEMPOOL_ATOMIC_LOAD(&pool->free_bitmap[word]);
+        if (mask == 0) return 0;
+
+        if (MEMPOOL_ATOMIC_LOAD(&pool->hw_owned_bitmap[word]) & mask) {
+            mempool_stats_hw_free(pool, MEMPOOL_ATOMIC_FETCH_AND(&pool->hw_owned_bitmap[word], ~mask) & mask);
+        }
+        // 与并发释放交错时只计入本次置位的块
+        return (size_t)POPCOUNT_LL(mask & ~bitmap_give_lockfree(pool, word, mask));
+    }
+
+    mask &= ~pool->free_bitmap[word];
+    if (mask == 0) return 0;
+
+    mempool_stats_hw_free(pool, pool->hw_owned_bitmap[word] & mask);
+    BITMAP_CLEAR_LOCKED(&pool->hw_owned_bitmap[word], mask);
+    bitmap_give_locked(pool, word, mask);
+    return (size_t)POPCOUNT_LL(mask);
+}
+
+// 批量归还位图, 返回归还的块数; drop_ref为false时不处理引用计数(线程缓存中的块已释放过引用)
+static size_t mempool_free_batch_blocks(mempool_t *pool, uint8_t **bufs, size_t n, bool drop_ref)
+{
+    DEBUG_PRINT("Freeing batch of %zu blocks", n);
+
+    if (pool->flags & MEMPOOL_FLAG_FREELIST) {
+        size_t freed = mempool_freelist_free_batch(pool, bufs, n);
+        mempool_wait_wake(pool->wait);
+        return freed;
+    }
+
+#ifdef MEMPOOL_LOCK_INIT
+    MEMPOOL_LOCK_TYPE *lock = &pool->lock;
+#else
+    MEMPOOL_LOCK_TYPE lock;
+#endif
+
+    bool locked = !(pool->flags & MEMPOOL_FLAG_LOCKFREE);
+    size_t cur_word = 0;
+    BITMAP_TYPE cur_mask = 0;
+    size_t freed = 0;
+
+    if (locked) MEMPOOL_LOCK_STAT(pool, lock);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        uint8_t *ptr = bufs[i];
+        if (!ptr) continue;
+
+        if (ptr < pool->memory_area || ptr >= pool->memory_area + pool->block_size * pool->block_count) {
+            ERROR_PRINT("Invalid pointer %p (outside pool range)", ptr);
+            continue;
+        }
+
+        size_t block_idx = (size_t)(ptr - pool->memory_area) / pool->block_size;
+        if (!mempool_slab_valid(pool, block_idx)) {
+            ERROR_PRINT("Invalid pointer %p (slab released)", ptr);
+            continue;
+        }
+        if (mempool_magazine_cached(pool, block_idx)) continue;
+        if (drop_ref && !mempool_ref_drop(pool, block_idx)) continue;
+        size_t word = BITMAP_WORD_OF(block_idx);
+
+        if (cur_mask != 0 && word != cur_word) {
+            freed += mempool_free_word(pool, cur_word, cur_mask);
+            cur_mask = 0;
+        }
+        cur_word = word;
+        cur_mask |= BITMAP_MASK_OF(block_idx);
+    }
+
+    if (cur_mask != 0) {
+        freed += mempool_free_word(pool, cur_word, cur_mask);
+    }
+
+    if (locked) MEMPOOL_UNLOCK(lock);
+
+    mempool_wait_wake(pool->wait);
+    return freed;
+}
+
+// 批量释放内存块, 落在同一位图字中的相邻块合并为一次位操作
+void mempool_free_batch(mempool_t *pool, uint8_t **bufs, size_t n)
+{
+    if (!pool || !bufs || n == 0) return;
+
+    mempool_stats_free(pool, mempool_free_batch_blocks(pool, bufs, n, true));
+}
+
+//===================================================================
+//  每线程块缓存(magazine)
+//  缓存中的块在位图中仍为已分配, 另以magazine_cached逐块标记, 用于拒绝重复释放.
+//  标记只由块的当前持有者读写(宽松原子读写, 无需原子读改写);
+//  两个线程同时重复释放同一块属于调用者的数据竞争, 不保证能检测到
+//===================================================================
+// 把缓存中的块归还位图, 先清除缓存标记(归还后块可能立即被其他线程分配并放入它的缓存)
+static void mempool_magazine_release(mempool_t *pool, uint8_t **blocks, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        size_t block_idx = (size_t)(blocks[i] - pool->memory_area) / pool->block_size;
+        MEMPOOL_ATOMIC_STORE_RELAXED(&pool->magazine_cached[block_idx], 0);
+    }
+    mempool_free_batch_blocks(pool, blocks, n, false);
+}
+
+// 线程退出时的TLS析构: 归还缓存块并从池链表中摘除
+static void mempool_magazine_destructor(void *arg)
+{
+    struct mempool_magazine *mag = (struct mempool_magazine *)arg;
+    mempool_t *pool = mag->pool;
+
+    if (mag->count) {
+        mempool_magazine_release(pool, mag->blocks, mag->count);
+        MEMPOOL_ATOMIC_STORE_RELAXED(&mag->count, 0);
+    }
+
+#ifdef MEMPOOL_LOCK_INIT
+    MEMPOOL_LOCK_TYPE *lock = &pool->lock;
+#else
+    MEMPOOL_LOCK_TYPE lock;
+#endif
+
+    MEMPOOL_LOCK(lock);
+    for (struct mempool_magazine **pp = &pool->magazines; *pp; pp = &(*pp)->next) {
+        if (*pp == mag) {
+            *pp = mag->next;
+            break;
+        }
+    }
+    MEMPOOL_UNLOCK(lock);
+
+    MEMPOOL_FREE(mag);
+}
+
+// 获取当前线程的缓存, 首次使用时创建并登记到池链表
+static struct mempool_magazine *mempool_magazine_get(mempool_t *pool)
+{
+    struct mempool_magazine *mag = MEMPOOL_TLS_GET(pool->magazine_key);
+    if (mag) return mag;
+
+    mag = MEMPOOL_MALLOC(sizeof(*mag) + sizeof(uint8_t *) * pool->magazine_size);
+    if (!mag) {
+        ERROR_PRINT("Failed to allocate magazine");
+        return NULL;
+    }
+    mag->pool = pool;
+    mag->count = 0;
+
+#ifdef MEMPOOL_LOCK_INIT
+    MEMPOOL_LOCK_TYPE *lock = &pool->lock;
+#else
+    MEMPOOL_LOCK_TYPE lock;
+#endif
+
+    MEMPOOL_LOCK(lock);
+    mag->next = pool->magazines;
+    pool->magazines = mag;
+    MEMPOOL_UNLOCK(lock);
+
+    MEMPOOL_TLS_SET(pool->magazine_key, mag);
+    return mag;
+}
+
+// 启用每线程缓存, 需在多线程使用该池之前调用
+int mempool_magazine_enable(mempool_t *pool, size_t magazine_size)
+{
+    if (!pool || magazine_size < 2 || pool->magazine_size) {
+        return -1;
+    }
+
+    pool->magazine_cached = MEMPOOL_MALLOC(pool->block_count);
+    if (!pool->magazine_cached) {
+        ERROR_PRINT("Failed to allocate magazine markers");
+        return -1;
+    }
+    memset(pool->magazine_cached, 0, pool->block_count);
+
+    if (MEMPOOL_TLS_KEY_CREATE(&pool->magazine_key, mempool_magazine_destructor) != 0) {
+        ERROR_PRINT("Failed to create magazine TLS key");
+        MEMPOOL_FREE(pool->magazine_cached);
+        pool->magazine_cached = NULL;
+        return -1;
+    }
+
+    pool->magazine_size = magazine_size;
+    DEBUG_PRINT("Magazine enabled for pool %p (size=%zu)", pool, magazine_size);
+    return 0;
+}
+
+// 统计各线程缓存中的空闲块(调用者持有池锁; 计数由各线程以宽松原子写入独立更新, 结果为近似快照)
+static size_t mempool_magazine_count_locked(mempool_t *pool)
+{
+    size_t count = 0;
+
+    for (struct mempool_magazine *mag = pool->magazines; mag; mag = mag->next) {
+        count += MEMPOOL_ATOMIC_LOAD_RELAXED(&mag->count);
+    }
+    return count;
+}
+
+// 将当前线程缓存的所有块归还位图
+void mempool_magazine_flush(mempool_t *pool)
+{
+    if (!pool || !pool->magazine_size) return;
+
+    struct mempool_magazine *mag = MEMPOOL_TLS_GET(pool->magazine_key);
+    if (!mag || !mag->count) return;
+
+    mempool_magazine_release(pool, mag->blocks, mag->count);
+    MEMPOOL_ATOMIC_STORE_RELAXED(&mag->count, 0);
+}
+
+// 分配一个块(线程缓存 -> 位图 -> 弹性扩展)
+static uint8_t *mempool_alloc_block(mempool_t *pool, bool for_hw)
+{
+    // 硬件块需要更新hw_owned_bitmap, 不经过线程缓存
+    if (pool->magazine_size && !for_hw) {
+        struct mempool_magazine *mag = mempool_magazine_get(pool);
+        if (mag) {
+            // 缓存为空时批量补充一半容量
+            // 计数只由本线程修改, 其他线程(mempool_available)只读
+            size_t count = mag->count;
+            if (count == 0) {
+                count = mempool_alloc_batch_grow(pool, mag->blocks, pool->magazine_size / 2, false);
+                if (count == 0) return NULL;
+            }
+            uint8_t *block = mag->blocks[--count];
+            MEMPOOL_ATOMIC_STORE_RELAXED(&mag->count, count);
+            MEMPOOL_ATOMIC_STORE_RELAXED(&pool->magazine_cached[(size_t)(block - pool->memory_area) / pool->block_size], 0);
+            return block;
+        }
+    }
+
+    if (!(pool->flags & MEMPOOL_FLAG_ELASTIC)) {
+        return mempool_alloc_bitmap(pool, for_hw);
+    }
+
+    // 弹性池空闲块耗尽时扩展一个slab后重试
+    for (;;) {
+        size_t generation = MEMPOOL_ATOMIC_LOAD(&pool->slab_generation);
+        uint8_t *block = mempool_alloc_bitmap(pool, for_hw);
+        if (block || mempool_slab_grow(pool, generation) != 0) {
+            return block;
+        }
+    }
+}
+
+// 分配内存块
+uint8_t *mempool_alloc(mempool_t *pool, bool for_hw)
+{
+    MEMPOOL_ASSERT(pool != NULL);
+
+    MEMPOOL_HIST_BEGIN(start);
+    uint8_t *block = mempool_alloc_block(pool, for_hw);
+    mempool_stats_alloc(pool, block != NULL, 1, for_hw);
+    MEMPOOL_HIST_END(MEMPOOL_HIST_ALLOC, start);
+    return block;
+}
+
+struct mempool_alloc_ctx {
+    mempool_t *pool;
+    bool for_hw;
+};
+
+// 等待中的重试不计统计, 由mempool_alloc_timed按整次调用记录一次
+static void *mempool_try_alloc(void *arg)
+{
+    struct mempool_alloc_ctx *ctx = (struct mempool_alloc_ctx *)arg;
+    return mempool_alloc_block(ctx->pool, ctx->for_hw);
+}
+
+// 阻塞分配内存块, 池耗尽时等待其他线程(或共享池的其他进程)释放
+uint8_t *mempool_alloc_timed(mempool_t *pool, bool for_hw, uint64_t timeout_ns)
+{
+    MEMPOOL_ASSERT(pool != NULL);
+
+    MEMPOOL_HIST_BEGIN(start);
+    uint8_t *block = mempool_alloc_block(pool, for_hw);
+    if (!block && timeout_ns != 0) {
+        struct mempool_alloc_ctx ctx = { pool, for_hw };
+        block = mempool_wait_until(pool->wait, timeout_ns, false, mempool_try_alloc, &ctx);
+    }
+    // 只有超时仍未分配到才计一次失败
+    mempool_stats_alloc(pool, block != NULL, 1, for_hw);
+    MEMPOOL_HIST_END(MEMPOOL_HIST_ALLOC, start);
+    return block;
+}
+
+static void mempool_free_block(mempool_t *pool, uint8_t *ptr)
+{
+    if (!pool || !ptr) return;
+
+    if (ptr < pool->memory_area || ptr >= pool->memory_area + pool->block_size * pool->block_count) {
+        ERROR_PRINT("Invalid pointer %p (outside pool range)", ptr);
+        return;
+    }
+
+    size_t block_idx = (size_t)(ptr - pool->memory_area) / pool->block_size;
+    if (!mempool_slab_valid(pool, block_idx)) {
+        ERROR_PRINT("Invalid pointer %p (slab released)", ptr);
+        return;
+    }
+    if (mempool_magazine_cached(pool, block_idx) || !mempool_ref_drop(pool, block_idx)) {
+        return;
+    }
+
+    if (pool->magazine_size) {
+        size_t word_idx = BITMAP_WORD_OF(block_idx);
+        BITMAP_TYPE mask = BITMAP_MASK_OF(block_idx);
+
+        // 硬件块需清除标记, 已空闲块直接忽略, 均交给位图路径处理;
+        // 有阻塞分配的等待者时也直接归还位图并唤醒, 避免块停留在本线程缓存中
+        if (!(MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->hw_owned_bitmap[word_idx]) & mask) &&
+            !(MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->free_bitmap[word_idx]) & mask) &&
+            MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->wait->waiters) == 0) {
+            struct mempool_magazine *mag = mempool_magazine_get(pool);
+            if (mag) {
+                size_t count = mag->count;
+                // 缓存已满时批量归还一半
+                if (count == pool->magazine_size) {
+                    size_t half = pool->magazine_size / 2;
+                    count -= half;
+                    MEMPOOL_ATOMIC_STORE_RELAXED(&mag->count, count);
+                    mempool_magazine_release(pool, &mag->blocks[count], half);
+                }
+                MEMPOOL_ATOMIC_STORE_RELAXED(&pool->magazine_cached[block_idx], 1);
+                mag->blocks[count] = ptr;
+                MEMPOOL_ATOMIC_STORE_RELAXED(&mag->count, count + 1);
+                mempool_stats_free(pool, 1);
+                return;
+            }
+        }
+    }
+
+    // 重复释放被位图忽略, 不计入释放统计
+    if (mempool_free_bitmap(pool, ptr)) {
+        mempool_stats_free(pool, 1);
+        mempool_wait_wake(pool->wait);
+    }
+}
+
+// 释放内存块
+void mempool_free(mempool_t *pool, uint8_t *ptr)
+{
+    DEBUG_PRINT("Freeing block at %p", ptr);
+
+    MEMPOOL_HIST_BEGIN(start);
+    mempool_free_block(pool, ptr);
+    MEMPOOL_HIST_END(MEMPOOL_HIST_FREE, start);
+}
+
+// 块指针对应的块索引, 非法指针或未启用引用计数时返回-1
+static long mempool_ref_index(mempool_t *pool, uint8_t *ptr)
+{
+    if (!pool || !pool->refcount || !ptr || ptr < pool->memory_area ||
+        ptr >= pool->memory_area + pool->block_size * pool->block_count) {
+        return -1;
+    }
+
+    size_t block_idx = (size_t)(ptr - pool->memory_area) / pool->block_size;
+    if (!mempool_slab_valid(pool, block_idx)) {
+        return -1;
+    }
+    return (long)block_idx;
+}
+
+// 块已释放: 位图中空闲, 或已释放进某个线程缓存(此时位图仍显示为已分配)
+static bool mempool_ref_released(mempool_t *pool, size_t block_idx)
+{
+    if (MEMPOOL_ATOMIC_LOAD(&pool->free_bitmap[BITMAP_WORD_OF(block_idx)]) & BITMAP_MASK_OF(block_idx)) {
+        return true;
+    }
+    return pool->magazine_cached && MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->magazine_cached[block_idx]);
+}
+
+// 增加一个引用(调用者必须已持有该块的一个引用)
+int mempool_ref(mempool_t *pool, uint8_t *ptr)
+{
+    long idx = mempool_ref_index(pool, ptr);
+    if (idx < 0) {
+        ERROR_PRINT("Invalid pointer %p for refcounted pool %p", ptr, pool);
+        return -1;
+    }
+    if (mempool_ref_released(pool, (size_t)idx)) {
+        ERROR_PRINT("Cannot reference free block %p", ptr);
+        return -1;
+    }
+
+    MEMPOOL_ATOMIC_FETCH_ADD(&pool->refcount[idx], 1);
+    return 0;
+}
+
+// 释放一个引用
+void mempool_unref(mempool_t *pool, uint8_t *ptr)
+{
+    mempool_free(pool, ptr);
+}
+
+// 当前引用数(空闲块为0)
+uint32_t mempool_refcount(mempool_t *pool, uint8_t *ptr)
+{
+    long idx = mempool_ref_index(pool, ptr);
+    if (idx < 0 || mempool_ref_released(pool, (size_t)idx)) {
+        return 0;
+    }
+    return MEMPOOL_ATOMIC_LOAD(&pool->refcount[idx]) + 1;
+}
+
+// 统计快照: 汇总各分片, 不加锁
+int mempool_get_stats(mempool_t *pool, mempool_stats_t *stats)
+{
+#if MEMPOOL_STATS_EN
+    if (!pool || !stats) return -1;
+
+    long in_use = MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->stats_in_use);
+    size_t hw_allocs = 0, hw_frees = 0;
+
+    memset(stats, 0, sizeof(*stats));
+    for (size_t i = 0; i < MEMPOOL_STATS_SHARDS; i++) {
+        struct mempool_stats_shard *shard = &pool->stats[i];
+        stats->allocs += MEMPOOL_ATOMIC_LOAD_RELAXED(&shard->allocs);
+        stats->frees += MEMPOOL_ATOMIC_LOAD_RELAXED(&shard->frees);
+        stats->alloc_failures += MEMPOOL_ATOMIC_LOAD_RELAXED(&shard->alloc_failures);
+        stats->lock_contended += MEMPOOL_ATOMIC_LOAD_RELAXED(&shard->lock_contended);
+        hw_allocs += MEMPOOL_ATOMIC_LOAD_RELAXED(&shard->hw_allocs);
+        hw_frees += MEMPOOL_ATOMIC_LOAD_RELAXED(&shard->hw_frees);
+        in_use += MEMPOOL_ATOMIC_LOAD_RELAXED(&shard->usage_delta);
     }
-    
-    // 标记为空闲
-    pool->free_bitmap[word_idx] |= ((BITMAP_TYPE)1 << bit_pos);
-    
-    MEMPOOL_UNLOCK(lock);
+
+    // 各分片并发更新时汇总值可能暂时为负
+    stats->in_use = in_use > 0 ? (size_t)in_use : 0;
+    stats->hw_owned = hw_allocs > hw_frees ? hw_allocs - hw_frees : 0;
+    mempool_stats_peak(&pool->stats_peak, in_use);
+    stats->peak_in_use = MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->stats_peak);
+    return 0;
+#else
+    (void)pool;
+    (void)stats;
+    return -1;
+#endif
 }
 
 // 获取可用块数量
@@ -236,19 +2253,30 @@ size_t mempool_available(mempool_t *pool)
 {
     if (!pool) return 0;
     
+    size_t count = 0;
+
 #ifdef MEMPOOL_LOCK_INIT
     MEMPOOL_LOCK_TYPE *lock = &pool->lock;
 #else
     MEMPOOL_LOCK_TYPE lock;
 #endif
 
-    MEMPOOL_LOCK(lock);
-    
-    size_t count = 0;
-    for (int i = 0; i < BITMAP_WORDS; i++) {
-        DEBUG_PRINT("Free bitmap is 0x%lx", pool->free_bitmap[i]);
-        count += POPCOUNT_LL(pool->free_bitmap[i]);
+    // 无锁模式下不加锁读取, 结果为近似快照
+    if (pool->flags & MEMPOOL_FLAG_LOCKFREE) {
+        count = (pool->flags & MEMPOOL_FLAG_FREELIST) ? FREELIST_COUNT(MEMPOOL_ATOMIC_LOAD_RELAXED(&pool->freelist_head)) :
+                mempool_bitmap_popcount(pool->free_bitmap, pool->bitmap_words);
+        if (pool->magazine_size) {
+            MEMPOOL_LOCK(lock);
+            count += mempool_magazine_count_locked(pool);
+            MEMPOOL_UNLOCK(lock);
+        }
+        return count;
     }
+
+    MEMPOOL_LOCK(lock);
+    count = (pool->flags & MEMPOOL_FLAG_FREELIST) ? FREELIST_COUNT(pool->freelist_head) :
+            mempool_bitmap_popcount(pool->free_bitmap, pool->bitmap_words);
+    count += mempool_magazine_count_locked(pool);
     
     MEMPOOL_UNLOCK(lock);
     return count;
@@ -258,7 +2286,17 @@ size_t mempool_available(mempool_t *pool)
 size_t mempool_used(mempool_t *pool)
 {
     if (!pool) return 0;
-    return pool->block_count - mempool_available(pool);
+    return mempool_capacity(pool) - mempool_available(pool);
+}
+
+// 获取当前总块数(弹性池只计已提交的slab)
+size_t mempool_capacity(mempool_t *pool)
+{
+    if (!pool) return 0;
+    if (pool->flags & MEMPOOL_FLAG_ELASTIC) {
+        return MEMPOOL_ATOMIC_LOAD(&pool->slab_committed) * pool->slab_blocks;
+    }
+    return pool->block_count;
 }
 
 size_t mempool_block_size(mempool_t *pool)
@@ -280,33 +2318,58 @@ static int get_block_index(mempool_t *pool, uint8_t *buffer)
     return (int)(offset / pool->block_size);
 }
 
+// 无锁环形队列的头尾计数(单调递增, 槽位下标为计数&mask),
+// 生产者侧与消费者侧各占一个缓存行, 避免伪共享
+struct mempool_ring {
+    size_t tail;                    // 生产者写入计数
+    size_t head_cache;              // 生产者缓存的消费计数(减少跨核读取)
+    uint8_t pad0[MEMPOOL_ALIGNMENT - 2 * sizeof(size_t)];
+    size_t head;                    // 消费者读取计数
+    size_t tail_cache;              // 消费者缓存的写入计数
+    uint8_t pad1[MEMPOOL_ALIGNMENT - 2 * sizeof(size_t)];
+    size_t mask;                    // 槽位数-1(槽位数为2的幂)
+    size_t *sequences;              // MPMC模式每槽位序号(SPSC模式为NULL)
+};
+
 // 创建队列
 mempool_queue_t *mempool_queue_create(mempool_t *pool, size_t capacity)
 {
-    DEBUG_PRINT("Creating queue for pool %p with capacity %zu", pool, capacity);
+    return mempool_queue_create_mode(pool, capacity, MEMPOOL_QUEUE_LOCKED);
+}
+
+// 创建队列(指定队列模式)
+mempool_queue_t *mempool_queue_create_mode(mempool_t *pool, size_t capacity, uint32_t mode)
+{
+    DEBUG_PRINT("Creating queue for pool %p with capacity %zu (mode %u)", pool, capacity, mode);
 
-    if (!pool || capacity == 0 || capacity > pool->block_count) {
+    if (!pool || capacity == 0 || capacity > pool->block_count || mode > MEMPOOL_QUEUE_MPMC) {
         return NULL;
     }
+
+    // 无锁模式槽位数取2的幂, 容量上限仍为capacity
+    size_t slots = capacity;
+    if (mode != MEMPOOL_QUEUE_LOCKED) {
+        for (slots = 1; slots < capacity; slots <<= 1);
+    }
     
     mempool_queue_t *queue = MEMPOOL_MALLOC(sizeof(mempool_queue_t));
     if (!queue) {
         ERROR_PRINT("Failed to allocate queue structure");
         return NULL;
     }
+    memset(queue, 0, sizeof(mempool_queue_t));
     
-    queue->block_indices = MEMPOOL_MALLOC(sizeof(uint16_t) * capacity);
-    if (!queue->block_indices) {
-        ERROR_PRINT("Failed to allocate block indices array");
-        MEMPOOL_FREE(queue);
-        return NULL;
+    queue->block_indices = MEMPOOL_MALLOC(sizeof(mempool_index_t) * slots);
+    queue->data_lengths = MEMPOOL_MALLOC(sizeof(size_t) * slots);
+    if (mode == MEMPOOL_QUEUE_LOCKED) {
+        queue->queue_bitmap = MEMPOOL_MALLOC(sizeof(BITMAP_TYPE) * pool->bitmap_words);
+    } else {
+        queue->ring = MEMPOOL_MEMALIGN(MEMPOOL_ALIGNMENT, sizeof(struct mempool_ring));
     }
 
-    queue->data_lengths = MEMPOOL_MALLOC(sizeof(size_t) * capacity);
-    if (!queue->data_lengths) {
-        ERROR_PRINT("Failed to allocate data lengths array");
-        MEMPOOL_FREE(queue->block_indices);
-        MEMPOOL_FREE(queue);
+    if (!queue->block_indices || !queue->data_lengths || (!queue->queue_bitmap && !queue->ring)) {
+        ERROR_PRINT("Failed to allocate queue arrays");
+        mempool_queue_destroy(queue);
         return NULL;
     }
     
@@ -316,9 +2379,31 @@ mempool_queue_t *mempool_queue_create(mempool_t *pool, size_t capacity)
     queue->tail = 0;
     queue->count = 0;
     queue->next = NULL;
+    queue->sched_weight = 0;
+    queue->sched_deficit = 0;
+    queue->mode = mode;
+    queue->event_fd = -1;
     
-    for (int i = 0; i < BITMAP_WORDS; i++) {
-        queue->queue_bitmap[i] = 0;
+    if (queue->queue_bitmap) {
+        memset(queue->queue_bitmap, 0, sizeof(BITMAP_TYPE) * pool->bitmap_words);
+    }
+    if (queue->ring) {
+        memset(queue->ring, 0, sizeof(struct mempool_ring));
+        queue->ring->mask = slots - 1;
+        queue->wake_fence = MEMPOOL_HEAVY_BARRIER_REGISTER() != 0;
+    }
+
+    // MPMC模式: 槽位i的初始序号为i, 表示可供第i次入队写入
+    if (mode == MEMPOOL_QUEUE_MPMC) {
+        queue->ring->sequences = MEMPOOL_MALLOC(sizeof(size_t) * slots);
+        if (!queue->ring->sequences) {
+            ERROR_PRINT("Failed to allocate queue sequences");
+            mempool_queue_destroy(queue);
+            return NULL;
+        }
+        for (size_t i = 0; i < slots; i++) {
+            queue->ring->sequences[i] = i;
+        }
     }
     
     return queue;
@@ -334,9 +2419,208 @@ void mempool_queue_destroy(mempool_queue_t *queue)
     if (queue->block_indices) {
         MEMPOOL_FREE(queue->block_indices);
     }
+    if (queue->data_lengths) {
+        MEMPOOL_FREE(queue->data_lengths);
+    }
+    if (queue->queue_bitmap) {
+        MEMPOOL_FREE(queue->queue_bitmap);
+    }
+    if (queue->event_fd >= 0) {
+        MEMPOOL_EVENT_CLOSE(queue->event_fd);
+    }
+    if (queue->ring) {
+        if (queue->ring->sequences) {
+            MEMPOOL_FREE(queue->ring->sequences);
+        }
+        MEMPOOL_FREE(queue->ring);
+    }
     MEMPOOL_FREE(queue);
 }
 
+//===================================================================
+//  SPSC无锁队列: 生产者只写tail, 消费者只写head,
+//  槽位内容由tail的release写/acquire读发布给消费者
+//===================================================================
+static int spsc_enqueue(mempool_queue_t *queue, uint8_t *buffer, size_t data_length)
+{
+    struct mempool_ring *ring = queue->ring;
+
+    int block_idx = get_block_index(queue->pool, buffer);
+    if (block_idx < 0) {
+        return -1;
+    }
+
+    size_t tail = ring->tail; // 仅生产者写入, 无需原子读
+    if (tail - ring->head_cache >= queue->capacity) {
+        ring->head_cache = MEMPOOL_ATOMIC_LOAD(&ring->head);
+        if (tail - ring->head_cache >= queue->capacity) {
+            return -1; // 队列已满
+        }
+    }
+
+    size_t slot = tail & ring->mask;
+    queue->block_indices[slot] = (mempool_index_t)block_idx;
+    queue->data_lengths[slot] = data_length;
+    MEMPOOL_ATOMIC_STORE(&ring->tail, tail + 1);
+
+#if MEMPOOL_STATS_EN
+    // 基于head_cache的深度只会偏大, 超过峰值时才读取head确认(顺带刷新head_cache)
+    if (tail + 1 - ring->head_cache > MEMPOOL_ATOMIC_LOAD_RELAXED(&queue->stats_peak_depth)) {
+        ring->head_cache = MEMPOOL_ATOMIC_LOAD(&ring->head);
+        mempool_queue_stats_depth(queue, tail + 1 - ring->head_cache);
+    }
+#endif
+    return 0;
+}
+
+static size_t spsc_dequeue_batch(mempool_queue_t *queue, uint8_t **buffers, size_t *data_lengths, size_t max_count)
+{
+    struct mempool_ring *ring = queue->ring;
+    mempool_t *pool = queue->pool;
+
+    size_t head = ring->head; // 仅消费者写入, 无需原子读
+    if (ring->tail_cache - head < max_count) {
+        ring->tail_cache = MEMPOOL_ATOMIC_LOAD(&ring->tail);
+    }
+
+    size_t count = MEMPOOL_MIN(ring->tail_cache - head, max_count);
+    for (size_t i = 0; i < count; i++) {
+        size_t slot = (head + i) & ring->mask;
+        buffers[i] = pool->memory_area + (size_t)queue->block_indices[slot] * pool->block_size;
+        if (data_lengths) {
+            data_lengths[i] = queue->data_lengths[slot];
+        }
+    }
+
+    if (count) {
+        MEMPOOL_ATOMIC_STORE(&ring->head, head + count);
+    }
+    return count;
+}
+
+static uint8_t *spsc_peek(mempool_queue_t *queue, size_t *data_length)
+{
+    struct mempool_ring *ring = queue->ring;
+    size_t head = ring->head;
+
+    if (head == MEMPOOL_ATOMIC_LOAD(&ring->tail)) {
+        return NULL;
+    }
+    if (data_length) {
+        *data_length = queue->data_lengths[head & ring->mask];
+    }
+    return queue->pool->memory_area + (size_t)queue->block_indices[head & ring->mask] * queue->pool->block_size;
+}
+
+//===================================================================
+//  MPMC无锁队列: 每个槽位带序号, 生产者/消费者通过CAS推进tail/head,
+//  序号等于pos表示槽位可写, 等于pos+1表示槽位可读
+//===================================================================
+static int mpmc_enqueue(mempool_queue_t *queue, uint8_t *buffer, size_t data_length)
+{
+    struct mempool_ring *ring = queue->ring;
+
+    int block_idx = get_block_index(queue->pool, buffer);
+    if (block_idx < 0) {
+        return -1;
+    }
+
+    size_t pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    size_t slot;
+    for (;;) {
+        // 槽位数向上取整为2的幂, 容量小于槽位数时额外检查容量上限
+        if (queue->capacity <= ring->mask && pos - MEMPOOL_ATOMIC_LOAD(&ring->head) >= queue->capacity) {
+            return -1; // 队列已满
+        }
+
+        slot = pos & ring->mask;
+        intptr_t diff = (intptr_t)MEMPOOL_ATOMIC_LOAD(&ring->sequences[slot]) - (intptr_t)pos;
+        if (diff == 0) {
+            if (MEMPOOL_ATOMIC_CAS(&ring->tail, &pos, pos + 1))
+                break; // 失败时pos已被更新为最新tail
+        } else if (diff < 0) {
+            return -1; // 队列已满
+        } else {
+            pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    queue->block_indices[slot] = (mempool_index_t)block_idx;
+    queue->data_lengths[slot] = data_length;
+    MEMPOOL_ATOMIC_STORE(&ring->sequences[slot], pos + 1);
+
+#if MEMPOOL_STATS_EN
+    size_t head = MEMPOOL_ATOMIC_LOAD(&ring->head);
+    mempool_queue_stats_depth(queue, pos + 1 > head ? pos + 1 - head : 0);
+#endif
+    return 0;
+}
+
+// 一次CAS认领连续的多个可读槽位
+static size_t mpmc_dequeue_batch(mempool_queue_t *queue, uint8_t **buffers, size_t *data_lengths, size_t max_count)
+{
+    struct mempool_ring *ring = queue->ring;
+    mempool_t *pool = queue->pool;
+
+    size_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    size_t count;
+    for (;;) {
+        count = 0;
+        while (count < max_count) {
+            size_t seq = MEMPOOL_ATOMIC_LOAD(&ring->sequences[(pos + count) & ring->mask]);
+            if ((intptr_t)seq - (intptr_t)(pos + count + 1) != 0)
+                break;
+            count++;
+        }
+
+        if (count == 0) {
+            // 首个槽位尚未发布: 若head未变则队列为空
+            size_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+            if (head == pos) return 0;
+            pos = head;
+            continue;
+        }
+
+        if (MEMPOOL_ATOMIC_CAS(&ring->head, &pos, pos + count))
+            break; // 失败时pos已被更新为最新head
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        size_t slot = (pos + i) & ring->mask;
+        buffers[i] = pool->memory_area + (size_t)queue->block_indices[slot] * pool->block_size;
+        if (data_lengths) {
+            data_lengths[i] = queue->data_lengths[slot];
+        }
+        // 释放槽位供下一轮(pos + 槽位数)入队使用
+        MEMPOOL_ATOMIC_STORE(&ring->sequences[slot], pos + i + ring->mask + 1);
+    }
+    return count;
+}
+
+// 查看队首元素(仅供参考, 返回后可能已被其他消费者取走)
+static uint8_t *mpmc_peek(mempool_queue_t *queue, size_t *data_length)
+{
+    struct mempool_ring *ring = queue->ring;
+    size_t pos = MEMPOOL_ATOMIC_LOAD(&ring->head);
+    size_t slot = pos & ring->mask;
+
+    if (MEMPOOL_ATOMIC_LOAD(&ring->sequences[slot]) != pos + 1) {
+        return NULL;
+    }
+    if (data_length) {
+        *data_length = queue->data_lengths[slot];
+    }
+    return queue->pool->memory_area + (size_t)queue->block_indices[slot] * queue->pool->block_size;
+}
+
+// 无锁模式下的元素数量(并发读取时为近似值)
+static size_t ring_count(mempool_queue_t *queue)
+{
+    size_t head = MEMPOOL_ATOMIC_LOAD(&queue->ring->head);
+    size_t tail = MEMPOOL_ATOMIC_LOAD(&queue->ring->tail);
+    return tail - head;
+}
+
 /* 内部函数：验证队列和指针有效性 */
 static int validate_queue_and_buffer(mempool_queue_t *queue, uint8_t *buffer, int *block_idx)
 {
@@ -364,10 +2648,10 @@ static int validate_queue_and_buffer(mempool_queue_t *queue, uint8_t *buffer, in
 /* 内部函数：执行实际的入队操作 */
 static void do_enqueue(mempool_queue_t *queue, int block_idx, size_t data_length)
 {
-    queue->block_indices[queue->tail] = (uint16_t)block_idx;
+    queue->block_indices[queue->tail] = (mempool_index_t)block_idx;
     queue->data_lengths[queue->tail] = data_length;
     queue->tail = (queue->tail + 1) % queue->capacity;
-    queue->count++;
+    MEMPOOL_ATOMIC_STORE_RELAXED(&queue->count, queue->count + 1);
     
     int word_idx = block_idx >> LOG2_MEMPOOL_BITMAP_EACH_NUM;
     int bit_pos = block_idx & (MEMPOOL_BITMAP_EACH_NUM - 1);
@@ -377,13 +2661,13 @@ static void do_enqueue(mempool_queue_t *queue, int block_idx, size_t data_length
 /* 内部函数：执行实际的出队操作 */
 static uint8_t *do_dequeue(mempool_queue_t *queue, size_t *data_length)
 {
-    uint16_t block_idx = queue->block_indices[queue->head];
+    mempool_index_t block_idx = queue->block_indices[queue->head];
     if (data_length) {
         *data_length = queue->data_lengths[queue->head];
     }
     
     queue->head = (queue->head + 1) % queue->capacity;
-    queue->count--;
+    MEMPOOL_ATOMIC_STORE_RELAXED(&queue->count, queue->count - 1);
     
     int word_idx = block_idx >> LOG2_MEMPOOL_BITMAP_EACH_NUM;
     int bit_pos = block_idx & (MEMPOOL_BITMAP_EACH_NUM - 1);
@@ -398,11 +2682,34 @@ int mempool_queue_enqueue(mempool_queue_t *queue, uint8_t *buffer)
     return mempool_queue_enqueue_with_length(queue, buffer, 0);
 }
 
-int mempool_queue_enqueue_with_length(mempool_queue_t *queue, uint8_t *buffer, size_t data_length)
+// 就绪通知: 已布防且深度达到水位时撤防并写一次eventfd, 未布防时只有一次原子读.
+// 与mempool_wait_wake相同, 发布写与event_armed读之间的屏障由调用者提供(消费者重新布防时对应非对称屏障)
+static inline void mempool_queue_event_notify(mempool_queue_t *queue)
+{
+    if (queue->event_fd < 0 || MEMPOOL_ATOMIC_LOAD(&queue->event_armed) == 0) {
+        return;
+    }
+    if (mempool_queue_count(queue) < MEMPOOL_ATOMIC_LOAD_RELAXED(&queue->event_watermark)) {
+        return;
+    }
+    uint32_t armed = 1;
+    if (MEMPOOL_ATOMIC_CAS(&queue->event_armed, &armed, 0)) {
+        MEMPOOL_EVENT_SIGNAL(queue->event_fd);
+    }
+}
+
+static int queue_enqueue(mempool_queue_t *queue, uint8_t *buffer, size_t data_length)
 {
     DEBUG_PRINT("Enqueuing buffer %p with length %zu to queue %p", 
                buffer, data_length, queue);
 
+    if (queue && queue->mode == MEMPOOL_QUEUE_SPSC) {
+        return buffer ? spsc_enqueue(queue, buffer, data_length) : -1;
+    }
+    if (queue && queue->mode == MEMPOOL_QUEUE_MPMC) {
+        return buffer ? mpmc_enqueue(queue, buffer, data_length) : -1;
+    }
+
     int block_idx;
 #ifdef MEMPOOL_LOCK_INIT
     MEMPOOL_LOCK_TYPE *lock = &queue->pool->lock;
@@ -410,7 +2717,7 @@ int mempool_queue_enqueue_with_length(mempool_queue_t *queue, uint8_t *buffer, s
     MEMPOOL_LOCK_TYPE lock;
 #endif
 
-    MEMPOOL_LOCK(lock);
+    MEMPOOL_LOCK_STAT(queue->pool, lock);
     
     if (validate_queue_and_buffer(queue, buffer, &block_idx) < 0) {
         MEMPOOL_UNLOCK(lock);
@@ -419,11 +2726,32 @@ int mempool_queue_enqueue_with_length(mempool_queue_t *queue, uint8_t *buffer, s
     }
     
     do_enqueue(queue, block_idx, data_length);
-    
+    mempool_queue_stats_depth(queue, queue->count);
+
     MEMPOOL_UNLOCK(lock);
     return 0;
 }
 
+int mempool_queue_enqueue_with_length(mempool_queue_t *queue, uint8_t *buffer, size_t data_length)
+{
+    MEMPOOL_HIST_BEGIN(start);
+    int ret = queue_enqueue(queue, buffer, data_length);
+    if (ret == 0) {
+        // 无锁模式的发布写与waiters读之间需要屏障, 通常由等待方的非对称屏障提供
+        if (queue->wake_fence) {
+            MEMPOOL_FULL_BARRIER();
+        } else {
+            MEMPOOL_LIGHT_BARRIER();
+        }
+        mempool_wait_wake(&queue->wait);
+        mempool_queue_event_notify(queue);
+    } else {
+        mempool_queue_stats_reject(queue);
+    }
+    MEMPOOL_HIST_END(MEMPOOL_HIST_ENQUEUE, start);
+    return ret;
+}
+
 // 出队操作
 uint8_t *mempool_queue_dequeue(mempool_queue_t *queue)
 {
@@ -431,34 +2759,106 @@ uint8_t *mempool_queue_dequeue(mempool_queue_t *queue)
     return mempool_queue_dequeue_with_length(queue, &dummy);
 }
 
-uint8_t *mempool_queue_dequeue_with_length(mempool_queue_t *queue, size_t *data_length)
-{
-    DEBUG_PRINT("Dequeuing from queue %p with length", queue);
+static size_t queue_dequeue_batch(mempool_queue_t *queue, uint8_t **buffers, size_t *data_lengths, size_t max_count);
 
-    if (!queue || queue->count == 0) {
-        if (data_length) *data_length = 0;
-        return NULL;
-    }
-    
+// 加锁模式出队, 在锁内判断队列是否为空
+static uint8_t *queue_dequeue_locked(mempool_queue_t *queue, size_t *data_length)
+{
 #ifdef MEMPOOL_LOCK_INIT
     MEMPOOL_LOCK_TYPE *lock = &queue->pool->lock;
 #else
     MEMPOOL_LOCK_TYPE lock;
 #endif
 
-    MEMPOOL_LOCK(lock);
+    MEMPOOL_LOCK_STAT(queue->pool, lock);
+    if (queue->count == 0) {
+        MEMPOOL_UNLOCK(lock);
+        if (data_length) *data_length = 0;
+        return NULL;
+    }
     uint8_t *block = do_dequeue(queue, data_length);
     MEMPOOL_UNLOCK(lock);
     
     return block;
 }
 
+static uint8_t *queue_dequeue(mempool_queue_t *queue, size_t *data_length)
+{
+    if (queue && queue->ring) {
+        uint8_t *block = NULL;
+        if (queue_dequeue_batch(queue, &block, data_length, 1) == 0 && data_length) {
+            *data_length = 0;
+        }
+        return block;
+    }
+
+    // 不加锁的空队列预检查(count在锁内以宽松原子写入), 空队列出队不争用池锁
+    if (!queue || MEMPOOL_ATOMIC_LOAD_RELAXED(&queue->count) == 0) {
+        if (data_length) *data_length = 0;
+        return NULL;
+    }
+    return queue_dequeue_locked(queue, data_length);
+}
+
+uint8_t *mempool_queue_dequeue_with_length(mempool_queue_t *queue, size_t *data_length)
+{
+    DEBUG_PRINT("Dequeuing from queue %p with length", queue);
+
+    MEMPOOL_HIST_BEGIN(start);
+    uint8_t *block = queue_dequeue(queue, data_length);
+    MEMPOOL_HIST_END(MEMPOOL_HIST_DEQUEUE, start);
+    return block;
+}
+
+struct mempool_dequeue_ctx {
+    mempool_queue_t *queue;
+    size_t *data_length;
+};
+
+// 等待中的重试不计入出队延迟直方图; 加锁队列不做不加锁的预检查,
+// 在锁内判断是否为空, 与入队方"锁内入队, 解锁后检查waiters"经过同一把锁
+static void *mempool_try_dequeue(void *arg)
+{
+    struct mempool_dequeue_ctx *ctx = (struct mempool_dequeue_ctx *)arg;
+    if (!ctx->queue->ring) {
+        return queue_dequeue_locked(ctx->queue, ctx->data_length);
+    }
+    return queue_dequeue(ctx->queue, ctx->data_length);
+}
+
+// 阻塞出队, 队列为空时等待入队
+uint8_t *mempool_queue_dequeue_timed(mempool_queue_t *queue, size_t *data_length, uint64_t timeout_ns)
+{
+    MEMPOOL_HIST_BEGIN(start);
+    uint8_t *block = queue_dequeue(queue, data_length);
+    if (!block && queue && timeout_ns != 0) {
+        struct mempool_dequeue_ctx ctx = { queue, data_length };
+        block = mempool_wait_until(&queue->wait, timeout_ns, queue->ring && !queue->wake_fence,
+                                   mempool_try_dequeue, &ctx);
+    }
+    MEMPOOL_HIST_END(MEMPOOL_HIST_DEQUEUE, start);
+    return block;
+}
+
 // 查看队首元素
 uint8_t *mempool_queue_peek(mempool_queue_t *queue)
+{
+    return mempool_queue_peek_with_length(queue, NULL);
+}
+
+// 查看队首块及其数据长度(不出队)
+uint8_t *mempool_queue_peek_with_length(mempool_queue_t *queue, size_t *data_length)
 {
     DEBUG_PRINT("Peeking queue %p", queue);
 
-    if (!queue || queue->count == 0) {
+    if (queue && queue->mode == MEMPOOL_QUEUE_SPSC) {
+        return spsc_peek(queue, data_length);
+    }
+    if (queue && queue->mode == MEMPOOL_QUEUE_MPMC) {
+        return mpmc_peek(queue, data_length);
+    }
+
+    if (!queue || MEMPOOL_ATOMIC_LOAD_RELAXED(&queue->count) == 0) {
         return NULL;
     }
     
@@ -469,33 +2869,42 @@ uint8_t *mempool_queue_peek(mempool_queue_t *queue)
 #endif
 
     MEMPOOL_LOCK(lock);
+
+    if (queue->count == 0) {
+        MEMPOOL_UNLOCK(lock);
+        return NULL;
+    }
     
-    uint16_t block_idx = queue->block_indices[queue->head];
+    mempool_index_t block_idx = queue->block_indices[queue->head];
     uint8_t *block = queue->pool->memory_area + block_idx * queue->pool->block_size;
+    if (data_length) {
+        *data_length = queue->data_lengths[queue->head];
+    }
     
     MEMPOOL_UNLOCK(lock);
     return block;
 }
 
-// 批量出队
-size_t mempool_queue_dequeue_batch_with_length(mempool_queue_t *queue, 
-    uint8_t **buffers, 
-    size_t *data_lengths,
-    size_t max_count)
+static size_t queue_dequeue_batch(mempool_queue_t *queue, uint8_t **buffers, size_t *data_lengths, size_t max_count)
 {
-    DEBUG_PRINT("Dequeuing batch of %zu from queue %p with lengths", max_count, queue);
-
     if (!queue || !buffers || max_count == 0) {
     return 0;
     }
 
+    if (queue->mode == MEMPOOL_QUEUE_SPSC) {
+        return spsc_dequeue_batch(queue, buffers, data_lengths, max_count);
+    }
+    if (queue->mode == MEMPOOL_QUEUE_MPMC) {
+        return mpmc_dequeue_batch(queue, buffers, data_lengths, max_count);
+    }
+
 #ifdef MEMPOOL_LOCK_INIT
     MEMPOOL_LOCK_TYPE *lock = &queue->pool->lock;
 #else
     MEMPOOL_LOCK_TYPE lock;
 #endif
 
-    MEMPOOL_LOCK(lock);
+    MEMPOOL_LOCK_STAT(queue->pool, lock);
 
     size_t actual_count = MEMPOOL_MIN(queue->count, max_count);
     for (size_t i = 0; i < actual_count; i++) {
@@ -506,25 +2915,126 @@ size_t mempool_queue_dequeue_batch_with_length(mempool_queue_t *queue,
     return actual_count;
 }
 
+// 批量出队
+size_t mempool_queue_dequeue_batch_with_length(mempool_queue_t *queue, 
+    uint8_t **buffers, 
+    size_t *data_lengths,
+    size_t max_count)
+{
+    DEBUG_PRINT("Dequeuing batch of %zu from queue %p with lengths", max_count, queue);
+
+    MEMPOOL_HIST_BEGIN(start);
+    size_t count = queue_dequeue_batch(queue, buffers, data_lengths, max_count);
+    MEMPOOL_HIST_END(MEMPOOL_HIST_DEQUEUE, start);
+    return count;
+}
+
+// 批量出队(不返回数据长度)
+size_t mempool_queue_dequeue_batch(mempool_queue_t *queue, uint8_t **buffers, size_t max_count)
+{
+    return mempool_queue_dequeue_batch_with_length(queue, buffers, NULL, max_count);
+}
+
+// 队列统计快照
+int mempool_queue_get_stats(mempool_queue_t *queue, mempool_queue_stats_t *stats)
+{
+#if MEMPOOL_STATS_EN
+    if (!queue || !stats) return -1;
+
+    stats->depth = mempool_queue_count(queue);
+    stats->peak_depth = MEMPOOL_ATOMIC_LOAD_RELAXED(&queue->stats_peak_depth);
+    stats->enqueue_rejected = MEMPOOL_ATOMIC_LOAD_RELAXED(&queue->stats_rejected);
+    return 0;
+#else
+    (void)queue;
+    (void)stats;
+    return -1;
+#endif
+}
+
 // 获取队列元素数量
 size_t mempool_queue_count(mempool_queue_t *queue)
 {
-    DEBUG_PRINT("Getting count for queue %p: %zu", queue, queue->count);
-    
     if (!queue) return 0;
-    return queue->count;
+
+    if (queue->ring) {
+        return ring_count(queue);
+    }
+
+    size_t count = MEMPOOL_ATOMIC_LOAD_RELAXED(&queue->count);
+    DEBUG_PRINT("Getting count for queue %p: %zu", queue, count);
+    return count;
 }
 
 // 检查队列是否为空
 bool mempool_queue_is_empty(mempool_queue_t *queue)
 {
     if (!queue) return true;
-    return queue->count == 0;
+    return mempool_queue_count(queue) == 0;
 }
 
 // 检查队列是否已满
 bool mempool_queue_is_full(mempool_queue_t *queue)
 {
     if (!queue) return true;
-    return queue->count >= queue->capacity;
+    return mempool_queue_count(queue) >= queue->capacity;
+}
+
+// 布防并复查深度: 先置event_armed再读取深度, 与入队侧"先发布再读event_armed"配对,
+// 两者之间的屏障与阻塞出队相同(无锁队列由本侧执行非对称屏障, 加锁队列经过同一把锁),
+// 因此要么本侧看到新入队的块, 要么入队侧看到已布防
+static size_t queue_event_arm(mempool_queue_t *queue)
+{
+    size_t depth;
+
+    MEMPOOL_ATOMIC_FETCH_OR(&queue->event_armed, 1);
+    if (queue->ring) {
+        if (!queue->wake_fence) {
+            MEMPOOL_HEAVY_BARRIER();
+        }
+        depth = ring_count(queue);
+    } else {
+#ifdef MEMPOOL_LOCK_INIT
+        MEMPOOL_LOCK_TYPE *lock = &queue->pool->lock;
+#else
+        MEMPOOL_LOCK_TYPE lock;
+#endif
+        MEMPOOL_LOCK_STAT(queue->pool, lock);
+        depth = queue->count;
+        MEMPOOL_UNLOCK(lock);
+    }
+
+    mempool_queue_event_notify(queue);
+    return depth;
+}
+
+// 启用就绪通知
+int mempool_queue_event_enable(mempool_queue_t *queue, size_t watermark)
+{
+    if (!queue) return -1;
+
+    // 水位超过容量时永远不会触发, 按容量处理
+    watermark = MEMPOOL_MIN(watermark ? watermark : 1, queue->capacity);
+    MEMPOOL_ATOMIC_STORE_RELAXED(&queue->event_watermark, watermark);
+    if (queue->event_fd < 0) {
+        int fd = MEMPOOL_EVENT_CREATE();
+        if (fd < 0) {
+            ERROR_PRINT("Failed to create queue eventfd");
+            return -1;
+        }
+        queue->event_fd = fd;
+        queue_event_arm(queue);
+    }
+
+    DEBUG_PRINT("Queue %p readiness eventfd %d, watermark %zu", queue, queue->event_fd, queue->event_watermark);
+    return queue->event_fd;
 }
+
+// 确认就绪通知
+size_t mempool_queue_event_ack(mempool_queue_t *queue)
+{
+    if (!queue || queue->event_fd < 0) return 0;
+
+    MEMPOOL_EVENT_CLEAR(queue->event_fd);
+    return queue_event_arm(queue);
+}
\ No newline at end of file
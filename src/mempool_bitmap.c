@@ -0,0 +1,373 @@
+#include "mempool_bitmap.h"
+
+#ifdef MEMPOOL_LOG_LEVEL
+#undef MEMPOOL_LOG_LEVEL
+#endif
+
+#define MEMPOOL_LOG_LEVEL LOG_LEVEL_ERROR
+#include <mempool_log.h>
+
+#if defined(__SANITIZE_THREAD__)
+#define MEMPOOL_BITMAP_TSAN     1
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define MEMPOOL_BITMAP_TSAN     1
+#endif
+#endif
+
+// 向量内核直接读取内存, ThreadSanitizer构建中只使用逐字原子读取的标量内核
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(MEMPOOL_BITMAP_TSAN)
+#define MEMPOOL_BITMAP_X86      1
+#include <immintrin.h>
+#else
+#define MEMPOOL_BITMAP_X86      0
+#endif
+
+#define BITMAP_BITS             MEMPOOL_BITMAP_EACH_NUM
+#define BITMAP_ALL              ((BITMAP_TYPE)-1)
+#define BITMAP_MASK_OF(idx)     ((BITMAP_TYPE)1 << ((idx) & (BITMAP_BITS - 1)))
+
+struct mempool_bitmap_ops {
+    const char *name;
+    long (*find_first)(const BITMAP_TYPE *bitmap, size_t words);
+    long (*find_run)(const BITMAP_TYPE *bitmap, size_t nbits, size_t n);
+    size_t (*popcount)(const BITMAP_TYPE *bitmap, size_t words);
+};
+
+//===================================================================
+//  公共部分
+//===================================================================
+static inline size_t bitmap_ctz(BITMAP_TYPE w)
+{
+    return (size_t)__builtin_ctzll((unsigned long long)w);
+}
+
+// 最低位开始的连续置位数
+static inline size_t bitmap_trailing_ones(BITMAP_TYPE w)
+{
+    return w == BITMAP_ALL ? BITMAP_BITS : bitmap_ctz((BITMAP_TYPE)~w);
+}
+
+// 最高位开始的连续置位数
+static inline size_t bitmap_leading_ones(BITMAP_TYPE w)
+{
+    if (w == BITMAP_ALL) return BITMAP_BITS;
+    return (size_t)__builtin_clzll((unsigned long long)(BITMAP_TYPE)~w << (64 - BITMAP_BITS));
+}
+
+// 字内连续n个置位(n不超过字宽)的起始位掩码: 每轮把已确认的长度最多翻倍
+static inline BITMAP_TYPE bitmap_run_starts(BITMAP_TYPE w, size_t n)
+{
+    size_t len = 1;
+    while (len < n && w) {
+        size_t shift = MEMPOOL_MIN(len, n - len);
+        w &= w >> shift;
+        len += shift;
+    }
+    return w;
+}
+
+// 处理一个字: run为之前连续置位的长度, 找到时返回起始位下标
+static inline long bitmap_run_word(BITMAP_TYPE w, size_t base, size_t n, size_t *run)
+{
+    if (*run + bitmap_trailing_ones(w) >= n) {
+        return (long)(base - *run);
+    }
+    if (w == BITMAP_ALL) {
+        *run += BITMAP_BITS;
+        return -1;
+    }
+    if (n <= BITMAP_BITS) {
+        BITMAP_TYPE starts = bitmap_run_starts(w, n);
+        if (starts) {
+            return (long)(base + bitmap_ctz(starts));
+        }
+    }
+    *run = bitmap_leading_ones(w);
+    return -1;
+}
+
+#define BITMAP_CHUNK_MIXED      0
+#define BITMAP_CHUNK_ZERO       1
+#define BITMAP_CHUNK_ONES       2
+
+// 连续置位查找: classify一次判断chunk个字是否全0/全1(由向量内核提供), 混合的块逐字处理
+static inline __attribute__((always_inline)) long
+bitmap_find_run_common(const BITMAP_TYPE *bitmap, size_t nbits, size_t n, size_t chunk,
+                       int (*classify)(const BITMAP_TYPE *))
+{
+    if (n == 0 || n > nbits) return -1;
+
+    size_t full = nbits / BITMAP_BITS;   // 完整字数, 最后不完整的字屏蔽无效位后单独处理
+    size_t run = 0;
+    size_t i = 0;
+    long found;
+
+    while (i < full) {
+        size_t end = i + 1;
+        if (chunk && i + chunk <= full) {
+            int kind = classify(&bitmap[i]);
+            if (kind == BITMAP_CHUNK_ZERO) {
+                run = 0;
+                i += chunk;
+                continue;
+            }
+            if (kind == BITMAP_CHUNK_ONES) {
+                if (run + chunk * BITMAP_BITS >= n) {
+                    return (long)(i * BITMAP_BITS - run);
+                }
+                run += chunk * BITMAP_BITS;
+                i += chunk;
+                continue;
+            }
+            end = i + chunk;
+        }
+        for (; i < end; i++) {
+            found = bitmap_run_word(MEMPOOL_ATOMIC_LOAD_RELAXED(&bitmap[i]), i * BITMAP_BITS, n, &run);
+            if (found >= 0) return found;
+        }
+    }
+
+    if (nbits % BITMAP_BITS) {
+        BITMAP_TYPE w = MEMPOOL_ATOMIC_LOAD_RELAXED(&bitmap[full]) & (BITMAP_MASK_OF(nbits) - 1);
+        found = bitmap_run_word(w, full * BITMAP_BITS, n, &run);
+        if (found >= 0) return found;
+    }
+    return -1;
+}
+
+//===================================================================
+//  标量内核
+//===================================================================
+static long bitmap_find_first_from(const BITMAP_TYPE *bitmap, size_t i, size_t words)
+{
+    for (; i < words; i++) {
+        BITMAP_TYPE w = MEMPOOL_ATOMIC_LOAD_RELAXED(&bitmap[i]);
+        if (w) {
+            return (long)(i * BITMAP_BITS + bitmap_ctz(w));
+        }
+    }
+    return -1;
+}
+
+static size_t bitmap_popcount_from(const BITMAP_TYPE *bitmap, size_t i, size_t words)
+{
+    size_t count = 0;
+    for (; i < words; i++) {
+        count += (size_t)__builtin_popcountll((unsigned long long)MEMPOOL_ATOMIC_LOAD_RELAXED(&bitmap[i]));
+    }
+    return count;
+}
+
+static long bitmap_find_first_scalar(const BITMAP_TYPE *bitmap, size_t words)
+{
+    return bitmap_find_first_from(bitmap, 0, words);
+}
+
+static long bitmap_find_run_scalar(const BITMAP_TYPE *bitmap, size_t nbits, size_t n)
+{
+    return bitmap_find_run_common(bitmap, nbits, n, 0, NULL);
+}
+
+static size_t bitmap_popcount_scalar(const BITMAP_TYPE *bitmap, size_t words)
+{
+    return bitmap_popcount_from(bitmap, 0, words);
+}
+
+static const struct mempool_bitmap_ops bitmap_ops_scalar = {
+    "scalar", bitmap_find_first_scalar, bitmap_find_run_scalar, bitmap_popcount_scalar,
+};
+
+#if MEMPOOL_BITMAP_X86
+//===================================================================
+//  SSE2内核: 每次16字节
+//===================================================================
+#define SSE2_WORDS      (16 / sizeof(BITMAP_TYPE))
+
+__attribute__((target("sse2")))
+static long bitmap_find_first_sse2(const BITMAP_TYPE *bitmap, size_t words)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + SSE2_WORDS <= words; i += SSE2_WORDS) {
+        __m128i v = _mm_loadu_si128((const __m128i *)&bitmap[i]);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) != 0xFFFF) break;
+    }
+    return bitmap_find_first_from(bitmap, i, words);
+}
+
+__attribute__((target("sse2")))
+static int bitmap_classify_sse2(const BITMAP_TYPE *bitmap)
+{
+    __m128i v = _mm_loadu_si128((const __m128i *)bitmap);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) == 0xFFFF) return BITMAP_CHUNK_ZERO;
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(-1))) == 0xFFFF) return BITMAP_CHUNK_ONES;
+    return BITMAP_CHUNK_MIXED;
+}
+
+__attribute__((target("sse2")))
+static long bitmap_find_run_sse2(const BITMAP_TYPE *bitmap, size_t nbits, size_t n)
+{
+    return bitmap_find_run_common(bitmap, nbits, n, SSE2_WORDS, bitmap_classify_sse2);
+}
+
+// 逐字节SWAR计数后用psadbw横向求和
+__attribute__((target("sse2")))
+static size_t bitmap_popcount_sse2(const BITMAP_TYPE *bitmap, size_t words)
+{
+    const __m128i m1 = _mm_set1_epi8(0x55), m2 = _mm_set1_epi8(0x33), m4 = _mm_set1_epi8(0x0F);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    size_t i = 0;
+
+    for (; i + SSE2_WORDS <= words; i += SSE2_WORDS) {
+        __m128i x = _mm_loadu_si128((const __m128i *)&bitmap[i]);
+        x = _mm_sub_epi8(x, _mm_and_si128(_mm_srli_epi64(x, 1), m1));
+        x = _mm_add_epi8(_mm_and_si128(x, m2), _mm_and_si128(_mm_srli_epi64(x, 2), m2));
+        x = _mm_and_si128(_mm_add_epi8(x, _mm_srli_epi64(x, 4)), m4);
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(x, zero));
+    }
+
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    return (size_t)(lanes[0] + lanes[1]) + bitmap_popcount_from(bitmap, i, words);
+}
+
+static const struct mempool_bitmap_ops bitmap_ops_sse2 = {
+    "sse2", bitmap_find_first_sse2, bitmap_find_run_sse2, bitmap_popcount_sse2,
+};
+
+//===================================================================
+//  AVX2内核: 每次32字节(首个置位查找每轮64字节)
+//===================================================================
+#define AVX2_WORDS      (32 / sizeof(BITMAP_TYPE))
+
+__attribute__((target("avx2")))
+static long bitmap_find_first_avx2(const BITMAP_TYPE *bitmap, size_t words)
+{
+    size_t i = 0;
+
+    for (; i + 2 * AVX2_WORDS <= words; i += 2 * AVX2_WORDS) {
+        __m256i v = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)&bitmap[i]),
+                                    _mm256_loadu_si256((const __m256i *)&bitmap[i + AVX2_WORDS]));
+        if (!_mm256_testz_si256(v, v)) break;
+    }
+    for (; i + AVX2_WORDS <= words; i += AVX2_WORDS) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)&bitmap[i]);
+        if (!_mm256_testz_si256(v, v)) break;
+    }
+    return bitmap_find_first_from(bitmap, i, words);
+}
+
+__attribute__((target("avx2")))
+static int bitmap_classify_avx2(const BITMAP_TYPE *bitmap)
+{
+    __m256i v = _mm256_loadu_si256((const __m256i *)bitmap);
+    if (_mm256_testz_si256(v, v)) return BITMAP_CHUNK_ZERO;
+    if (_mm256_testc_si256(v, _mm256_set1_epi8(-1))) return BITMAP_CHUNK_ONES;
+    return BITMAP_CHUNK_MIXED;
+}
+
+__attribute__((target("avx2")))
+static long bitmap_find_run_avx2(const BITMAP_TYPE *bitmap, size_t nbits, size_t n)
+{
+    return bitmap_find_run_common(bitmap, nbits, n, AVX2_WORDS, bitmap_classify_avx2);
+}
+
+// 半字节查表(vpshufb)计数后用vpsadbw横向求和
+__attribute__((target("avx2")))
+static size_t bitmap_popcount_avx2(const BITMAP_TYPE *bitmap, size_t words)
+{
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0F);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+    size_t i = 0;
+
+    for (; i + AVX2_WORDS <= words; i += AVX2_WORDS) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)&bitmap[i]);
+        __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(v, low)),
+                                      _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(cnt, zero));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    return (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]) + bitmap_popcount_from(bitmap, i, words);
+}
+
+static const struct mempool_bitmap_ops bitmap_ops_avx2 = {
+    "avx2", bitmap_find_first_avx2, bitmap_find_run_avx2, bitmap_popcount_avx2,
+};
+#endif
+
+//===================================================================
+//  运行时选择
+//===================================================================
+static const struct mempool_bitmap_ops *bitmap_ops;    // 首次调用时选择
+
+static const struct mempool_bitmap_ops *bitmap_ops_for(mempool_bitmap_kernel_t kernel)
+{
+    switch (kernel) {
+    case MEMPOOL_BITMAP_KERNEL_SCALAR:
+        return &bitmap_ops_scalar;
+#if MEMPOOL_BITMAP_X86
+    case MEMPOOL_BITMAP_KERNEL_SSE2:
+        return __builtin_cpu_supports("sse2") ? &bitmap_ops_sse2 : NULL;
+    case MEMPOOL_BITMAP_KERNEL_AVX2:
+        return __builtin_cpu_supports("avx2") ? &bitmap_ops_avx2 : NULL;
+    case MEMPOOL_BITMAP_KERNEL_AUTO:
+        if (__builtin_cpu_supports("avx2")) return &bitmap_ops_avx2;
+        if (__builtin_cpu_supports("sse2")) return &bitmap_ops_sse2;
+        return &bitmap_ops_scalar;
+#else
+    case MEMPOOL_BITMAP_KERNEL_AUTO:
+        return &bitmap_ops_scalar;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+static inline const struct mempool_bitmap_ops *bitmap_ops_get(void)
+{
+    const struct mempool_bitmap_ops *ops = MEMPOOL_ATOMIC_LOAD_RELAXED(&bitmap_ops);
+    if (!ops) {
+        ops = bitmap_ops_for(MEMPOOL_BITMAP_KERNEL_AUTO);
+        MEMPOOL_ATOMIC_STORE_RELAXED(&bitmap_ops, ops);
+        DEBUG_PRINT("Bitmap kernel: %s", ops->name);
+    }
+    return ops;
+}
+
+long mempool_bitmap_find_first(const BITMAP_TYPE *bitmap, size_t words)
+{
+    return bitmap_ops_get()->find_first(bitmap, words);
+}
+
+long mempool_bitmap_find_run(const BITMAP_TYPE *bitmap, size_t nbits, size_t n)
+{
+    return bitmap_ops_get()->find_run(bitmap, nbits, n);
+}
+
+size_t mempool_bitmap_popcount(const BITMAP_TYPE *bitmap, size_t words)
+{
+    return bitmap_ops_get()->popcount(bitmap, words);
+}
+
+int mempool_bitmap_set_kernel(mempool_bitmap_kernel_t kernel)
+{
+    const struct mempool_bitmap_ops *ops = bitmap_ops_for(kernel);
+    if (!ops) {
+        return -1;
+    }
+    MEMPOOL_ATOMIC_STORE_RELAXED(&bitmap_ops, ops);
+    return 0;
+}
+
+const char *mempool_bitmap_kernel_name(void)
+{
+    return bitmap_ops_get()->name;
+}
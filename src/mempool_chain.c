@@ -0,0 +1,359 @@
+#include "mempool_chain.h"
+#include <string.h>
+
+#ifdef MEMPOOL_LOG_LEVEL
+#undef MEMPOOL_LOG_LEVEL
+#endif
+
+#define MEMPOOL_LOG_LEVEL LOG_LEVEL_ERROR
+#include <mempool_log.h>
+
+// 分配/释放段描述符
+static mempool_seg_t *mempool_chain_seg_alloc(mempool_chain_t *chain)
+{
+    if (chain->seg_pool) {
+        return (mempool_seg_t *)mempool_alloc(chain->seg_pool, false);
+    }
+    return MEMPOOL_MALLOC(sizeof(mempool_seg_t));
+}
+
+static void mempool_chain_seg_free(mempool_chain_t *chain, mempool_seg_t *seg)
+{
+    if (chain->seg_pool) {
+        mempool_free(chain->seg_pool, (uint8_t *)seg);
+    } else {
+        MEMPOOL_FREE(seg);
+    }
+}
+
+// 释放从seg开始的所有段及其块
+static void mempool_chain_release(mempool_chain_t *chain, mempool_seg_t *seg)
+{
+    while (seg) {
+        mempool_seg_t *next = seg->next;
+        mempool_free(chain->pool, seg->block);
+        mempool_chain_seg_free(chain, seg);
+        seg = next;
+    }
+}
+
+// 分配count个带数据块的空段并串成链表; 任一分配失败时全部归还并返回-1
+static int mempool_chain_new_segs(mempool_chain_t *chain, size_t count, mempool_seg_t **first, mempool_seg_t **last)
+{
+    *first = *last = NULL;
+
+    for (size_t i = 0; i < count; i++) {
+        mempool_seg_t *seg = mempool_chain_seg_alloc(chain);
+        uint8_t *block = seg ? mempool_alloc(chain->pool, false) : NULL;
+        if (!block) {
+            if (seg) mempool_chain_seg_free(chain, seg);
+            mempool_chain_release(chain, *first);
+            *first = *last = NULL;
+            DEBUG_PRINT("Chain %p: out of blocks or descriptors", chain);
+            return -1;
+        }
+
+        seg->next = NULL;
+        seg->block = block;
+        seg->offset = 0;
+        seg->length = 0;
+        if (*last) {
+            (*last)->next = seg;
+        } else {
+            *first = seg;
+        }
+        *last = seg;
+    }
+    return 0;
+}
+
+// 块是否只被本链使用(共享块的空闲空间可能属于其他链的段)
+static bool mempool_chain_exclusive(mempool_chain_t *chain, uint8_t *block)
+{
+    return !chain->pool->refcount || mempool_refcount(chain->pool, block) <= 1;
+}
+
+// 初始化空链
+void mempool_chain_init(mempool_chain_t *chain, mempool_t *pool, mempool_t *seg_pool)
+{
+    MEMPOOL_ASSERT(chain != NULL && pool != NULL);
+    MEMPOOL_ASSERT(!seg_pool || seg_pool->block_size >= sizeof(mempool_seg_t));
+
+    chain->pool = pool;
+    chain->seg_pool = seg_pool;
+    chain->head = NULL;
+    chain->tail = NULL;
+    chain->length = 0;
+    chain->segs = 0;
+}
+
+// 释放所有块
+void mempool_chain_free(mempool_chain_t *chain)
+{
+    mempool_chain_release(chain, chain->head);
+    chain->head = NULL;
+    chain->tail = NULL;
+    chain->length = 0;
+    chain->segs = 0;
+}
+
+// 追加数据: 先填满尾段块的剩余空间, 再按需追加新块
+int mempool_chain_append(mempool_chain_t *chain, const uint8_t *data, size_t len)
+{
+    if (len == 0) return 0;
+    if (!data) return -1;
+
+    size_t block_size = chain->pool->block_size;
+    mempool_seg_t *tail = chain->tail;
+    size_t room = 0;
+    if (tail && mempool_chain_exclusive(chain, tail->block)) {
+        room = block_size - tail->offset - tail->length;
+    }
+    size_t in_tail = MEMPOOL_MIN(room, len);
+
+    // 先分配新段, 失败时链保持不变
+    mempool_seg_t *first, *last;
+    if (mempool_chain_new_segs(chain, (len - in_tail + block_size - 1) / block_size, &first, &last) != 0) {
+        return -1;
+    }
+
+    if (in_tail) {
+        memcpy(tail->block + tail->offset + tail->length, data, in_tail);
+        tail->length += (uint32_t)in_tail;
+    }
+
+    size_t done = in_tail;
+    for (mempool_seg_t *seg = first; seg; seg = seg->next) {
+        size_t n = MEMPOOL_MIN(block_size, len - done);
+        memcpy(seg->block, data + done, n);
+        seg->length = (uint32_t)n;
+        done += n;
+        chain->segs++;
+    }
+
+    if (first) {
+        if (tail) {
+            tail->next = first;
+        } else {
+            chain->head = first;
+        }
+        chain->tail = last;
+    }
+    chain->length += len;
+    return 0;
+}
+
+// 前插数据: 先使用首段块的头部空间, 不足时前插新块, 新块数据靠块尾存放以便继续前插
+int mempool_chain_prepend(mempool_chain_t *chain, const uint8_t *data, size_t len)
+{
+    if (len == 0) return 0;
+    if (!data) return -1;
+
+    size_t block_size = chain->pool->block_size;
+    mempool_seg_t *head = chain->head;
+    size_t room = 0;
+    if (head && mempool_chain_exclusive(chain, head->block)) {
+        room = head->offset;
+    }
+    size_t in_head = MEMPOOL_MIN(room, len);
+    size_t rest = len - in_head;
+
+    mempool_seg_t *first, *last;
+    size_t count = (rest + block_size - 1) / block_size;
+    if (mempool_chain_new_segs(chain, count, &first, &last) != 0) {
+        return -1;
+    }
+
+    if (in_head) {
+        head->offset -= (uint32_t)in_head;
+        head->length += (uint32_t)in_head;
+        memcpy(head->block + head->offset, data + rest, in_head);
+    }
+
+    // 第一个新块放不满的部分, 其余新块放满
+    size_t done = 0;
+    for (mempool_seg_t *seg = first; seg; seg = seg->next) {
+        size_t n = (seg == first) ? rest - (count - 1) * block_size : block_size;
+        seg->offset = (uint32_t)(block_size - n);
+        seg->length = (uint32_t)n;
+        memcpy(seg->block + seg->offset, data + done, n);
+        done += n;
+        chain->segs++;
+    }
+
+    if (first) {
+        last->next = head;
+        chain->head = first;
+        if (!head) {
+            chain->tail = last;
+        }
+    }
+    chain->length += len;
+    return 0;
+}
+
+// 零拷贝追加已分配的块
+int mempool_chain_append_block(mempool_chain_t *chain, uint8_t *block, size_t offset, size_t len)
+{
+    mempool_t *pool = chain->pool;
+    if (!block || block < pool->memory_area || block >= pool->memory_area + pool->block_size * pool->block_count ||
+        (size_t)(block - pool->memory_area) % pool->block_size != 0 || offset + len > pool->block_size) {
+        ERROR_PRINT("Invalid block %p (offset %zu, length %zu) for chain %p", block, offset, len, chain);
+        return -1;
+    }
+
+    mempool_seg_t *seg = mempool_chain_seg_alloc(chain);
+    if (!seg) {
+        return -1;
+    }
+    seg->next = NULL;
+    seg->block = block;
+    seg->offset = (uint32_t)offset;
+    seg->length = (uint32_t)len;
+
+    if (chain->tail) {
+        chain->tail->next = seg;
+    } else {
+        chain->head = seg;
+    }
+    chain->tail = seg;
+    chain->length += len;
+    chain->segs++;
+    return 0;
+}
+
+// 拆分
+int mempool_chain_split(mempool_chain_t *chain, size_t at, mempool_chain_t *tail)
+{
+    if (at > chain->length) {
+        return -1;
+    }
+    mempool_chain_init(tail, chain->pool, chain->seg_pool);
+    if (at == chain->length) {
+        return 0;
+    }
+
+    // 定位拆分点所在的段(prev为其前一段)
+    mempool_seg_t *prev = NULL, *seg = chain->head;
+    size_t pos = 0, index = 0;
+    while (pos + seg->length <= at) {
+        pos += seg->length;
+        prev = seg;
+        seg = seg->next;
+        index++;
+    }
+
+    size_t keep = at - pos;
+    if (keep > 0) {
+        // 拆分点在段中间: 为后半段建立新段, 引用计数池共享块, 否则拷贝
+        mempool_seg_t *part = mempool_chain_seg_alloc(chain);
+        if (!part) {
+            return -1;
+        }
+        part->length = seg->length - (uint32_t)keep;
+        if (chain->pool->refcount && mempool_ref(chain->pool, seg->block) == 0) {
+            part->block = seg->block;
+            part->offset = seg->offset + (uint32_t)keep;
+        } else {
+            part->block = mempool_alloc(chain->pool, false);
+            if (!part->block) {
+                mempool_chain_seg_free(chain, part);
+                return -1;
+            }
+            part->offset = 0;
+            memcpy(part->block, seg->block + seg->offset + keep, part->length);
+        }
+        part->next = seg->next;
+        seg->length = (uint32_t)keep;
+        seg->next = NULL;
+
+        tail->head = part;
+        tail->tail = (chain->tail == seg) ? part : chain->tail;
+        tail->segs = chain->segs - index;
+        chain->tail = seg;
+        chain->segs = index + 1;
+    } else {
+        // 拆分点在段边界: 直接断开链表
+        tail->head = seg;
+        tail->tail = chain->tail;
+        tail->segs = chain->segs - index;
+        if (prev) {
+            prev->next = NULL;
+        } else {
+            chain->head = NULL;
+        }
+        chain->tail = prev;
+        chain->segs = index;
+    }
+
+    tail->length = chain->length - at;
+    chain->length = at;
+    return 0;
+}
+
+// 从offset开始拷贝最多len字节, 返回实际拷贝的字节数
+size_t mempool_chain_copy_out(mempool_chain_t *chain, size_t offset, uint8_t *dst, size_t len)
+{
+    size_t done = 0;
+
+    for (mempool_seg_t *seg = chain->head; seg && done < len; seg = seg->next) {
+        if (offset >= seg->length) {
+            offset -= seg->length;
+            continue;
+        }
+        size_t n = MEMPOOL_MIN(seg->length - offset, len - done);
+        memcpy(dst + done, seg->block + seg->offset + offset, n);
+        done += n;
+        offset = 0;
+    }
+    return done;
+}
+
+// 按需线性化
+uint8_t *mempool_chain_linearize(mempool_chain_t *chain)
+{
+    if (!chain->head) {
+        return NULL;
+    }
+    if (chain->segs == 1) {
+        return chain->head->block + chain->head->offset;
+    }
+    if (chain->length > chain->pool->block_size) {
+        DEBUG_PRINT("Chain %p (%zu bytes) does not fit in one block", chain, chain->length);
+        return NULL;
+    }
+
+    uint8_t *block = mempool_alloc(chain->pool, false);
+    if (!block) {
+        return NULL;
+    }
+    mempool_chain_copy_out(chain, 0, block, chain->length);
+
+    // 复用首段描述符, 释放其余段
+    mempool_seg_t *head = chain->head;
+    mempool_chain_release(chain, head->next);
+    mempool_free(chain->pool, head->block);
+    head->next = NULL;
+    head->block = block;
+    head->offset = 0;
+    head->length = (uint32_t)chain->length;
+    chain->tail = head;
+    chain->segs = 1;
+    return block;
+}
+
+// 导出为iovec
+int mempool_chain_to_iovec(mempool_chain_t *chain, struct iovec *iov, int max_iov)
+{
+    if (max_iov < 0 || (size_t)max_iov < chain->segs) {
+        return -1;
+    }
+
+    int n = 0;
+    for (mempool_seg_t *seg = chain->head; seg; seg = seg->next) {
+        iov[n].iov_base = seg->block + seg->offset;
+        iov[n].iov_len = seg->length;
+        n++;
+    }
+    return n;
+}
@@ -0,0 +1,296 @@
+#include "mempool_hist.h"
+#include <string.h>
+
+#ifdef MEMPOOL_LOG_LEVEL
+#undef MEMPOOL_LOG_LEVEL
+#endif
+
+#define MEMPOOL_LOG_LEVEL LOG_LEVEL_ERROR
+#include <mempool_log.h>
+
+#if MEMPOOL_HISTOGRAM_EN
+MEMPOOL_THREAD_LOCAL struct mempool_hist_thread *mempool_hist_self;
+
+// 注册表: 只在线程首次记录、线程退出和查询时访问, 用自旋锁即可
+static int mempool_hist_lock_word;
+static struct mempool_hist_thread *mempool_hist_threads;
+static struct mempool_hist_thread mempool_hist_retired;    // 已退出线程的计数
+static bool mempool_hist_key_created;
+static MEMPOOL_TLS_KEY_TYPE mempool_hist_key;
+
+// TSC校准起点(首个线程注册时记录)
+static uint64_t mempool_hist_ticks0;
+static uint64_t mempool_hist_ns0;
+static uint64_t mempool_hist_ticks_per_sec;    // 校准完成后固定
+
+static void mempool_hist_lock(void)
+{
+    int expected = 0;
+    while (!MEMPOOL_ATOMIC_CAS(&mempool_hist_lock_word, &expected, 1)) {
+        expected = 0;
+        sched_yield();
+    }
+}
+
+static void mempool_hist_unlock(void)
+{
+    MEMPOOL_ATOMIC_STORE(&mempool_hist_lock_word, 0);
+}
+
+// 线程退出: 计数合并到retired后释放
+static void mempool_hist_thread_exit(void *arg)
+{
+    struct mempool_hist_thread *hist = (struct mempool_hist_thread *)arg;
+
+    mempool_hist_lock();
+    struct mempool_hist_thread **pp = &mempool_hist_threads;
+    while (*pp && *pp != hist) {
+        pp = &(*pp)->next;
+    }
+    if (*pp) {
+        *pp = hist->next;
+    }
+    for (int op = 0; op < MEMPOOL_HIST_OPS; op++) {
+        for (int b = 0; b < MEMPOOL_HIST_BUCKETS; b++) {
+            mempool_hist_retired.counts[op][b] += hist->counts[op][b];
+            mempool_hist_retired.base_counts[op][b] += hist->base_counts[op][b];
+        }
+        mempool_hist_retired.sum[op] += hist->sum[op];
+        mempool_hist_retired.base_sum[op] += hist->base_sum[op];
+    }
+    mempool_hist_unlock();
+
+    mempool_hist_self = NULL;
+    MEMPOOL_FREE(hist);
+}
+
+struct mempool_hist_thread *mempool_hist_register(void)
+{
+    struct mempool_hist_thread *hist = MEMPOOL_MALLOC(sizeof(*hist));
+    if (!hist) {
+        ERROR_PRINT("Failed to allocate latency histogram");
+        return NULL;
+    }
+    memset(hist, 0, sizeof(*hist));
+
+    mempool_hist_lock();
+    if (!mempool_hist_key_created) {
+        if (MEMPOOL_TLS_KEY_CREATE(&mempool_hist_key, mempool_hist_thread_exit) != 0) {
+            mempool_hist_unlock();
+            MEMPOOL_FREE(hist);
+            ERROR_PRINT("Failed to create histogram TLS key");
+            return NULL;
+        }
+        mempool_hist_key_created = true;
+        mempool_hist_ticks0 = MEMPOOL_TICKS();
+        mempool_hist_ns0 = MEMPOOL_CURRENT_TIME_NS();
+    }
+    hist->next = mempool_hist_threads;
+    mempool_hist_threads = hist;
+    mempool_hist_unlock();
+
+    MEMPOOL_TLS_SET(mempool_hist_key, hist);
+    mempool_hist_self = hist;
+    return hist;
+}
+
+// 每纳秒的计时单位数: 按注册以来经过的时间校准, 不足10ms时等待, 超过1s后固定
+static double mempool_hist_rate(void)
+{
+#if MEMPOOL_TICKS_ARE_NS
+    return 1.0;
+#else
+    uint64_t per_sec = MEMPOOL_ATOMIC_LOAD_RELAXED(&mempool_hist_ticks_per_sec);
+    if (per_sec) {
+        return (double)per_sec / 1e9;
+    }
+
+    mempool_hist_lock();
+    uint64_t ticks0 = mempool_hist_ticks0;
+    uint64_t ns0 = mempool_hist_ns0;
+    mempool_hist_unlock();
+
+    uint64_t ns = MEMPOOL_CURRENT_TIME_NS() - ns0;
+    if (ns < 10000000ull) {
+        MEMPOOL_DELAY_MS(10 - ns / 1000000ull);
+    }
+    uint64_t ticks = MEMPOOL_TICKS() - ticks0;
+    ns = MEMPOOL_CURRENT_TIME_NS() - ns0;
+
+    double rate = (double)ticks / (double)ns;
+    if (ns >= 1000000000ull) {
+        MEMPOOL_ATOMIC_STORE_RELAXED(&mempool_hist_ticks_per_sec, (uint64_t)(rate * 1e9));
+    }
+    return rate;
+#endif
+}
+
+// 桶内最大值(计时单位)
+static uint64_t mempool_hist_bucket_upper(unsigned bucket)
+{
+    if (bucket < MEMPOOL_HIST_SUB_BUCKETS) {
+        return bucket;
+    }
+    unsigned shift = bucket / MEMPOOL_HIST_SUB_BUCKETS - 1;
+    uint64_t lower = (uint64_t)(MEMPOOL_HIST_SUB_BUCKETS + bucket % MEMPOOL_HIST_SUB_BUCKETS) << shift;
+    return lower + ((1ull << shift) - 1);
+}
+
+static void mempool_hist_add(const struct mempool_hist_thread *hist, mempool_hist_op_t op,
+                             uint64_t *counts, uint64_t *sum)
+{
+    for (int b = 0; b < MEMPOOL_HIST_BUCKETS; b++) {
+        counts[b] += MEMPOOL_ATOMIC_LOAD_RELAXED(&hist->counts[op][b]) - hist->base_counts[op][b];
+    }
+    *sum += MEMPOOL_ATOMIC_LOAD_RELAXED(&hist->sum[op]) - hist->base_sum[op];
+}
+
+// 汇总所有线程的计数, 返回样本总数
+static uint64_t mempool_hist_collect(mempool_hist_op_t op, uint64_t *counts, uint64_t *sum)
+{
+    uint64_t total = 0;
+
+    memset(counts, 0, sizeof(uint64_t) * MEMPOOL_HIST_BUCKETS);
+    *sum = 0;
+
+    mempool_hist_lock();
+    mempool_hist_add(&mempool_hist_retired, op, counts, sum);
+    for (struct mempool_hist_thread *hist = mempool_hist_threads; hist; hist = hist->next) {
+        mempool_hist_add(hist, op, counts, sum);
+    }
+    mempool_hist_unlock();
+
+    for (int b = 0; b < MEMPOOL_HIST_BUCKETS; b++) {
+        total += counts[b];
+    }
+    return total;
+}
+
+// 第rank个样本(从1开始)所在桶的上界
+static uint64_t mempool_hist_rank(const uint64_t *counts, uint64_t rank)
+{
+    uint64_t seen = 0;
+    for (unsigned b = 0; b < MEMPOOL_HIST_BUCKETS; b++) {
+        seen += counts[b];
+        if (seen >= rank) {
+            return mempool_hist_bucket_upper(b);
+        }
+    }
+    return 0;
+}
+
+static uint64_t mempool_hist_value(const uint64_t *counts, uint64_t total, double percentile, double rate)
+{
+    uint64_t rank = (uint64_t)(percentile / 100.0 * (double)total + 0.999999);
+    if (rank == 0) rank = 1;
+    if (rank > total) rank = total;
+    return (uint64_t)((double)mempool_hist_rank(counts, rank) / rate);
+}
+
+static void mempool_hist_snapshot(struct mempool_hist_thread *hist)
+{
+    for (int op = 0; op < MEMPOOL_HIST_OPS; op++) {
+        for (int b = 0; b < MEMPOOL_HIST_BUCKETS; b++) {
+            hist->base_counts[op][b] = MEMPOOL_ATOMIC_LOAD_RELAXED(&hist->counts[op][b]);
+        }
+        hist->base_sum[op] = MEMPOOL_ATOMIC_LOAD_RELAXED(&hist->sum[op]);
+    }
+}
+#endif
+
+// 汇总指定操作的延迟分布
+int mempool_hist_summary(mempool_hist_op_t op, mempool_hist_summary_t *summary)
+{
+#if MEMPOOL_HISTOGRAM_EN
+    if (!summary || (unsigned)op >= MEMPOOL_HIST_OPS) return -1;
+
+    uint64_t counts[MEMPOOL_HIST_BUCKETS];
+    uint64_t sum;
+    uint64_t total = mempool_hist_collect(op, counts, &sum);
+
+    memset(summary, 0, sizeof(*summary));
+    summary->count = total;
+    if (total == 0) {
+        return 0;
+    }
+
+    double rate = mempool_hist_rate();
+    summary->mean_ns = (uint64_t)((double)sum / (double)total / rate);
+    summary->p50_ns = mempool_hist_value(counts, total, 50.0, rate);
+    summary->p90_ns = mempool_hist_value(counts, total, 90.0, rate);
+    summary->p99_ns = mempool_hist_value(counts, total, 99.0, rate);
+    summary->p999_ns = mempool_hist_value(counts, total, 99.9, rate);
+    summary->max_ns = mempool_hist_value(counts, total, 100.0, rate);
+    return 0;
+#else
+    (void)op;
+    (void)summary;
+    return -1;
+#endif
+}
+
+// 指定百分位的延迟
+int mempool_hist_percentile(mempool_hist_op_t op, double percentile, uint64_t *ns)
+{
+#if MEMPOOL_HISTOGRAM_EN
+    if (!ns || (unsigned)op >= MEMPOOL_HIST_OPS || percentile < 0.0 || percentile > 100.0) return -1;
+
+    uint64_t counts[MEMPOOL_HIST_BUCKETS];
+    uint64_t sum;
+    uint64_t total = mempool_hist_collect(op, counts, &sum);
+    if (total == 0) {
+        return -1;
+    }
+
+    *ns = mempool_hist_value(counts, total, percentile, mempool_hist_rate());
+    return 0;
+#else
+    (void)op;
+    (void)percentile;
+    (void)ns;
+    return -1;
+#endif
+}
+
+// 打印百分位表
+int mempool_hist_dump(FILE *fp)
+{
+#if MEMPOOL_HISTOGRAM_EN
+    static const char *const names[MEMPOOL_HIST_OPS] = { "alloc", "free", "enqueue", "dequeue" };
+
+    if (!fp) return -1;
+
+    fprintf(fp, "%-8s %12s %10s %10s %10s %10s %10s %10s\n",
+            "op", "count", "mean(ns)", "p50", "p90", "p99", "p99.9", "max");
+    for (int op = 0; op < MEMPOOL_HIST_OPS; op++) {
+        mempool_hist_summary_t s;
+        if (mempool_hist_summary((mempool_hist_op_t)op, &s) != 0) {
+            return -1;
+        }
+        fprintf(fp, "%-8s %12llu %10llu %10llu %10llu %10llu %10llu %10llu\n", names[op],
+                (unsigned long long)s.count, (unsigned long long)s.mean_ns, (unsigned long long)s.p50_ns,
+                (unsigned long long)s.p90_ns, (unsigned long long)s.p99_ns, (unsigned long long)s.p999_ns,
+                (unsigned long long)s.max_ns);
+    }
+    return 0;
+#else
+    (void)fp;
+    return -1;
+#endif
+}
+
+// 清零: 记录各线程当前计数为快照, 不修改线程自己写入的计数
+int mempool_hist_reset(void)
+{
+#if MEMPOOL_HISTOGRAM_EN
+    mempool_hist_lock();
+    mempool_hist_snapshot(&mempool_hist_retired);
+    for (struct mempool_hist_thread *hist = mempool_hist_threads; hist; hist = hist->next) {
+        mempool_hist_snapshot(hist);
+    }
+    mempool_hist_unlock();
+    return 0;
+#else
+    return -1;
+#endif
+}
@@ -0,0 +1,257 @@
+#define _GNU_SOURCE // sched_getcpu
+#include "mempool_numa.h"
+#include <string.h>
+
+#ifdef MEMPOOL_LOG_LEVEL
+#undef MEMPOOL_LOG_LEVEL
+#endif
+
+#define MEMPOOL_LOG_LEVEL LOG_LEVEL_ERROR
+#include <mempool_log.h>
+
+#define NUMA_MASK_LONGS     (MEMPOOL_NUMA_MAX_NODES / (8 * sizeof(unsigned long)) + 1)
+
+static MEMPOOL_THREAD_LOCAL unsigned numa_stats_slot;  // 本线程分片号+1(0表示未分配)
+static unsigned numa_stats_next_slot;
+
+static inline struct mempool_numa_shard *numa_stats_shard(struct mempool_numa_node *n)
+{
+    if (numa_stats_slot == 0) {
+        numa_stats_slot = MEMPOOL_ATOMIC_ADD_RELAXED(&numa_stats_next_slot, 1) + 1;
+    }
+    return &n->stats[(numa_stats_slot - 1) & (MEMPOOL_NUMA_STATS_SHARDS - 1)];
+}
+
+// 系统最大节点号+1(无NUMA信息时为1)
+int mempool_numa_node_count(void)
+{
+    int count = 1;
+
+    for (int node = 0; node < MEMPOOL_NUMA_MAX_NODES; node++) {
+        if (MEMPOOL_NUMA_NODE_EXISTS(node)) {
+            count = node + 1;
+        }
+    }
+    return count;
+}
+
+// 在绑定到node的线程内存策略下创建内存池, 创建后恢复原策略;
+// 内存区域强制预取, 使物理页在创建时按策略落到目标节点
+static mempool_t *mempool_numa_create_pool(size_t data_size, size_t num_blocks, int node, uint32_t flags, bool *bound)
+{
+    int old_mode = 0;
+    unsigned long old_mask[NUMA_MASK_LONGS] = { 0 };
+    unsigned long mask[NUMA_MASK_LONGS] = { 0 };
+
+    mask[node / (8 * sizeof(unsigned long))] = 1ul << (node % (8 * sizeof(unsigned long)));
+
+    *bound = MEMPOOL_NUMA_GET_POLICY(&old_mode, old_mask) == 0 &&
+             MEMPOOL_NUMA_SET_POLICY(MEMPOOL_NUMA_POLICY_BIND, mask) == 0;
+    if (!*bound) {
+        WARNING_PRINT("Failed to bind memory policy to node %d, pool placement is not guaranteed", node);
+    }
+
+    mempool_t *pool = mempool_create_flags(data_size, num_blocks, flags | MEMPOOL_FLAG_PREFAULT);
+
+    if (*bound) {
+        MEMPOOL_NUMA_SET_POLICY(old_mode, old_mask);
+    }
+    return pool;
+}
+
+// 在指定节点上创建单个内存池
+mempool_t *mempool_create_on_node(size_t data_size, size_t num_blocks, int node, uint32_t flags)
+{
+    if (node < 0 || node >= mempool_numa_node_count() || (node > 0 && !MEMPOOL_NUMA_NODE_EXISTS(node))) {
+        ERROR_PRINT("NUMA node %d does not exist", node);
+        return NULL;
+    }
+
+    bool bound;
+    return mempool_numa_create_pool(data_size, num_blocks, node, flags, &bound);
+}
+
+// 读取节点距离并生成远端回退顺序(读取失败时按节点号轮转)
+static void mempool_numa_build_fallback(mempool_numa_t *numa, int node)
+{
+    struct mempool_numa_node *n = &numa->nodes[node];
+    int distance[MEMPOOL_NUMA_MAX_NODES];
+
+    for (size_t i = 0; i < numa->num_nodes; i++) {
+        distance[i] = (int)((i + numa->num_nodes - (size_t)node) % numa->num_nodes);
+    }
+
+    FILE *fp = MEMPOOL_NUMA_DISTANCE_FILE(node);
+    if (fp) {
+        for (size_t i = 0; i < numa->num_nodes && fscanf(fp, "%d", &distance[i]) == 1; i++)
+            ;
+        fclose(fp);
+    }
+
+    // 按距离插入排序(节点数很少)
+    n->fallback_count = 0;
+    for (size_t i = 0; i < numa->num_nodes; i++) {
+        if ((int)i == node || !numa->nodes[i].pool) continue;
+
+        size_t j = n->fallback_count++;
+        while (j > 0 && distance[n->fallback[j - 1]] > distance[i]) {
+            n->fallback[j] = n->fallback[j - 1];
+            j--;
+        }
+        n->fallback[j] = (uint8_t)i;
+    }
+}
+
+// 每个节点创建一个子池
+mempool_numa_t *mempool_numa_create(size_t data_size, size_t blocks_per_node, uint32_t flags)
+{
+    mempool_numa_t *numa = MEMPOOL_MEMALIGN(MEMPOOL_ALIGNMENT, sizeof(mempool_numa_t));
+    if (!numa) {
+        ERROR_PRINT("Failed to allocate NUMA control structure");
+        return NULL;
+    }
+    memset(numa, 0, sizeof(*numa));
+
+    numa->num_nodes = (size_t)mempool_numa_node_count();
+    numa->cpu_count = MEMPOOL_CPU_COUNT();
+    if (numa->cpu_count < 1) numa->cpu_count = 1;
+
+    numa->cpu_to_node = MEMPOOL_MALLOC((size_t)numa->cpu_count);
+    if (!numa->cpu_to_node) {
+        MEMPOOL_FREE(numa);
+        return NULL;
+    }
+    memset(numa->cpu_to_node, 0, (size_t)numa->cpu_count);
+
+    for (size_t node = 0; node < numa->num_nodes; node++) {
+        // 单节点系统可能没有sysfs节点目录, 仍创建一个子池
+        if (numa->num_nodes > 1 && !MEMPOOL_NUMA_NODE_EXISTS((int)node)) continue;
+
+        numa->nodes[node].pool = mempool_numa_create_pool(data_size, blocks_per_node, (int)node, flags,
+                                                          &numa->nodes[node].bound);
+        if (!numa->nodes[node].pool) {
+            ERROR_PRINT("Failed to create pool on NUMA node %zu", node);
+            mempool_numa_destroy(numa);
+            return NULL;
+        }
+
+        for (int cpu = 0; cpu < numa->cpu_count; cpu++) {
+            if (MEMPOOL_NUMA_CPU_ON_NODE(cpu, (int)node)) {
+                numa->cpu_to_node[cpu] = (uint8_t)node;
+            }
+        }
+    }
+
+    for (size_t node = 0; node < numa->num_nodes; node++) {
+        if (numa->nodes[node].pool) {
+            mempool_numa_build_fallback(numa, (int)node);
+        }
+    }
+
+    DEBUG_PRINT("NUMA mempool created: %zu nodes, %d cpus", numa->num_nodes, numa->cpu_count);
+    return numa;
+}
+
+// 销毁
+void mempool_numa_destroy(mempool_numa_t *numa)
+{
+    MEMPOOL_ASSERT(numa != NULL);
+
+    for (size_t node = 0; node < numa->num_nodes; node++) {
+        if (numa->nodes[node].pool) {
+            mempool_destroy(numa->nodes[node].pool);
+        }
+    }
+    MEMPOOL_FREE(numa->cpu_to_node);
+    MEMPOOL_FREE(numa);
+}
+
+// 调用线程当前所在节点
+int mempool_numa_current_node(mempool_numa_t *numa)
+{
+    int cpu = MEMPOOL_CURRENT_CPU();
+    if (cpu < 0 || cpu >= numa->cpu_count) {
+        return 0;
+    }
+    return numa->cpu_to_node[cpu];
+}
+
+// 优先从node分配, 耗尽时按距离回退
+uint8_t *mempool_numa_alloc_on(mempool_numa_t *numa, int node, bool for_hw)
+{
+    if (node < 0 || (size_t)node >= numa->num_nodes || !numa->nodes[node].pool) {
+        return NULL;
+    }
+
+    struct mempool_numa_node *n = &numa->nodes[node];
+    uint8_t *block = mempool_alloc(n->pool, for_hw);
+    if (block) {
+        MEMPOOL_ATOMIC_ADD_RELAXED(&numa_stats_shard(n)->local_hits, 1);
+        return block;
+    }
+
+    for (size_t i = 0; i < n->fallback_count; i++) {
+        block = mempool_alloc(numa->nodes[n->fallback[i]].pool, for_hw);
+        if (block) {
+            MEMPOOL_ATOMIC_ADD_RELAXED(&numa_stats_shard(n)->remote_hits, 1);
+            return block;
+        }
+    }
+
+    MEMPOOL_ATOMIC_ADD_RELAXED(&numa_stats_shard(n)->failures, 1);
+    DEBUG_PRINT("All NUMA nodes exhausted (requested on node %d)", node);
+    return NULL;
+}
+
+// 从调用线程所在节点分配
+uint8_t *mempool_numa_alloc(mempool_numa_t *numa, bool for_hw)
+{
+    return mempool_numa_alloc_on(numa, mempool_numa_current_node(numa), for_hw);
+}
+
+// 指针所在节点, 非法指针返回-1
+int mempool_numa_node_of(mempool_numa_t *numa, uint8_t *ptr)
+{
+    for (size_t node = 0; node < numa->num_nodes; node++) {
+        mempool_t *pool = numa->nodes[node].pool;
+        if (pool && ptr >= pool->memory_area && ptr < pool->memory_area + pool->block_size * pool->block_count) {
+            return (int)node;
+        }
+    }
+    return -1;
+}
+
+// 释放到块所属的节点子池
+void mempool_numa_free(mempool_numa_t *numa, uint8_t *ptr)
+{
+    int node = mempool_numa_node_of(numa, ptr);
+    if (node < 0) {
+        ERROR_PRINT("Invalid pointer %p for NUMA mempool %p", ptr, numa);
+        return;
+    }
+    mempool_free(numa->nodes[node].pool, ptr);
+}
+
+// 按节点获取子池
+mempool_t *mempool_numa_pool(mempool_numa_t *numa, int node)
+{
+    if (node < 0 || (size_t)node >= numa->num_nodes) return NULL;
+    return numa->nodes[node].pool;
+}
+
+// 获取节点统计: 汇总各分片, 不加锁
+int mempool_numa_get_stats(mempool_numa_t *numa, int node, mempool_numa_stats_t *stats)
+{
+    if (node < 0 || (size_t)node >= numa->num_nodes || !numa->nodes[node].pool || !stats) {
+        return -1;
+    }
+
+    struct mempool_numa_node *n = &numa->nodes[node];
+    memset(stats, 0, sizeof(*stats));
+    for (size_t i = 0; i < MEMPOOL_NUMA_STATS_SHARDS; i++) {
+        stats->local_hits += MEMPOOL_ATOMIC_LOAD_RELAXED(&n->stats[i].local_hits);
+        stats->remote_hits += MEMPOOL_ATOMIC_LOAD_RELAXED(&n->stats[i].remote_hits);
+        stats->failures += MEMPOOL_ATOMIC_LOAD_RELAXED(&n->stats[i].failures);
+    }
+    return 0;
+}
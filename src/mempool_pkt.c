@@ -0,0 +1,90 @@
+#include "mempool_pkt.h"
+
+#ifdef MEMPOOL_LOG_LEVEL
+#undef MEMPOOL_LOG_LEVEL
+#endif
+
+#define MEMPOOL_LOG_LEVEL LOG_LEVEL_ERROR
+#include <mempool_log.h>
+
+// 块大小需能用打包格式的半字表示
+#define PKT_FIELD_MAX   (((size_t)1 << MEMPOOL_PKT_SHIFT) - 1)
+
+// 分配块并预留头部空间
+int mempool_pkt_alloc(mempool_t *pool, size_t headroom, mempool_pkt_t *pkt)
+{
+    if (!pool || !pkt || headroom > pool->block_size || pool->block_size > PKT_FIELD_MAX) {
+        return -1;
+    }
+
+    uint8_t *block = mempool_alloc(pool, false);
+    if (!block) {
+        DEBUG_PRINT("Pool %p exhausted", pool);
+        return -1;
+    }
+
+    pkt->block = block;
+    pkt->offset = (uint32_t)headroom;
+    pkt->length = 0;
+    pkt->size = (uint32_t)pool->block_size;
+    return 0;
+}
+
+// 在已有块上建立视图
+int mempool_pkt_attach(mempool_t *pool, uint8_t *block, size_t offset, size_t length, mempool_pkt_t *pkt)
+{
+    if (!pool || !pkt || pool->block_size > PKT_FIELD_MAX || block < pool->memory_area ||
+        block >= pool->memory_area + pool->block_size * pool->block_count ||
+        (size_t)(block - pool->memory_area) % pool->block_size != 0 || offset + length > pool->block_size) {
+        ERROR_PRINT("Invalid block %p (offset %zu, length %zu) for pool %p", block, offset, length, pool);
+        return -1;
+    }
+
+    pkt->block = block;
+    pkt->offset = (uint32_t)offset;
+    pkt->length = (uint32_t)length;
+    pkt->size = (uint32_t)pool->block_size;
+    return 0;
+}
+
+// 释放块
+void mempool_pkt_free(mempool_t *pool, mempool_pkt_t *pkt)
+{
+    mempool_free(pool, pkt->block);
+    pkt->block = NULL;
+    pkt->offset = 0;
+    pkt->length = 0;
+}
+
+// 入队: 偏移与长度打包到data_length
+int mempool_pkt_enqueue(mempool_queue_t *queue, const mempool_pkt_t *pkt)
+{
+    return mempool_queue_enqueue_with_length(queue, pkt->block, MEMPOOL_PKT_PACK(pkt->offset, pkt->length));
+}
+
+// 出队后还原视图
+static int mempool_pkt_unpack(mempool_queue_t *queue, uint8_t *block, size_t packed, mempool_pkt_t *pkt)
+{
+    if (!block) {
+        return -1;
+    }
+    pkt->block = block;
+    pkt->offset = MEMPOOL_PKT_OFFSET(packed);
+    pkt->length = MEMPOOL_PKT_LENGTH(packed);
+    pkt->size = (uint32_t)queue->pool->block_size;
+    return 0;
+}
+
+int mempool_pkt_dequeue(mempool_queue_t *queue, mempool_pkt_t *pkt)
+{
+    size_t packed = 0;
+    uint8_t *block = mempool_queue_dequeue_with_length(queue, &packed);
+    return mempool_pkt_unpack(queue, block, packed, pkt);
+}
+
+int mempool_pkt_dequeue_timed(mempool_queue_t *queue, mempool_pkt_t *pkt, uint64_t timeout_ns)
+{
+    size_t packed = 0;
+    uint8_t *block = mempool_queue_dequeue_timed(queue, &packed, timeout_ns);
+    return mempool_pkt_unpack(queue, block, packed, pkt);
+}
@@ -0,0 +1,220 @@
+#include "mempool_prio.h"
+
+#ifdef MEMPOOL_LOG_LEVEL
+#undef MEMPOOL_LOG_LEVEL
+#endif
+
+#define MEMPOOL_LOG_LEVEL LOG_LEVEL_ERROR
+#include <mempool_log.h>
+
+void mempool_prio_init(mempool_prio_t *prio, uint32_t discipline)
+{
+    MEMPOOL_ASSERT(prio != NULL && discipline <= MEMPOOL_PRIO_DRR);
+
+    prio->head = NULL;
+    prio->tail = NULL;
+    prio->current = NULL;
+    prio->current_cls = 0;
+    prio->classes = 0;
+    prio->discipline = discipline;
+    prio->in_turn = false;
+    prio->cost = NULL;
+}
+
+// 类别以sched_weight非0标记已加入集合(严格优先级也记录为1)
+int mempool_prio_add(mempool_prio_t *prio, mempool_queue_t *queue, uint32_t weight)
+{
+    if (!prio || !queue || queue->sched_weight != 0) {
+        return -1;
+    }
+    if (prio->discipline != MEMPOOL_PRIO_STRICT && weight == 0) {
+        ERROR_PRINT("Weight of queue %p must be positive", queue);
+        return -1;
+    }
+
+    queue->next = NULL;
+    queue->sched_weight = weight ? weight : 1;
+    queue->sched_deficit = 0;
+    if (prio->tail) {
+        prio->tail->next = queue;
+    } else {
+        prio->head = queue;
+        prio->current = queue;
+        prio->current_cls = 0;
+    }
+    prio->tail = queue;
+
+    DEBUG_PRINT("Queue %p added to priority set %p as class %zu (weight %u)", queue, prio, prio->classes, weight);
+    return (int)prio->classes++;
+}
+
+void mempool_prio_clear(mempool_prio_t *prio)
+{
+    mempool_queue_t *queue = prio->head;
+    while (queue) {
+        mempool_queue_t *next = queue->next;
+        queue->next = NULL;
+        queue->sched_weight = 0;
+        queue->sched_deficit = 0;
+        queue = next;
+    }
+    mempool_prio_init(prio, prio->discipline);
+}
+
+// 轮到下一个类别, 最低优先级之后回到最高优先级
+static inline void prio_advance(mempool_prio_t *prio)
+{
+    prio->in_turn = false;
+    if (prio->current->next) {
+        prio->current = prio->current->next;
+        prio->current_cls++;
+    } else {
+        prio->current = prio->head;
+        prio->current_cls = 0;
+    }
+}
+
+//===================================================================
+//  严格优先级
+//===================================================================
+static uint8_t *prio_dequeue_strict(mempool_prio_t *prio, size_t *data_length, size_t *cls)
+{
+    size_t c = 0;
+    for (mempool_queue_t *queue = prio->head; queue; queue = queue->next, c++) {
+        uint8_t *buffer = mempool_queue_dequeue_with_length(queue, data_length);
+        if (buffer) {
+            if (cls) *cls = c;
+            return buffer;
+        }
+    }
+    return NULL;
+}
+
+static size_t prio_dequeue_batch_strict(mempool_prio_t *prio, uint8_t **buffers, size_t *data_lengths, size_t max_count)
+{
+    size_t got = 0;
+    for (mempool_queue_t *queue = prio->head; queue && got < max_count; queue = queue->next) {
+        got += mempool_queue_dequeue_batch_with_length(queue, &buffers[got],
+                                                       data_lengths ? &data_lengths[got] : NULL, max_count - got);
+    }
+    return got;
+}
+
+//===================================================================
+//  加权轮询: sched_deficit为当前类别本轮剩余可出队块数, 为0时开始新的一轮
+//===================================================================
+static size_t prio_dequeue_batch_wrr(mempool_prio_t *prio, uint8_t **buffers, size_t *data_lengths,
+                                     size_t max_count, size_t *cls)
+{
+    size_t got = 0;
+
+    // 连续遇到classes个空类别时说明所有类别为空
+    for (size_t empty = 0; got < max_count && empty < prio->classes; ) {
+        mempool_queue_t *queue = prio->current;
+        if (queue->sched_deficit == 0) {
+            queue->sched_deficit = queue->sched_weight;
+        }
+
+        size_t want = MEMPOOL_MIN(queue->sched_deficit, max_count - got);
+        size_t n = mempool_queue_dequeue_batch_with_length(queue, &buffers[got],
+                                                           data_lengths ? &data_lengths[got] : NULL, want);
+        if (n && cls) *cls = prio->current_cls;
+        got += n;
+        queue->sched_deficit -= n;
+        if (n < want) {
+            queue->sched_deficit = 0; // 队列已空, 放弃本轮剩余份额
+        }
+        if (queue->sched_deficit == 0) {
+            prio_advance(prio);
+            empty = n ? 0 : empty + 1;
+        }
+    }
+    return got;
+}
+
+//===================================================================
+//  差额轮询: 类别每次轮到时增加sched_weight字节额度, 队首块的计费长度不超过剩余额度时出队;
+//  额度不足时轮到下一个类别(额度保留到下一轮), 队列变空时额度清0
+//===================================================================
+static uint8_t *prio_dequeue_drr(mempool_prio_t *prio, size_t *data_length, size_t *cls)
+{
+    for (size_t empty = 0; empty < prio->classes; ) {
+        mempool_queue_t *queue = prio->current;
+        size_t length;
+
+        if (!mempool_queue_peek_with_length(queue, &length)) {
+            queue->sched_deficit = 0;
+            prio_advance(prio);
+            empty++;
+            continue;
+        }
+        empty = 0;
+
+        if (!prio->in_turn) {
+            queue->sched_deficit += queue->sched_weight;
+            prio->in_turn = true;
+        }
+
+        size_t cost = prio->cost ? prio->cost(length) : length;
+        if (cost > queue->sched_deficit) {
+            prio_advance(prio);
+            continue;
+        }
+
+        uint8_t *buffer = mempool_queue_dequeue_with_length(queue, data_length);
+        MEMPOOL_ASSERT(buffer != NULL); // 单个调度线程出队, 查看到的块不会被取走
+        queue->sched_deficit -= cost;
+        if (cls) *cls = prio->current_cls;
+        return buffer;
+    }
+    return NULL;
+}
+
+uint8_t *mempool_prio_dequeue(mempool_prio_t *prio, size_t *data_length, size_t *cls)
+{
+    if (!prio || !prio->head) {
+        return NULL;
+    }
+
+    switch (prio->discipline) {
+    case MEMPOOL_PRIO_WRR: {
+        uint8_t *buffer;
+        return prio_dequeue_batch_wrr(prio, &buffer, data_length, 1, cls) ? buffer : NULL;
+    }
+    case MEMPOOL_PRIO_DRR:
+        return prio_dequeue_drr(prio, data_length, cls);
+    default:
+        return prio_dequeue_strict(prio, data_length, cls);
+    }
+}
+
+size_t mempool_prio_dequeue_batch(mempool_prio_t *prio, uint8_t **buffers, size_t *data_lengths, size_t max_count)
+{
+    if (!prio || !prio->head || !buffers || max_count == 0) {
+        return 0;
+    }
+
+    switch (prio->discipline) {
+    case MEMPOOL_PRIO_WRR:
+        return prio_dequeue_batch_wrr(prio, buffers, data_lengths, max_count, NULL);
+    case MEMPOOL_PRIO_DRR: {
+        size_t got = 0;
+        while (got < max_count &&
+               (buffers[got] = prio_dequeue_drr(prio, data_lengths ? &data_lengths[got] : NULL, NULL)) != NULL) {
+            got++;
+        }
+        return got;
+    }
+    default:
+        return prio_dequeue_batch_strict(prio, buffers, data_lengths, max_count);
+    }
+}
+
+size_t mempool_prio_count(mempool_prio_t *prio)
+{
+    size_t count = 0;
+    for (mempool_queue_t *queue = prio ? prio->head : NULL; queue; queue = queue->next) {
+        count += mempool_queue_count(queue);
+    }
+    return count;
+}
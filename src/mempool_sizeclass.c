@@ -0,0 +1,205 @@
+#include "mempool_sizeclass.h"
+#include <string.h>
+
+#ifdef MEMPOOL_LOG_LEVEL
+#undef MEMPOOL_LOG_LEVEL
+#endif
+
+#define MEMPOOL_LOG_LEVEL LOG_LEVEL_ERROR
+#include <mempool_log.h>
+
+#define SIZECLASS_CHUNK_SIZE    ((size_t)1 << MEMPOOL_SIZECLASS_CHUNK_SHIFT)
+#define SIZECLASS_ALIGN(x, a)   (((x) + (a) - 1) & ~((a) - 1))
+
+static MEMPOOL_THREAD_LOCAL unsigned sizeclass_stats_slot;  // 本线程分片号+1(0表示未分配)
+static unsigned sizeclass_stats_next_slot;
+
+static inline struct mempool_sizeclass_shard *sizeclass_stats_shard(struct mempool_sizeclass_class *c)
+{
+    if (sizeclass_stats_slot == 0) {
+        sizeclass_stats_slot = MEMPOOL_ATOMIC_ADD_RELAXED(&sizeclass_stats_next_slot, 1) + 1;
+    }
+    return &c->stats[(sizeclass_stats_slot - 1) & (MEMPOOL_SIZECLASS_STATS_SHARDS - 1)];
+}
+
+// 创建多级分配器: 按级别大小排序后在一块连续内存上依次创建各级内存池
+mempool_sizeclass_t *mempool_sizeclass_create(const mempool_sizeclass_config_t *config, size_t num_classes, uint32_t flags)
+{
+    if (!config || num_classes == 0 || num_classes > MEMPOOL_SIZECLASS_MAX_CLASSES) {
+        return NULL;
+    }
+
+    // 按大小升序排序(级别数很少, 插入排序即可)
+    mempool_sizeclass_config_t sorted[MEMPOOL_SIZECLASS_MAX_CLASSES];
+    for (size_t i = 0; i < num_classes; i++) {
+        if (config[i].size == 0 || config[i].num_blocks == 0) {
+            return NULL;
+        }
+        size_t j = i;
+        while (j > 0 && sorted[j - 1].size > config[i].size) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = config[i];
+    }
+
+    mempool_sizeclass_t *sc = MEMPOOL_MEMALIGN(MEMPOOL_ALIGNMENT, sizeof(mempool_sizeclass_t));
+    if (!sc) {
+        ERROR_PRINT("Failed to allocate sizeclass control structure");
+        return NULL;
+    }
+    memset(sc, 0, sizeof(*sc));
+
+    // 计算各级内存区域偏移(按反查粒度对齐, 保证每个粒度单元只属于一个级别)
+    size_t offsets[MEMPOOL_SIZECLASS_MAX_CLASSES];
+    size_t arena_size = 0;
+    for (size_t i = 0; i < num_classes; i++) {
+        size_t block_size = SIZECLASS_ALIGN(sorted[i].size, MEMPOOL_ALIGNMENT);
+        offsets[i] = arena_size;
+        arena_size += SIZECLASS_ALIGN(block_size * sorted[i].num_blocks, SIZECLASS_CHUNK_SIZE);
+    }
+
+    sc->num_classes = num_classes;
+    sc->arena_size = arena_size;
+    sc->max_size = SIZECLASS_ALIGN(sorted[num_classes - 1].size, MEMPOOL_ALIGNMENT);
+    sc->arena = MEMPOOL_MEMALIGN(SIZECLASS_CHUNK_SIZE, arena_size);
+    sc->size_to_class = MEMPOOL_MALLOC(sc->max_size / MEMPOOL_ALIGNMENT + 1);
+    sc->chunk_to_class = MEMPOOL_MALLOC(arena_size >> MEMPOOL_SIZECLASS_CHUNK_SHIFT);
+    if (!sc->arena || !sc->size_to_class || !sc->chunk_to_class) {
+        ERROR_PRINT("Failed to allocate sizeclass arena or lookup tables");
+        mempool_sizeclass_destroy(sc);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < num_classes; i++) {
+        mempool_t *pool = mempool_create_with_area(sc->arena + offsets[i], sorted[i].size, sorted[i].num_blocks, flags);
+        if (!pool) {
+            ERROR_PRINT("Failed to create pool for size class %zu", sorted[i].size);
+            mempool_sizeclass_destroy(sc);
+            return NULL;
+        }
+        sc->classes[i].pool = pool;
+
+        size_t end = (i + 1 < num_classes) ? offsets[i + 1] : arena_size;
+        memset(sc->chunk_to_class + (offsets[i] >> MEMPOOL_SIZECLASS_CHUNK_SHIFT), (int)i,
+               (end - offsets[i]) >> MEMPOOL_SIZECLASS_CHUNK_SHIFT);
+    }
+
+    // 大小查找表: 每个对齐单元映射到块大小不小于它的最小级别
+    size_t cls = 0;
+    for (size_t unit = 0; unit <= sc->max_size / MEMPOOL_ALIGNMENT; unit++) {
+        while (sc->classes[cls].pool->block_size < unit * MEMPOOL_ALIGNMENT) {
+            cls++;
+        }
+        sc->size_to_class[unit] = (uint8_t)cls;
+    }
+
+    DEBUG_PRINT("Sizeclass created: %zu classes, arena %zu bytes", num_classes, arena_size);
+
+    return sc;
+}
+
+// 销毁多级分配器
+void mempool_sizeclass_destroy(mempool_sizeclass_t *sc)
+{
+    MEMPOOL_ASSERT(sc != NULL);
+
+    for (size_t i = 0; i < sc->num_classes; i++) {
+        if (sc->classes[i].pool) {
+            mempool_destroy(sc->classes[i].pool);
+        }
+    }
+    MEMPOOL_FREE(sc->chunk_to_class);
+    MEMPOOL_FREE(sc->size_to_class);
+    MEMPOOL_FREE(sc->arena);
+    MEMPOOL_FREE(sc);
+}
+
+// 请求大小对应的级别(O(1)查表)
+int mempool_sizeclass_class_of(mempool_sizeclass_t *sc, size_t size)
+{
+    if (size == 0 || size > sc->max_size) {
+        return -1;
+    }
+    return sc->size_to_class[(size + MEMPOOL_ALIGNMENT - 1) / MEMPOOL_ALIGNMENT];
+}
+
+// 分配: 从最小可容纳的级别分配, 该级耗尽时依次尝试更大的级别
+uint8_t *mempool_sizeclass_alloc(mempool_sizeclass_t *sc, size_t size)
+{
+    int cls = mempool_sizeclass_class_of(sc, size);
+    if (cls < 0) {
+        DEBUG_PRINT("No size class fits %zu bytes", size);
+        return NULL;
+    }
+
+    for (size_t i = (size_t)cls; i < sc->num_classes; i++) {
+        struct mempool_sizeclass_class *c = &sc->classes[i];
+        uint8_t *block = mempool_alloc(c->pool, false);
+        if (block) {
+            struct mempool_sizeclass_shard *shard = sizeclass_stats_shard(c);
+            MEMPOOL_ATOMIC_ADD_RELAXED(&shard->allocs, 1);
+            MEMPOOL_ATOMIC_ADD_RELAXED(&shard->requested_bytes, size);
+            return block;
+        }
+    }
+
+    DEBUG_PRINT("All size classes >= %zu exhausted", size);
+    return NULL;
+}
+
+// 指针所属的内存池(O(1)查表), 非法指针返回NULL
+mempool_t *mempool_sizeclass_pool_of(mempool_sizeclass_t *sc, uint8_t *ptr)
+{
+    if (ptr < sc->arena || ptr >= sc->arena + sc->arena_size) {
+        return NULL;
+    }
+    return sc->classes[sc->chunk_to_class[(size_t)(ptr - sc->arena) >> MEMPOOL_SIZECLASS_CHUNK_SHIFT]].pool;
+}
+
+// 释放
+void mempool_sizeclass_free(mempool_sizeclass_t *sc, uint8_t *ptr)
+{
+    mempool_t *pool = mempool_sizeclass_pool_of(sc, ptr);
+    if (!pool) {
+        ERROR_PRINT("Invalid pointer %p for sizeclass %p", ptr, sc);
+        return;
+    }
+    mempool_free(pool, ptr);
+}
+
+// 按级别下标获取内存池(用于单独配置, 如启用线程缓存)
+mempool_t *mempool_sizeclass_pool(mempool_sizeclass_t *sc, size_t class_idx)
+{
+    return class_idx < sc->num_classes ? sc->classes[class_idx].pool : NULL;
+}
+
+// 单次请求浪费的字节数
+size_t mempool_sizeclass_waste(mempool_sizeclass_t *sc, size_t size)
+{
+    int cls = mempool_sizeclass_class_of(sc, size);
+    if (cls < 0) {
+        return SIZE_MAX;
+    }
+    return sc->classes[cls].pool->block_size - size;
+}
+
+// 获取级别统计: 汇总各分片, 不加锁
+int mempool_sizeclass_get_stats(mempool_sizeclass_t *sc, size_t class_idx, mempool_sizeclass_stats_t *stats)
+{
+    if (class_idx >= sc->num_classes || !stats) {
+        return -1;
+    }
+
+    struct mempool_sizeclass_class *c = &sc->classes[class_idx];
+    stats->block_size = c->pool->block_size;
+    stats->block_count = c->pool->block_count;
+    stats->allocs = 0;
+    stats->requested_bytes = 0;
+    for (size_t i = 0; i < MEMPOOL_SIZECLASS_STATS_SHARDS; i++) {
+        stats->allocs += MEMPOOL_ATOMIC_LOAD_RELAXED(&c->stats[i].allocs);
+        stats->requested_bytes += MEMPOOL_ATOMIC_LOAD_RELAXED(&c->stats[i].requested_bytes);
+    }
+    stats->wasted_bytes = stats->allocs * stats->block_size - stats->requested_bytes;
+    return 0;
+}
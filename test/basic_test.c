@@ -1,7 +1,18 @@
 #include <mempool.h>
+#include <mempool_sizeclass.h>
+#include <mempool_numa.h>
+#include <mempool_chain.h>
+#include <mempool_pkt.h>
+#include <mempool_hist.h>
+#include <mempool_static.h>
+#include <mempool_bitmap.h>
+#include <mempool_prio.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
 
 #ifdef MEMPOOL_LOG_LEVEL
 #undef MEMPOOL_LOG_LEVEL
@@ -271,38 +282,39 @@ void test_mempool_memory_content() {
 }
 
 void test_mempool_all_blocks_isolation() {
+    const int all_blocks = (int)get_test_block_count();
     DEBUG_PRINT("=== Testing isolation across ALL memory blocks (%d blocks) ===", 
-               MEMPOOL_MAX_BLOCKS);
+               all_blocks);
 
     // 创建内存池
-    mempool_t *pool = mempool_create(TEST_BLOCK_SIZE, MEMPOOL_MAX_BLOCKS);
+    mempool_t *pool = mempool_create(TEST_BLOCK_SIZE, all_blocks);
     MEMPOOL_ASSERT(pool != NULL);
 
     // 分配所有内存块
-    uint8_t *blocks[MEMPOOL_MAX_BLOCKS];
-    for (int i = 0; i < MEMPOOL_MAX_BLOCKS; i++) {
+    uint8_t *blocks[all_blocks];
+    for (int i = 0; i < all_blocks; i++) {
         blocks[i] = mempool_alloc(pool, false);
         MEMPOOL_ASSERT(blocks[i] != NULL);
     }
 
     // 测试1: 初始化所有块为唯一模式
     DEBUG_PRINT("Initializing all blocks with unique patterns...");
-    for (int i = 0; i < MEMPOOL_MAX_BLOCKS; i++) {
+    for (int i = 0; i < all_blocks; i++) {
         memset(blocks[i], 0xA0 + (i % 0x5F), TEST_BLOCK_SIZE);
     }
 
     // 保存初始状态
-    uint8_t *initial_blocks[MEMPOOL_MAX_BLOCKS];
-    for (int i = 0; i < MEMPOOL_MAX_BLOCKS; i++) {
+    uint8_t *initial_blocks[all_blocks];
+    for (int i = 0; i < all_blocks; i++) {
         initial_blocks[i] = malloc(TEST_BLOCK_SIZE);
         memcpy(initial_blocks[i], blocks[i], TEST_BLOCK_SIZE);
     }
 
     // 测试2: 修改每个块并验证其他块
     DEBUG_PRINT("Modifying and verifying each block in isolation...");
-    for (int target_block = 0; target_block < MEMPOOL_MAX_BLOCKS; target_block++) {
+    for (int target_block = 0; target_block < all_blocks; target_block++) {
         // 恢复所有块到初始状态
-        for (int i = 0; i < MEMPOOL_MAX_BLOCKS; i++) {
+        for (int i = 0; i < all_blocks; i++) {
             memcpy(blocks[i], initial_blocks[i], TEST_BLOCK_SIZE);
         }
         
@@ -310,7 +322,7 @@ void test_mempool_all_blocks_isolation() {
         memset(blocks[target_block], 0xF0 + (target_block % 0x0F), TEST_BLOCK_SIZE);
 
         // 验证其他所有块
-        for (int i = 0; i < MEMPOOL_MAX_BLOCKS; i++) {
+        for (int i = 0; i < all_blocks; i++) {
             if (i == target_block) continue;
 
             for (size_t j = 0; j < TEST_BLOCK_SIZE; j++) {
@@ -328,7 +340,7 @@ void test_mempool_all_blocks_isolation() {
     }
 
     // 释放资源
-    for (int i = 0; i < MEMPOOL_MAX_BLOCKS; i++) {
+    for (int i = 0; i < all_blocks; i++) {
         free(initial_blocks[i]);
         mempool_free(pool, blocks[i]);
     }
@@ -336,6 +348,1995 @@ void test_mempool_all_blocks_isolation() {
     DEBUG_PRINT("All-block isolation test passed successfully!");
 }
 
+// 大容量内存池测试(两级位图)
+static void test_mempool_large_pool_mode(uint32_t flags) {
+    const size_t large_blocks = 50000; // 非64整数倍, 覆盖末尾屏蔽
+    mempool_t *pool = mempool_create_flags(TEST_BLOCK_SIZE, large_blocks, flags);
+    MEMPOOL_ASSERT(pool != NULL);
+    MEMPOOL_ASSERT(mempool_available(pool) == large_blocks);
+
+    // 按顺序分配全部块
+    uint8_t **blocks = malloc(sizeof(uint8_t *) * large_blocks);
+    for (size_t i = 0; i < large_blocks; i++) {
+        blocks[i] = mempool_alloc(pool, false);
+        MEMPOOL_ASSERT(blocks[i] == pool->memory_area + i * pool->block_size);
+    }
+    MEMPOOL_ASSERT(mempool_alloc(pool, false) == NULL);
+    MEMPOOL_ASSERT(mempool_available(pool) == 0);
+
+    // 隔位释放后重新分配应找回同一批块
+    for (size_t i = 0; i < large_blocks; i += 2) {
+        mempool_free(pool, blocks[i]);
+    }
+    MEMPOOL_ASSERT(mempool_available(pool) == large_blocks / 2);
+    for (size_t i = 0; i < large_blocks; i += 2) {
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == blocks[i]);
+    }
+
+    // 高位块可以正常入队出队
+    mempool_queue_t *queue = mempool_queue_create(pool, 4);
+    MEMPOOL_ASSERT(queue != NULL);
+    MEMPOOL_ASSERT(mempool_queue_enqueue_with_length(queue, blocks[large_blocks - 1], 7) == 0);
+    MEMPOOL_ASSERT(mempool_queue_enqueue(queue, blocks[large_blocks - 1]) == -1);
+    size_t len = 0;
+    MEMPOOL_ASSERT(mempool_queue_dequeue_with_length(queue, &len) == blocks[large_blocks - 1]);
+    MEMPOOL_ASSERT(len == 7);
+    mempool_queue_destroy(queue);
+
+    for (size_t i = 0; i < large_blocks; i++) {
+        mempool_free(pool, blocks[i]);
+    }
+    MEMPOOL_ASSERT(mempool_available(pool) == large_blocks);
+
+    free(blocks);
+    mempool_destroy(pool);
+}
+
+void test_mempool_large_pool() {
+    DEBUG_PRINT("=== Testing large mempool (hierarchical bitmap) ===");
+
+    // 小池的可用块数不应包含位图对齐多出的位
+    mempool_t *pool = mempool_create(TEST_BLOCK_SIZE, 100);
+    MEMPOOL_ASSERT(pool != NULL);
+    MEMPOOL_ASSERT(mempool_available(pool) == 100);
+    mempool_destroy(pool);
+
+    test_mempool_large_pool_mode(0);
+    test_mempool_large_pool_mode(MEMPOOL_FLAG_LOCKFREE);
+
+    DEBUG_PRINT("Large mempool test passed!");
+}
+
+// 批量分配/释放测试
+static void test_mempool_batch_mode(uint32_t flags) {
+    const size_t batch_blocks = 1000;
+    mempool_t *pool = mempool_create_flags(TEST_BLOCK_SIZE, batch_blocks, flags);
+    MEMPOOL_ASSERT(pool != NULL);
+
+    uint8_t *bufs[batch_blocks];
+
+    // 跨多个位图字的批量分配按地址顺序返回
+    MEMPOOL_ASSERT(mempool_alloc_batch(pool, bufs, 150, true) == 150);
+    for (size_t i = 0; i < 150; i++) {
+        MEMPOOL_ASSERT(bufs[i] == pool->memory_area + i * pool->block_size);
+    }
+    MEMPOOL_ASSERT(mempool_available(pool) == batch_blocks - 150);
+
+    // 批量释放(含重复指针与非法指针)后硬件标记应全部清除
+    bufs[150] = bufs[3];
+    bufs[151] = (uint8_t *)&flags;
+    mempool_free_batch(pool, bufs, 152);
+    MEMPOOL_ASSERT(mempool_available(pool) == batch_blocks);
+    for (size_t i = 0; i < pool->bitmap_words; i++) {
+        MEMPOOL_ASSERT(pool->hw_owned_bitmap[i] == 0);
+    }
+
+    // 空闲块不足时返回实际数量
+    MEMPOOL_ASSERT(mempool_alloc_batch(pool, bufs, batch_blocks - 10, false) == batch_blocks - 10);
+    uint8_t *rest[32];
+    MEMPOOL_ASSERT(mempool_alloc_batch(pool, rest, 32, false) == 10);
+    MEMPOOL_ASSERT(mempool_alloc(pool, false) == NULL);
+
+    // 乱序释放后批量分配可取回全部块
+    for (size_t i = 0; i < batch_blocks - 10; i += 3) {
+        mempool_free(pool, bufs[i]);
+    }
+    mempool_free_batch(pool, rest, 10);
+    size_t freed = mempool_available(pool);
+    MEMPOOL_ASSERT(mempool_alloc_batch(pool, rest, 32, false) == 32);
+    MEMPOOL_ASSERT(mempool_available(pool) == freed - 32);
+
+    mempool_destroy(pool);
+}
+
+void test_mempool_batch() {
+    DEBUG_PRINT("=== Testing batch alloc/free ===");
+    test_mempool_batch_mode(0);
+    test_mempool_batch_mode(MEMPOOL_FLAG_LOCKFREE);
+    DEBUG_PRINT("Batch alloc/free test passed!");
+}
+
+// SPSC队列生产者线程: 按顺序循环使用一组块, 数据长度携带序号
+typedef struct {
+    mempool_queue_t *queue;
+    uint8_t **blocks;
+    size_t block_num;
+    size_t messages;
+} spsc_test_arg_t;
+
+static void *spsc_producer_thread(void *arg) {
+    spsc_test_arg_t *a = (spsc_test_arg_t *)arg;
+    for (size_t seq = 0; seq < a->messages; ) {
+        if (mempool_queue_enqueue_with_length(a->queue, a->blocks[seq % a->block_num], seq) == 0) {
+            seq++;
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// SPSC无锁队列测试
+void test_mempool_queue_spsc() {
+    DEBUG_PRINT("=== Testing SPSC lock-free queue ===");
+
+    mempool_t *pool = mempool_create(TEST_BLOCK_SIZE, 64);
+    MEMPOOL_ASSERT(pool != NULL);
+    MEMPOOL_ASSERT(mempool_queue_create_mode(pool, 3, 99) == NULL);
+
+    // 单线程语义: FIFO、容量上限、数据长度、peek与批量出队
+    mempool_queue_t *queue = mempool_queue_create_mode(pool, 3, MEMPOOL_QUEUE_SPSC);
+    MEMPOOL_ASSERT(queue != NULL);
+    uint8_t *blocks[32];
+    for (int i = 0; i < 4; i++) {
+        blocks[i] = mempool_alloc(pool, false);
+    }
+    MEMPOOL_ASSERT(mempool_queue_is_empty(queue));
+    MEMPOOL_ASSERT(mempool_queue_peek(queue) == NULL);
+    for (int i = 0; i < 3; i++) {
+        MEMPOOL_ASSERT(mempool_queue_enqueue_with_length(queue, blocks[i], 100 + i) == 0);
+    }
+    MEMPOOL_ASSERT(mempool_queue_is_full(queue));
+    MEMPOOL_ASSERT(mempool_queue_enqueue(queue, blocks[3]) == -1);
+    MEMPOOL_ASSERT(mempool_queue_enqueue(queue, (uint8_t *)&queue) == -1);
+    MEMPOOL_ASSERT(mempool_queue_peek(queue) == blocks[0]);
+
+    size_t len = 0;
+    MEMPOOL_ASSERT(mempool_queue_dequeue_with_length(queue, &len) == blocks[0] && len == 100);
+    MEMPOOL_ASSERT(mempool_queue_enqueue_with_length(queue, blocks[3], 103) == 0);
+
+    uint8_t *out[8];
+    size_t lens[8];
+    MEMPOOL_ASSERT(mempool_queue_dequeue_batch_with_length(queue, out, lens, 8) == 3);
+    for (int i = 0; i < 3; i++) {
+        MEMPOOL_ASSERT(out[i] == blocks[i + 1] && lens[i] == 101 + (size_t)i);
+    }
+    MEMPOOL_ASSERT(mempool_queue_dequeue_with_length(queue, &len) == NULL && len == 0);
+    mempool_queue_destroy(queue);
+
+    // 生产者/消费者并发: 顺序与数据均不能错乱
+    queue = mempool_queue_create_mode(pool, 16, MEMPOOL_QUEUE_SPSC);
+    MEMPOOL_ASSERT(queue != NULL);
+    for (int i = 4; i < 32; i++) {
+        blocks[i] = mempool_alloc(pool, false);
+    }
+    spsc_test_arg_t arg = { .queue = queue, .blocks = blocks, .block_num = 32, .messages = 200000 };
+    pthread_t producer;
+    pthread_create(&producer, NULL, spsc_producer_thread, &arg);
+
+    for (size_t expect = 0; expect < arg.messages; ) {
+        size_t n = mempool_queue_dequeue_batch_with_length(queue, out, lens, 8);
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+        for (size_t i = 0; i < n; i++, expect++) {
+            MEMPOOL_ASSERT(lens[i] == expect);
+            MEMPOOL_ASSERT(out[i] == blocks[expect % 32]);
+        }
+    }
+    pthread_join(producer, NULL);
+    MEMPOOL_ASSERT(mempool_queue_is_empty(queue));
+
+    mempool_queue_destroy(queue);
+    mempool_destroy(pool);
+    DEBUG_PRINT("SPSC queue test passed!");
+}
+
+// MPMC队列测试参数: 每个生产者使用独立的块组, 数据长度为(生产者<<32 | 序号)
+#define MPMC_TEST_PRODUCERS 2
+#define MPMC_TEST_CONSUMERS 2
+#define MPMC_TEST_MESSAGES  50000
+#define MPMC_TEST_BLOCKS    16
+
+typedef struct {
+    mempool_queue_t *queue;
+    uint8_t *blocks[MPMC_TEST_PRODUCERS][MPMC_TEST_BLOCKS];
+    uint8_t received[MPMC_TEST_PRODUCERS][MPMC_TEST_MESSAGES];
+    size_t consumed;
+    int producer_id;
+} mpmc_test_ctx_t;
+
+typedef struct {
+    mpmc_test_ctx_t *ctx;
+    int id;
+} mpmc_test_arg_t;
+
+static void *mpmc_producer_thread(void *arg) {
+    mpmc_test_arg_t *a = (mpmc_test_arg_t *)arg;
+    for (size_t seq = 0; seq < MPMC_TEST_MESSAGES; ) {
+        uint8_t *block = a->ctx->blocks[a->id][seq % MPMC_TEST_BLOCKS];
+        if (mempool_queue_enqueue_with_length(a->ctx->queue, block, ((size_t)a->id << 32) | seq) == 0) {
+            seq++;
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *mpmc_consumer_thread(void *arg) {
+    mpmc_test_ctx_t *ctx = ((mpmc_test_arg_t *)arg)->ctx;
+    const size_t total = (size_t)MPMC_TEST_PRODUCERS * MPMC_TEST_MESSAGES;
+    uint8_t *out[4];
+    size_t lens[4];
+
+    while (__atomic_load_n(&ctx->consumed, __ATOMIC_RELAXED) < total) {
+        size_t n = mempool_queue_dequeue_batch_with_length(ctx->queue, out, lens, 4);
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+        for (size_t i = 0; i < n; i++) {
+            size_t producer = lens[i] >> 32, seq = lens[i] & 0xFFFFFFFF;
+            MEMPOOL_ASSERT(producer < MPMC_TEST_PRODUCERS && seq < MPMC_TEST_MESSAGES);
+            MEMPOOL_ASSERT(out[i] == ctx->blocks[producer][seq % MPMC_TEST_BLOCKS]);
+            MEMPOOL_ASSERT(__atomic_fetch_add(&ctx->received[producer][seq], 1, __ATOMIC_RELAXED) == 0);
+        }
+        __atomic_fetch_add(&ctx->consumed, n, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+// MPMC无锁队列测试
+void test_mempool_queue_mpmc() {
+    DEBUG_PRINT("=== Testing MPMC lock-free queue ===");
+
+    mempool_t *pool = mempool_create(TEST_BLOCK_SIZE, MPMC_TEST_PRODUCERS * MPMC_TEST_BLOCKS);
+    MEMPOOL_ASSERT(pool != NULL);
+
+    // 单线程语义: 容量5(槽位8)时第6次入队失败, FIFO与数据长度保持
+    mempool_queue_t *queue = mempool_queue_create_mode(pool, 5, MEMPOOL_QUEUE_MPMC);
+    MEMPOOL_ASSERT(queue != NULL);
+    uint8_t *blocks[6];
+    MEMPOOL_ASSERT(mempool_alloc_batch(pool, blocks, 6, false) == 6);
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 5; i++) {
+            MEMPOOL_ASSERT(mempool_queue_enqueue_with_length(queue, blocks[i], i * 10) == 0);
+        }
+        MEMPOOL_ASSERT(mempool_queue_is_full(queue));
+        MEMPOOL_ASSERT(mempool_queue_enqueue(queue, blocks[5]) == -1);
+        MEMPOOL_ASSERT(mempool_queue_peek(queue) == blocks[0]);
+
+        size_t len;
+        MEMPOOL_ASSERT(mempool_queue_dequeue_with_length(queue, &len) == blocks[0] && len == 0);
+        uint8_t *out[8];
+        MEMPOOL_ASSERT(mempool_queue_dequeue_batch(queue, out, 8) == 4);
+        for (int i = 0; i < 4; i++) {
+            MEMPOOL_ASSERT(out[i] == blocks[i + 1]);
+        }
+        MEMPOOL_ASSERT(mempool_queue_is_empty(queue));
+        MEMPOOL_ASSERT(mempool_queue_dequeue(queue) == NULL);
+    }
+    mempool_queue_destroy(queue);
+    mempool_free_batch(pool, blocks, 6);
+
+    // 多生产者/多消费者并发: 每条消息恰好被消费一次
+    mpmc_test_ctx_t *ctx = calloc(1, sizeof(mpmc_test_ctx_t));
+    ctx->queue = mempool_queue_create_mode(pool, 8, MEMPOOL_QUEUE_MPMC);
+    MEMPOOL_ASSERT(ctx->queue != NULL);
+    for (int p = 0; p < MPMC_TEST_PRODUCERS; p++) {
+        MEMPOOL_ASSERT(mempool_alloc_batch(pool, ctx->blocks[p], MPMC_TEST_BLOCKS, false) == MPMC_TEST_BLOCKS);
+    }
+
+    pthread_t threads[MPMC_TEST_PRODUCERS + MPMC_TEST_CONSUMERS];
+    mpmc_test_arg_t args[MPMC_TEST_PRODUCERS + MPMC_TEST_CONSUMERS];
+    for (int i = 0; i < MPMC_TEST_PRODUCERS + MPMC_TEST_CONSUMERS; i++) {
+        args[i] = (mpmc_test_arg_t){ .ctx = ctx, .id = i };
+        pthread_create(&threads[i], NULL,
+                       i < MPMC_TEST_PRODUCERS ? mpmc_producer_thread : mpmc_consumer_thread, &args[i]);
+    }
+    for (int i = 0; i < MPMC_TEST_PRODUCERS + MPMC_TEST_CONSUMERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (int p = 0; p < MPMC_TEST_PRODUCERS; p++) {
+        for (size_t seq = 0; seq < MPMC_TEST_MESSAGES; seq++) {
+            MEMPOOL_ASSERT(ctx->received[p][seq] == 1);
+        }
+    }
+    MEMPOOL_ASSERT(mempool_queue_is_empty(ctx->queue));
+
+    mempool_queue_destroy(ctx->queue);
+    free(ctx);
+    mempool_destroy(pool);
+    DEBUG_PRINT("MPMC queue test passed!");
+}
+
+// 多级块大小分配器测试
+void test_mempool_sizeclass() {
+    DEBUG_PRINT("=== Testing size-class allocator ===");
+
+    // 故意乱序配置, 创建时按大小排序
+    const mempool_sizeclass_config_t config[] = {
+        { .size = 1536, .num_blocks = 4 },
+        { .size = 70,   .num_blocks = 8 },
+        { .size = 256,  .num_blocks = 4 },
+    };
+    mempool_sizeclass_t *sc = mempool_sizeclass_create(config, 3, MEMPOOL_DEFAULT_FLAGS);
+    MEMPOOL_ASSERT(sc != NULL);
+
+    // 大小 -> 级别
+    MEMPOOL_ASSERT(mempool_sizeclass_class_of(sc, 0) == -1);
+    MEMPOOL_ASSERT(mempool_sizeclass_class_of(sc, 1) == 0);
+    MEMPOOL_ASSERT(mempool_sizeclass_class_of(sc, 128) == 0);   // 70字节对齐后为128
+    MEMPOOL_ASSERT(mempool_sizeclass_class_of(sc, 129) == 1);
+    MEMPOOL_ASSERT(mempool_sizeclass_class_of(sc, 257) == 2);
+    MEMPOOL_ASSERT(mempool_sizeclass_class_of(sc, 1536) == 2);
+    MEMPOOL_ASSERT(mempool_sizeclass_class_of(sc, 1537) == -1);
+    MEMPOOL_ASSERT(mempool_sizeclass_alloc(sc, 4096) == NULL);
+    MEMPOOL_ASSERT(mempool_sizeclass_waste(sc, 70) == 58);
+    MEMPOOL_ASSERT(mempool_sizeclass_waste(sc, 4096) == SIZE_MAX);
+
+    // 指针 -> 内存池, 小级别耗尽后回退到更大级别
+    uint8_t *small[9];
+    for (int i = 0; i < 9; i++) {
+        small[i] = mempool_sizeclass_alloc(sc, 70);
+        MEMPOOL_ASSERT(small[i] != NULL);
+        memset(small[i], 0xA0 + i, 70);
+    }
+    MEMPOOL_ASSERT(mempool_sizeclass_pool_of(sc, small[0]) == mempool_sizeclass_pool(sc, 0));
+    MEMPOOL_ASSERT(mempool_sizeclass_pool_of(sc, small[7] + 127) == mempool_sizeclass_pool(sc, 0));
+    MEMPOOL_ASSERT(mempool_sizeclass_pool_of(sc, small[8]) == mempool_sizeclass_pool(sc, 1));
+    MEMPOOL_ASSERT(mempool_available(mempool_sizeclass_pool(sc, 0)) == 0);
+
+    uint8_t *jumbo = mempool_sizeclass_alloc(sc, 1500);
+    MEMPOOL_ASSERT(mempool_sizeclass_pool_of(sc, jumbo) == mempool_sizeclass_pool(sc, 2));
+    MEMPOOL_ASSERT(mempool_sizeclass_pool_of(sc, (uint8_t *)&sc) == NULL);
+
+    // 浪费统计
+    mempool_sizeclass_stats_t stats;
+    MEMPOOL_ASSERT(mempool_sizeclass_get_stats(sc, 0, &stats) == 0);
+    MEMPOOL_ASSERT(stats.block_size == 128 && stats.allocs == 8);
+    MEMPOOL_ASSERT(stats.requested_bytes == 8 * 70 && stats.wasted_bytes == 8 * 58);
+    MEMPOOL_ASSERT(mempool_sizeclass_get_stats(sc, 1, &stats) == 0);
+    MEMPOOL_ASSERT(stats.allocs == 1 && stats.wasted_bytes == 256 - 70);
+    MEMPOOL_ASSERT(mempool_sizeclass_get_stats(sc, 3, &stats) == -1);
+
+    for (int i = 0; i < 9; i++) {
+        for (int j = 0; j < 70; j++) {
+            MEMPOOL_ASSERT(small[i][j] == (uint8_t)(0xA0 + i));
+        }
+        mempool_sizeclass_free(sc, small[i]);
+    }
+    mempool_sizeclass_free(sc, jumbo);
+    for (size_t i = 0; i < 3; i++) {
+        mempool_t *pool = mempool_sizeclass_pool(sc, i);
+        MEMPOOL_ASSERT(mempool_available(pool) == pool->block_count);
+    }
+
+    mempool_sizeclass_destroy(sc);
+    DEBUG_PRINT("Size-class allocator test passed!");
+}
+
+// 弹性池压力测试线程: 4个线程各持有48块, 超过单个slab容量, 迫使并发扩展
+static void *elastic_stress_thread(void *arg) {
+    mempool_t *pool = (mempool_t *)arg;
+    uint8_t tag = (uint8_t)(uintptr_t)pthread_self();
+    uint8_t *held[48];
+
+    for (int iter = 0; iter < 2000; iter++) {
+        for (int i = 0; i < 48; i++) {
+            held[i] = mempool_alloc(pool, false);
+            MEMPOOL_ASSERT(held[i] != NULL);
+            memset(held[i], tag, TEST_BLOCK_SIZE);
+        }
+        for (int i = 0; i < 48; i++) {
+            MEMPOOL_ASSERT(held[i][0] == tag && held[i][TEST_BLOCK_SIZE - 1] == tag);
+            mempool_free(pool, held[i]);
+        }
+    }
+    return NULL;
+}
+
+// 弹性池收缩线程: 与分配线程并发归还空闲slab
+static void *elastic_shrink_thread(void *arg) {
+    mempool_t *pool = (mempool_t *)arg;
+    for (int i = 0; i < 2000; i++) {
+        mempool_shrink(pool);
+        sched_yield();
+    }
+    return NULL;
+}
+
+// 弹性内存池测试
+void test_mempool_elastic() {
+    DEBUG_PRINT("=== Testing elastic mempool ===");
+
+    // 弹性/共享标志只能由专用创建函数设置, 普通创建接口拒绝(否则池缺少slab状态)
+    MEMPOOL_ASSERT(mempool_create_flags(64, 64, MEMPOOL_FLAG_ELASTIC) == NULL);
+    MEMPOOL_ASSERT(mempool_create_flags(64, 64, MEMPOOL_FLAG_SHARED | MEMPOOL_FLAG_LOCKFREE) == NULL);
+    static uint8_t area[64 * 64] __attribute__((aligned(64)));
+    MEMPOOL_ASSERT(mempool_create_with_area(area, 64, 64, MEMPOOL_FLAG_ELASTIC) == NULL);
+
+    const uint32_t modes[] = { 0, MEMPOOL_FLAG_LOCKFREE };
+    for (int m = 0; m < 2; m++) {
+        // slab块数按位图字对齐(60 -> 64)
+        mempool_t *pool = mempool_create_elastic(TEST_BLOCK_SIZE, 60, 1, 4, modes[m]);
+        MEMPOOL_ASSERT(pool != NULL);
+        MEMPOOL_ASSERT(mempool_capacity(pool) == 64);
+        MEMPOOL_ASSERT(mempool_available(pool) == 64);
+
+        // 耗尽后自动扩展, 达到上限后失败
+        uint8_t *blocks[256];
+        for (int i = 0; i < 256; i++) {
+            blocks[i] = mempool_alloc(pool, i % 2);
+            MEMPOOL_ASSERT(blocks[i] != NULL);
+            memset(blocks[i], i, TEST_BLOCK_SIZE);
+            MEMPOOL_ASSERT(mempool_capacity(pool) == (size_t)(i / 64 + 1) * 64);
+        }
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == NULL);
+        MEMPOOL_ASSERT(mempool_used(pool) == 256);
+        MEMPOOL_ASSERT(mempool_shrink(pool) == 0);
+
+        // 扩展出的块可以入队(块索引换算与普通池一致)
+        mempool_queue_t *queue = mempool_queue_create(pool, 4);
+        MEMPOOL_ASSERT(mempool_queue_enqueue(queue, blocks[255]) == 0);
+        MEMPOOL_ASSERT(mempool_queue_dequeue(queue) == blocks[255]);
+        mempool_queue_destroy(queue);
+
+        // 后两个slab完全空闲后可归还, 常驻slab保留
+        for (int i = 128; i < 256; i++) {
+            mempool_free(pool, blocks[i]);
+        }
+        blocks[0][0] = 0xEE;
+        MEMPOOL_ASSERT(mempool_shrink(pool) == 2);
+        MEMPOOL_ASSERT(mempool_capacity(pool) == 128 && mempool_used(pool) == 128);
+        mempool_free(pool, blocks[200]); // 已归还slab中的指针应被拒绝
+        MEMPOOL_ASSERT(mempool_available(pool) == 0);
+
+        for (int i = 0; i < 128; i++) {
+            MEMPOOL_ASSERT(blocks[i][1] == (uint8_t)i);
+            mempool_free(pool, blocks[i]);
+        }
+        MEMPOOL_ASSERT(mempool_shrink(pool) == 1);
+        MEMPOOL_ASSERT(mempool_capacity(pool) == 64 && mempool_available(pool) == 64);
+
+        // 批量分配同样触发扩展
+        MEMPOOL_ASSERT(mempool_alloc_batch(pool, blocks, 200, false) == 200);
+        MEMPOOL_ASSERT(mempool_capacity(pool) == 256);
+        memset(blocks[199], 0x5A, TEST_BLOCK_SIZE);
+        mempool_free_batch(pool, blocks, 200);
+
+        // 并发扩展与收缩
+        pthread_t threads[5];
+        for (int i = 0; i < 5; i++) {
+            pthread_create(&threads[i], NULL, i < 4 ? elastic_stress_thread : elastic_shrink_thread, pool);
+        }
+        for (int i = 0; i < 5; i++) {
+            pthread_join(threads[i], NULL);
+        }
+        MEMPOOL_ASSERT(mempool_used(pool) == 0);
+
+        mempool_destroy(pool);
+    }
+
+    MEMPOOL_ASSERT(mempool_create_elastic(TEST_BLOCK_SIZE, 64, 2, 1, 0) == NULL);
+    MEMPOOL_ASSERT(mempool_create_elastic(TEST_BLOCK_SIZE, 64, 1, MEMPOOL_MAX_BLOCKS, 0) == NULL);
+
+    DEBUG_PRINT("Elastic mempool test passed!");
+}
+
+// 内存区域后端测试: 大页不可用或mlock受限时应回退而不是失败
+void test_mempool_area_backend() {
+    DEBUG_PRINT("=== Testing memory area backends ===");
+
+    const uint32_t backends[] = {
+        MEMPOOL_FLAG_PREFAULT,
+        MEMPOOL_FLAG_THP,
+        MEMPOOL_FLAG_HUGEPAGE | MEMPOOL_FLAG_PREFAULT,
+        MEMPOOL_FLAG_HUGEPAGE | MEMPOOL_FLAG_PREFAULT | MEMPOOL_FLAG_MLOCK | MEMPOOL_FLAG_LOCKFREE,
+    };
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+        mempool_t *pool = mempool_create_flags(2000, 600, backends[b]);
+        MEMPOOL_ASSERT(pool != NULL);
+        MEMPOOL_ASSERT(pool->area_size >= pool->block_size * pool->block_count);
+        MEMPOOL_ASSERT(((uintptr_t)pool->memory_area & (MEMPOOL_ALIGNMENT - 1)) == 0);
+        MEMPOOL_ASSERT((pool->area_flags & ~MEMPOOL_FLAG_AREA_MASK) == 0);
+        if (backends[b] & MEMPOOL_FLAG_PREFAULT) {
+            MEMPOOL_ASSERT(pool->area_flags & MEMPOOL_FLAG_PREFAULT);
+        }
+        if (pool->area_flags & MEMPOOL_FLAG_HUGEPAGE) {
+            MEMPOOL_ASSERT(pool->area_size % MEMPOOL_HUGEPAGE_SIZE == 0);
+        }
+
+        uint8_t *blocks[600];
+        MEMPOOL_ASSERT(mempool_alloc_batch(pool, blocks, 600, false) == 600);
+        for (int i = 0; i < 600; i++) {
+            memset(blocks[i], i, 2000);
+        }
+        for (int i = 0; i < 600; i++) {
+            MEMPOOL_ASSERT(blocks[i][1999] == (uint8_t)i);
+        }
+        mempool_free_batch(pool, blocks, 600);
+        MEMPOOL_ASSERT(mempool_available(pool) == 600);
+        mempool_destroy(pool);
+    }
+
+    // 普通池不使用mmap后端
+    mempool_t *pool = mempool_create(TEST_BLOCK_SIZE, 8);
+    MEMPOOL_ASSERT(pool->area_size == 0 && pool->area_flags == 0);
+    mempool_destroy(pool);
+
+    // 弹性池在提交slab时预取
+    pool = mempool_create_elastic(TEST_BLOCK_SIZE, 128, 1, 4, MEMPOOL_FLAG_PREFAULT);
+    MEMPOOL_ASSERT(pool != NULL && (pool->area_flags & MEMPOOL_FLAG_PREFAULT));
+    uint8_t *blocks[512];
+    MEMPOOL_ASSERT(mempool_alloc_batch(pool, blocks, 512, false) == 512);
+    blocks[511][0] = 1;
+    mempool_free_batch(pool, blocks, 512);
+    mempool_destroy(pool);
+
+    DEBUG_PRINT("Memory area backend test passed!");
+}
+
+// NUMA感知内存池测试(单节点机器上只验证本地路径)
+void test_mempool_numa() {
+    DEBUG_PRINT("=== Testing NUMA-aware mempool ===");
+
+    int nodes = mempool_numa_node_count();
+    MEMPOOL_ASSERT(nodes >= 1);
+
+    // 单个池绑定到节点0
+    mempool_t *pool = mempool_create_on_node(TEST_BLOCK_SIZE, 32, 0, 0);
+    MEMPOOL_ASSERT(pool != NULL && (pool->area_flags & MEMPOOL_FLAG_PREFAULT));
+    uint8_t *block = mempool_alloc(pool, false);
+    memset(block, 0x11, TEST_BLOCK_SIZE);
+    mempool_free(pool, block);
+    mempool_destroy(pool);
+    MEMPOOL_ASSERT(mempool_create_on_node(TEST_BLOCK_SIZE, 32, -1, 0) == NULL);
+    MEMPOOL_ASSERT(mempool_create_on_node(TEST_BLOCK_SIZE, 32, MEMPOOL_NUMA_MAX_NODES, 0) == NULL);
+
+    // 每节点子池: 本地优先, 本地耗尽后回退远端
+    mempool_numa_t *numa = mempool_numa_create(TEST_BLOCK_SIZE, 16, MEMPOOL_DEFAULT_FLAGS);
+    MEMPOOL_ASSERT(numa != NULL);
+    int local = mempool_numa_current_node(numa);
+    MEMPOOL_ASSERT(mempool_numa_pool(numa, local) != NULL);
+
+    size_t total = 0;
+    for (int n = 0; n < nodes; n++) {
+        total += mempool_numa_pool(numa, n) ? 16 : 0;
+    }
+
+    uint8_t *blocks[MEMPOOL_NUMA_MAX_NODES * 16];
+    for (size_t i = 0; i < total; i++) {
+        blocks[i] = mempool_numa_alloc_on(numa, local, false);
+        MEMPOOL_ASSERT(blocks[i] != NULL);
+        int owner = mempool_numa_node_of(numa, blocks[i]);
+        MEMPOOL_ASSERT(i < 16 ? owner == local : owner != local);
+    }
+    MEMPOOL_ASSERT(mempool_numa_alloc_on(numa, local, false) == NULL);
+
+    mempool_numa_stats_t stats;
+    MEMPOOL_ASSERT(mempool_numa_get_stats(numa, local, &stats) == 0);
+    MEMPOOL_ASSERT(stats.local_hits == 16 && stats.remote_hits == total - 16 && stats.failures == 1);
+    MEMPOOL_ASSERT(mempool_numa_get_stats(numa, MEMPOOL_NUMA_MAX_NODES, &stats) == -1);
+
+    MEMPOOL_ASSERT(mempool_numa_node_of(numa, (uint8_t *)&stats) == -1);
+    for (size_t i = 0; i < total; i++) {
+        mempool_numa_free(numa, blocks[i]);
+    }
+    MEMPOOL_ASSERT(mempool_available(mempool_numa_pool(numa, local)) == 16);
+
+    // 按当前CPU选择节点
+    block = mempool_numa_alloc(numa, false);
+    MEMPOOL_ASSERT(block != NULL);
+    mempool_numa_free(numa, block);
+
+    mempool_numa_destroy(numa);
+    DEBUG_PRINT("NUMA-aware mempool test passed!");
+}
+
+// 共享池子进程: 连接共享池, 分配块写入数据后通过管道发送句柄
+static void shared_child_producer(const char *name, int fd, int count) {
+    mempool_t *pool = mempool_attach_shared(name);
+    if (!pool) _exit(1);
+
+    for (int i = 0; i < count; i++) {
+        uint8_t *block = mempool_alloc(pool, false);
+        if (!block) _exit(2);
+        memset(block, 0x40 + i, TEST_BLOCK_SIZE);
+        mempool_handle_t handle = mempool_to_handle(pool, block);
+        if (write(fd, &handle, sizeof(handle)) != sizeof(handle)) _exit(3);
+    }
+    mempool_destroy(pool);
+    _exit(0);
+}
+
+// 跨进程共享池测试
+void test_mempool_shared() {
+    DEBUG_PRINT("=== Testing cross-process shared mempool ===");
+
+    char name[64];
+    snprintf(name, sizeof(name), "/mempool_test_%d", (int)getpid());
+    mempool_unlink_shared(name);
+
+    mempool_t *pool = mempool_create_shared(name, TEST_BLOCK_SIZE, 100);
+    MEMPOOL_ASSERT(pool != NULL);
+    MEMPOOL_ASSERT(pool->pool_id != 0 && (pool->flags & MEMPOOL_FLAG_LOCKFREE));
+    MEMPOOL_ASSERT(mempool_create_shared(name, TEST_BLOCK_SIZE, 100) == NULL); // 名字已存在
+    MEMPOOL_ASSERT(mempool_attach_shared("/mempool_test_missing") == NULL);
+
+    // 同进程内第二个视图映射到不同地址, 通过句柄互相解析
+    mempool_t *view = mempool_attach_shared(name);
+    MEMPOOL_ASSERT(view != NULL && view->memory_area != pool->memory_area);
+    uint8_t *block = mempool_alloc(pool, true);
+    strcpy((char *)block, "shared");
+    mempool_handle_t handle = mempool_to_handle(pool, block);
+    uint8_t *other = mempool_from_handle(view, handle);
+    MEMPOOL_ASSERT(other != NULL && strcmp((char *)other, "shared") == 0);
+    MEMPOOL_ASSERT(mempool_available(view) == 99);
+    mempool_free(view, other);
+    MEMPOOL_ASSERT(mempool_available(pool) == 100);
+    mempool_destroy(view);
+
+    // 无效句柄
+    MEMPOOL_ASSERT(mempool_to_handle(pool, (uint8_t *)&handle).pool_id == 0);
+    handle.pool_id ^= 1;
+    MEMPOOL_ASSERT(mempool_from_handle(pool, handle) == NULL);
+    mempool_t *local = mempool_create(TEST_BLOCK_SIZE, 4);
+    block = mempool_alloc(local, false);
+    MEMPOOL_ASSERT(mempool_to_handle(local, block).pool_id == 0);
+    mempool_free(local, block);
+    mempool_destroy(local);
+
+    // 子进程分配并发送句柄, 父进程解析、校验并释放
+    int fds[2];
+    MEMPOOL_ASSERT(pipe(fds) == 0);
+    pid_t pid = fork();
+    MEMPOOL_ASSERT(pid >= 0);
+    if (pid == 0) {
+        close(fds[0]);
+        shared_child_producer(name, fds[1], 50);
+    }
+    close(fds[1]);
+    for (int i = 0; i < 50; i++) {
+        MEMPOOL_ASSERT(read(fds[0], &handle, sizeof(handle)) == sizeof(handle));
+        block = mempool_from_handle(pool, handle);
+        MEMPOOL_ASSERT(block != NULL);
+        MEMPOOL_ASSERT(block[0] == 0x40 + i && block[TEST_BLOCK_SIZE - 1] == 0x40 + i);
+        mempool_free(pool, block);
+    }
+    close(fds[0]);
+    int status;
+    MEMPOOL_ASSERT(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    MEMPOOL_ASSERT(mempool_available(pool) == 100);
+
+    mempool_destroy(pool);
+    MEMPOOL_ASSERT(mempool_unlink_shared(name) == 0);
+
+    // 匿名共享池: fork出的子进程直接使用继承的映射
+    pool = mempool_create_shared(NULL, TEST_BLOCK_SIZE, 8);
+    MEMPOOL_ASSERT(pool != NULL);
+    pid = fork();
+    if (pid == 0) {
+        for (int i = 0; i < 8; i++) {
+            if (!mempool_alloc(pool, false)) _exit(1);
+        }
+        _exit(0);
+    }
+    MEMPOOL_ASSERT(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    MEMPOOL_ASSERT(mempool_available(pool) == 0 && mempool_alloc(pool, false) == NULL);
+    mempool_destroy(pool);
+
+    DEBUG_PRINT("Cross-process shared mempool test passed!");
+}
+
+// 阻塞分配测试线程: 延迟后释放一个块(或入队一个块)
+typedef struct {
+    mempool_t *pool;
+    mempool_queue_t *queue;
+    uint8_t *block;
+} timed_test_arg_t;
+
+static void *timed_release_thread(void *arg) {
+    timed_test_arg_t *t = (timed_test_arg_t *)arg;
+    usleep(10000);
+    if (t->queue) {
+        MEMPOOL_ASSERT(mempool_queue_enqueue_with_length(t->queue, t->block, 7) == 0);
+    } else {
+        mempool_free(t->pool, t->block);
+    }
+    return NULL;
+}
+
+static uint64_t timed_test_now_ms(void) {
+    return MEMPOOL_CURRENT_TIME_NS() / 1000000ull;
+}
+
+// 阻塞分配/出队测试
+void test_mempool_timed() {
+    DEBUG_PRINT("=== Testing timed allocation and dequeue ===");
+
+    uint32_t flags[] = { 0, MEMPOOL_FLAG_LOCKFREE };
+    for (size_t f = 0; f < sizeof(flags) / sizeof(flags[0]); f++) {
+        mempool_t *pool = mempool_create_flags(TEST_BLOCK_SIZE, 4, flags[f]);
+        MEMPOOL_ASSERT(pool != NULL);
+
+        uint8_t *blocks[4];
+        MEMPOOL_ASSERT(mempool_alloc_batch(pool, blocks, 4, false) == 4);
+
+        // 耗尽时: 超时为0立即返回, 否则至少等待到超时
+        MEMPOOL_ASSERT(mempool_alloc_timed(pool, false, 0) == NULL);
+        uint64_t start = timed_test_now_ms();
+        MEMPOOL_ASSERT(mempool_alloc_timed(pool, false, 20000000ull) == NULL);
+        MEMPOOL_ASSERT(timed_test_now_ms() - start >= 19);
+        MEMPOOL_ASSERT(MEMPOOL_ATOMIC_LOAD(&pool->wait->waiters) == 0);
+
+        // 其他线程释放后被唤醒并拿到该块
+        pthread_t tid;
+        timed_test_arg_t arg = { pool, NULL, blocks[2] };
+        pthread_create(&tid, NULL, timed_release_thread, &arg);
+        uint8_t *got = mempool_alloc_timed(pool, false, MEMPOOL_WAIT_FOREVER);
+        pthread_join(tid, NULL);
+        MEMPOOL_ASSERT(got == blocks[2]);
+        MEMPOOL_ASSERT(MEMPOOL_ATOMIC_LOAD(&pool->wait->waiters) == 0);
+
+        // 有空闲块时不等待
+        mempool_free(pool, blocks[0]);
+        MEMPOOL_ASSERT(mempool_alloc_timed(pool, false, MEMPOOL_WAIT_FOREVER) == blocks[0]);
+
+        mempool_free_batch(pool, blocks, 4);
+        mempool_destroy(pool);
+    }
+
+    // 队列: 空队列超时, 入队唤醒出队者
+    uint32_t modes[] = { MEMPOOL_QUEUE_LOCKED, MEMPOOL_QUEUE_SPSC, MEMPOOL_QUEUE_MPMC };
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        mempool_t *pool = mempool_create(TEST_BLOCK_SIZE, 8);
+        mempool_queue_t *queue = mempool_queue_create_mode(pool, 8, modes[m]);
+        MEMPOOL_ASSERT(queue != NULL);
+
+        size_t len = 1;
+        uint64_t start = timed_test_now_ms();
+        MEMPOOL_ASSERT(mempool_queue_dequeue_timed(queue, &len, 20000000ull) == NULL && len == 0);
+        MEMPOOL_ASSERT(timed_test_now_ms() - start >= 19);
+
+        for (int round = 0; round < 20; round++) {
+            pthread_t tid;
+            timed_test_arg_t arg = { pool, queue, mempool_alloc(pool, false) };
+            pthread_create(&tid, NULL, timed_release_thread, &arg);
+            uint8_t *got = mempool_queue_dequeue_timed(queue, &len, MEMPOOL_WAIT_FOREVER);
+            pthread_join(tid, NULL);
+            MEMPOOL_ASSERT(got == arg.block && len == 7);
+            MEMPOOL_ASSERT(queue->wait.waiters == 0);
+            mempool_free(pool, got);
+        }
+
+        mempool_queue_destroy(queue);
+        mempool_destroy(pool);
+    }
+
+    // 共享池: 另一个进程释放块唤醒本进程的等待者
+    mempool_t *pool = mempool_create_shared(NULL, TEST_BLOCK_SIZE, 1);
+    MEMPOOL_ASSERT(pool != NULL);
+    uint8_t *block = mempool_alloc(pool, false);
+    pid_t pid = fork();
+    MEMPOOL_ASSERT(pid >= 0);
+    if (pid == 0) {
+        usleep(10000);
+        mempool_free(pool, block);
+        _exit(0);
+    }
+    MEMPOOL_ASSERT(mempool_alloc_timed(pool, false, 5000000000ull) == block);
+    int status;
+    MEMPOOL_ASSERT(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    mempool_free(pool, block);
+    mempool_destroy(pool);
+
+    DEBUG_PRINT("Timed allocation and dequeue test passed!");
+}
+
+// 引用计数扇出测试线程: 消费者出队后释放自己的引用
+static void *refcount_consumer_thread(void *arg) {
+    mempool_queue_t *queue = (mempool_queue_t *)arg;
+    size_t len;
+    for (int i = 0; i < 1000; i++) {
+        uint8_t *block = mempool_queue_dequeue_timed(queue, &len, MEMPOOL_WAIT_FOREVER);
+        MEMPOOL_ASSERT(block != NULL && block[0] == (uint8_t)i);
+        mempool_unref(queue->pool, block);
+    }
+    return NULL;
+}
+
+// 引用计数测试
+void test_mempool_refcount() {
+    DEBUG_PRINT("=== Testing refcounted blocks ===");
+
+    uint32_t flags[] = { MEMPOOL_FLAG_REFCOUNT, MEMPOOL_FLAG_REFCOUNT | MEMPOOL_FLAG_LOCKFREE };
+    for (size_t f = 0; f < sizeof(flags) / sizeof(flags[0]); f++) {
+        mempool_t *pool = mempool_create_flags(TEST_BLOCK_SIZE, 16, flags[f]);
+        MEMPOOL_ASSERT(pool != NULL && pool->refcount != NULL);
+
+        // 最后一个引用释放时才归还
+        uint8_t *block = mempool_alloc(pool, false);
+        MEMPOOL_ASSERT(mempool_refcount(pool, block) == 1);
+        MEMPOOL_ASSERT(mempool_ref(pool, block) == 0 && mempool_ref(pool, block) == 0);
+        MEMPOOL_ASSERT(mempool_refcount(pool, block) == 3);
+        mempool_unref(pool, block);
+        mempool_free(pool, block);
+        MEMPOOL_ASSERT(mempool_available(pool) == 15 && mempool_refcount(pool, block) == 1);
+        mempool_unref(pool, block);
+        MEMPOOL_ASSERT(mempool_available(pool) == 16 && mempool_refcount(pool, block) == 0);
+
+        // 空闲块与非法指针不能增加引用
+        MEMPOOL_ASSERT(mempool_ref(pool, block) == -1);
+        MEMPOOL_ASSERT(mempool_ref(pool, (uint8_t *)&block) == -1);
+
+        // 批量释放同样按引用计数
+        uint8_t *blocks[4];
+        MEMPOOL_ASSERT(mempool_alloc_batch(pool, blocks, 4, false) == 4);
+        mempool_ref(pool, blocks[1]);
+        mempool_free_batch(pool, blocks, 4);
+        MEMPOOL_ASSERT(mempool_available(pool) == 15);
+        mempool_free(pool, blocks[1]);
+        MEMPOOL_ASSERT(mempool_available(pool) == 16);
+
+        // 重新分配的块引用数从1开始
+        block = mempool_alloc(pool, false);
+        MEMPOOL_ASSERT(mempool_refcount(pool, block) == 1);
+        mempool_free(pool, block);
+        mempool_destroy(pool);
+    }
+
+    // 释放进线程缓存的块同样视为空闲
+    mempool_t *cached = mempool_create_flags(TEST_BLOCK_SIZE, 16, MEMPOOL_FLAG_REFCOUNT);
+    MEMPOOL_ASSERT(mempool_magazine_enable(cached, 4) == 0);
+    uint8_t *held = mempool_alloc(cached, false);
+    mempool_free(cached, held);
+    MEMPOOL_ASSERT(mempool_refcount(cached, held) == 0 && mempool_ref(cached, held) == -1);
+    held = mempool_alloc(cached, false);
+    MEMPOOL_ASSERT(mempool_refcount(cached, held) == 1);
+    mempool_free(cached, held);
+    mempool_destroy(cached);
+
+    // 未启用引用计数时
+    mempool_t *plain = mempool_create(TEST_BLOCK_SIZE, 4);
+    uint8_t *block = mempool_alloc(plain, false);
+    MEMPOOL_ASSERT(plain->refcount == NULL && mempool_ref(plain, block) == -1);
+    mempool_free(plain, block);
+    MEMPOOL_ASSERT(mempool_available(plain) == 4);
+    mempool_destroy(plain);
+
+    // 零拷贝扇出: 同一块同时送入三个无锁队列, 各消费者释放后才归还
+    mempool_t *pool = mempool_create_flags(TEST_BLOCK_SIZE, 64, MEMPOOL_FLAG_REFCOUNT | MEMPOOL_FLAG_LOCKFREE);
+    mempool_queue_t *queues[3];
+    pthread_t tids[3];
+    for (int q = 0; q < 3; q++) {
+        queues[q] = mempool_queue_create_mode(pool, 64, MEMPOOL_QUEUE_SPSC);
+        pthread_create(&tids[q], NULL, refcount_consumer_thread, queues[q]);
+    }
+    for (int i = 0; i < 1000; i++) {
+        uint8_t *frame = mempool_alloc_timed(pool, false, MEMPOOL_WAIT_FOREVER);
+        frame[0] = (uint8_t)i;
+        mempool_ref(pool, frame);
+        mempool_ref(pool, frame);
+        for (int q = 0; q < 3; q++) {
+            while (mempool_queue_enqueue_with_length(queues[q], frame, 1) != 0) {
+                sched_yield();
+            }
+        }
+    }
+    for (int q = 0; q < 3; q++) {
+        pthread_join(tids[q], NULL);
+        mempool_queue_destroy(queues[q]);
+    }
+    MEMPOOL_ASSERT(mempool_available(pool) == 64);
+    mempool_destroy(pool);
+
+    DEBUG_PRINT("Refcounted blocks test passed!");
+}
+
+// 按链内容逐字节校验(第i字节为(i * 7 + seed))
+static void chain_test_verify(mempool_chain_t *chain, size_t len, uint8_t seed) {
+    MEMPOOL_ASSERT(chain->length == len);
+    uint8_t *buf = malloc(len + 1);
+    MEMPOOL_ASSERT(mempool_chain_copy_out(chain, 0, buf, len + 1) == len);
+    for (size_t i = 0; i < len; i++) {
+        MEMPOOL_ASSERT(buf[i] == (uint8_t)(i * 7 + seed));
+    }
+    free(buf);
+}
+
+// 缓冲链测试
+void test_mempool_chain() {
+    DEBUG_PRINT("=== Testing scatter-gather chains ===");
+
+    uint8_t frame[9000];
+    for (size_t i = 0; i < sizeof(frame); i++) {
+        frame[i] = (uint8_t)(i * 7);
+    }
+
+    uint32_t flags[] = { 0, MEMPOOL_FLAG_REFCOUNT };
+    for (size_t f = 0; f < sizeof(flags) / sizeof(flags[0]); f++) {
+        mempool_t *pool = mempool_create_flags(2048, 16, flags[f]);
+        mempool_t *seg_pool = mempool_create(sizeof(mempool_seg_t), 32);
+        mempool_chain_t chain, tail;
+
+        // 9000字节巨帧: 分段追加, 前段填满尾块剩余空间
+        mempool_chain_init(&chain, pool, seg_pool);
+        MEMPOOL_ASSERT(mempool_chain_append(&chain, frame, 100) == 0);
+        MEMPOOL_ASSERT(mempool_chain_append(&chain, frame + 100, 8900) == 0);
+        MEMPOOL_ASSERT(chain.segs == 5 && mempool_available(pool) == 11);
+        chain_test_verify(&chain, 9000, 0);
+        MEMPOOL_ASSERT(mempool_chain_linearize(&chain) == NULL); // 超过块大小
+
+        // iovec导出
+        struct iovec iov[8];
+        MEMPOOL_ASSERT(mempool_chain_to_iovec(&chain, iov, 4) == -1);
+        MEMPOOL_ASSERT(mempool_chain_to_iovec(&chain, iov, -1) == -1);
+        int n = mempool_chain_to_iovec(&chain, iov, 8);
+        MEMPOOL_ASSERT(n == 5);
+        size_t total = 0;
+        for (int i = 0; i < n; i++) {
+            MEMPOOL_ASSERT(memcmp(iov[i].iov_base, frame + total, iov[i].iov_len) == 0);
+            total += iov[i].iov_len;
+        }
+        MEMPOOL_ASSERT(total == 9000);
+
+        // 在段中间拆分
+        MEMPOOL_ASSERT(mempool_chain_split(&chain, 3000, &tail) == 0);
+        chain_test_verify(&chain, 3000, 0);
+        chain_test_verify(&tail, 6000, (uint8_t)(3000 * 7));
+        MEMPOOL_ASSERT(chain.segs == 2 && tail.segs == 4);
+        if (flags[f] & MEMPOOL_FLAG_REFCOUNT) {
+            // 共享块: 尾部空间属于另一条链, 追加时不能写入
+            MEMPOOL_ASSERT(mempool_refcount(pool, chain.tail->block) == 2 && tail.head->block == chain.tail->block);
+            MEMPOOL_ASSERT(mempool_chain_append(&chain, frame + 3000, 10) == 0 && chain.segs == 3);
+            chain_test_verify(&tail, 6000, (uint8_t)(3000 * 7));
+        } else {
+            MEMPOOL_ASSERT(mempool_chain_append(&chain, frame + 3000, 10) == 0 && chain.segs == 2);
+        }
+        chain_test_verify(&chain, 3010, 0);
+        mempool_chain_free(&tail);
+        MEMPOOL_ASSERT(tail.length == 0 && tail.head == NULL);
+
+        // 在段边界拆分, 以及在0处拆分
+        mempool_chain_t rest;
+        MEMPOOL_ASSERT(mempool_chain_split(&chain, 2048, &rest) == 0);
+        MEMPOOL_ASSERT(chain.segs == 1 && rest.length == 962);
+        MEMPOOL_ASSERT(mempool_chain_split(&chain, 0, &tail) == 0);
+        MEMPOOL_ASSERT(chain.head == NULL && chain.length == 0 && tail.length == 2048);
+        MEMPOOL_ASSERT(mempool_chain_split(&tail, 4000, &chain) == -1);
+        mempool_chain_free(&tail);
+        mempool_chain_free(&rest);
+        MEMPOOL_ASSERT(mempool_available(pool) == 16 && mempool_available(seg_pool) == 32);
+
+        // 前插: 新块数据靠块尾存放, 再次前插使用头部空间
+        mempool_chain_init(&chain, pool, NULL);
+        MEMPOOL_ASSERT(mempool_chain_append(&chain, frame + 3000, 500) == 0);
+        MEMPOOL_ASSERT(mempool_chain_prepend(&chain, frame + 2500, 500) == 0);
+        MEMPOOL_ASSERT(mempool_chain_prepend(&chain, frame, 2500) == 0);
+        MEMPOOL_ASSERT(chain.segs == 3);
+        chain_test_verify(&chain, 3500, 0);
+
+        // 线性化: 拆出不超过块大小的部分后合并为单个块
+        MEMPOOL_ASSERT(mempool_chain_split(&chain, 1500, &tail) == 0);
+        mempool_chain_free(&chain);
+        MEMPOOL_ASSERT(tail.segs == 2);
+        uint8_t *flat = mempool_chain_linearize(&tail);
+        MEMPOOL_ASSERT(flat != NULL && tail.segs == 1 && memcmp(flat, frame + 1500, 2000) == 0);
+        MEMPOOL_ASSERT(mempool_chain_linearize(&tail) == flat);
+        mempool_chain_free(&tail);
+
+        // 零拷贝追加已有块
+        mempool_chain_init(&chain, pool, seg_pool);
+        uint8_t *block = mempool_alloc(pool, false);
+        memcpy(block + 64, frame, 1000);
+        MEMPOOL_ASSERT(mempool_chain_append_block(&chain, block, 64, 1000) == 0);
+        MEMPOOL_ASSERT(mempool_chain_append_block(&chain, block + 1, 0, 10) == -1);
+        MEMPOOL_ASSERT(mempool_chain_append(&chain, frame + 1000, 2000) == 0);
+        chain_test_verify(&chain, 3000, 0);
+        mempool_chain_free(&chain);
+
+        // 块耗尽时追加失败, 链保持不变
+        mempool_chain_init(&chain, pool, seg_pool);
+        MEMPOOL_ASSERT(mempool_chain_append(&chain, frame, 9000) == 0);
+        uint8_t *big = malloc(16 * 2048);
+        MEMPOOL_ASSERT(mempool_chain_append(&chain, big, 12 * 2048) == -1);
+        MEMPOOL_ASSERT(mempool_chain_prepend(&chain, big, 12 * 2048) == -1);
+        free(big);
+        chain_test_verify(&chain, 9000, 0);
+        MEMPOOL_ASSERT(mempool_available(pool) == 11);
+        mempool_chain_free(&chain);
+
+        MEMPOOL_ASSERT(mempool_available(pool) == 16 && mempool_available(seg_pool) == 32);
+        mempool_destroy(seg_pool);
+        mempool_destroy(pool);
+    }
+
+    DEBUG_PRINT("Scatter-gather chain test passed!");
+}
+
+// 报文缓冲视图测试
+void test_mempool_pkt() {
+    DEBUG_PRINT("=== Testing packet buffer headroom/tailroom ===");
+
+    mempool_t *pool = mempool_create(2048, 8);
+    mempool_pkt_t pkt;
+
+    MEMPOOL_ASSERT(mempool_pkt_alloc(pool, 4096, &pkt) == -1);
+    MEMPOOL_ASSERT(mempool_pkt_alloc(pool, MEMPOOL_PKT_DEFAULT_HEADROOM, &pkt) == 0);
+    MEMPOOL_ASSERT(pkt.length == 0 && mempool_pkt_headroom(&pkt) == MEMPOOL_PKT_DEFAULT_HEADROOM);
+    MEMPOOL_ASSERT(mempool_pkt_tailroom(&pkt) == 2048 - MEMPOOL_PKT_DEFAULT_HEADROOM);
+
+    // 负载写入后逐层插入报头, 负载地址不变
+    uint8_t *payload = mempool_pkt_put(&pkt, 100);
+    memset(payload, 0xAB, 100);
+    uint8_t *udp = mempool_pkt_push(&pkt, 8);
+    uint8_t *ip = mempool_pkt_push(&pkt, 20);
+    uint8_t *eth = mempool_pkt_push(&pkt, 14);
+    MEMPOOL_ASSERT(udp == payload - 8 && ip == udp - 20 && eth == ip - 14);
+    MEMPOOL_ASSERT(mempool_pkt_data(&pkt) == eth && pkt.length == 142);
+    memset(eth, 0xEE, 14);
+    MEMPOOL_ASSERT(mempool_pkt_push(&pkt, MEMPOOL_PKT_DEFAULT_HEADROOM) == NULL); // 头部空间不足
+    MEMPOOL_ASSERT(mempool_pkt_put(&pkt, 4096) == NULL);                         // 尾部空间不足
+
+    // 经队列传递后偏移与长度保持不变
+    uint32_t modes[] = { MEMPOOL_QUEUE_LOCKED, MEMPOOL_QUEUE_SPSC, MEMPOOL_QUEUE_MPMC };
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        mempool_queue_t *queue = mempool_queue_create_mode(pool, 4, modes[m]);
+        mempool_pkt_t rx;
+        MEMPOOL_ASSERT(mempool_pkt_enqueue(queue, &pkt) == 0);
+        MEMPOOL_ASSERT(mempool_pkt_dequeue(queue, &rx) == 0);
+        MEMPOOL_ASSERT(rx.block == pkt.block && rx.offset == pkt.offset && rx.length == pkt.length && rx.size == 2048);
+        MEMPOOL_ASSERT(mempool_pkt_dequeue(queue, &rx) == -1);
+        MEMPOOL_ASSERT(mempool_pkt_dequeue_timed(queue, &rx, 1000000) == -1);
+        mempool_queue_destroy(queue);
+    }
+
+    // 接收侧逐层剥离报头
+    MEMPOOL_ASSERT(mempool_pkt_pull(&pkt, 14) == ip);
+    MEMPOOL_ASSERT(mempool_pkt_pull(&pkt, 28) == payload && pkt.length == 100);
+    MEMPOOL_ASSERT(mempool_pkt_data(&pkt)[99] == 0xAB);
+    MEMPOOL_ASSERT(mempool_pkt_pull(&pkt, 101) == NULL);
+    mempool_pkt_trim(&pkt, 60);
+    MEMPOOL_ASSERT(pkt.length == 60);
+    mempool_pkt_trim(&pkt, 80);
+    MEMPOOL_ASSERT(pkt.length == 60);
+
+    // 在接收到的块上建立视图
+    mempool_pkt_t view;
+    MEMPOOL_ASSERT(mempool_pkt_attach(pool, pkt.block, 64, 1500, &view) == 0);
+    MEMPOOL_ASSERT(mempool_pkt_attach(pool, pkt.block + 1, 0, 10, &view) == -1);
+    MEMPOOL_ASSERT(mempool_pkt_attach(pool, pkt.block, 1000, 1500, &view) == -1);
+
+    mempool_pkt_free(pool, &pkt);
+    MEMPOOL_ASSERT(pkt.block == NULL && mempool_available(pool) == 8);
+    mempool_destroy(pool);
+
+    DEBUG_PRINT("Packet buffer test passed!");
+}
+
+#if MEMPOOL_STATS_EN
+// 统计计数测试线程
+static void *stats_worker_thread(void *arg) {
+    mempool_t *pool = (mempool_t *)arg;
+    for (int i = 0; i < 20000; i++) {
+        uint8_t *block = mempool_alloc(pool, false);
+        if (block) mempool_free(pool, block);
+    }
+    return NULL;
+}
+#endif
+
+// 统计计数测试
+void test_mempool_stats() {
+    DEBUG_PRINT("=== Testing pool and queue statistics ===");
+
+#if MEMPOOL_STATS_EN
+    mempool_stats_t stats;
+
+    uint32_t flags[] = { 0, MEMPOOL_FLAG_LOCKFREE };
+    for (size_t f = 0; f < sizeof(flags) / sizeof(flags[0]); f++) {
+        mempool_t *pool = mempool_create_flags(TEST_BLOCK_SIZE, 64, flags[f]);
+        MEMPOOL_ASSERT(mempool_get_stats(pool, &stats) == 0);
+        MEMPOOL_ASSERT(stats.allocs == 0 && stats.in_use == 0 && stats.peak_in_use == 0);
+
+        // 峰值在释放后保持
+        uint8_t *blocks[64];
+        for (int i = 0; i < 40; i++) {
+            blocks[i] = mempool_alloc(pool, i < 3);
+        }
+        for (int i = 0; i < 30; i++) {
+            mempool_free(pool, blocks[i]);
+        }
+        MEMPOOL_ASSERT(mempool_get_stats(pool, &stats) == 0);
+        MEMPOOL_ASSERT(stats.allocs == 40 && stats.frees == 30 && stats.in_use == 10);
+        MEMPOOL_ASSERT(stats.peak_in_use == 40 && stats.hw_owned == 0);
+        mempool_alloc(pool, true);
+        MEMPOOL_ASSERT(mempool_get_stats(pool, &stats) == 0 && stats.hw_owned == 1);
+
+        // 批量分配不足与耗尽时计为失败
+        MEMPOOL_ASSERT(mempool_alloc_batch(pool, blocks, 64, false) == 53);
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == NULL);
+        MEMPOOL_ASSERT(mempool_get_stats(pool, &stats) == 0);
+        MEMPOOL_ASSERT(stats.alloc_failures == 2 && stats.in_use == 64 && stats.peak_in_use == 64);
+        // 阻塞分配等待中的重试不计数, 超时只计一次失败
+        MEMPOOL_ASSERT(mempool_alloc_timed(pool, false, 2000000) == NULL);
+        MEMPOOL_ASSERT(mempool_get_stats(pool, &stats) == 0 && stats.alloc_failures == 3 && stats.allocs == 94);
+        mempool_free_batch(pool, blocks, 53);
+        MEMPOOL_ASSERT(mempool_get_stats(pool, &stats) == 0 && stats.frees == 83 && stats.in_use == 11);
+
+        // 重复释放被忽略, 不计入释放次数
+        mempool_free(pool, blocks[0]);
+        mempool_free_batch(pool, blocks, 4);
+        MEMPOOL_ASSERT(mempool_get_stats(pool, &stats) == 0 && stats.frees == 83 && stats.in_use == 11);
+        mempool_destroy(pool);
+    }
+
+    // 线程缓存: 缓存补充/溢出不重复计数
+    mempool_t *pool = mempool_create(TEST_BLOCK_SIZE, 64);
+    MEMPOOL_ASSERT(mempool_magazine_enable(pool, 8) == 0);
+    for (int round = 0; round < 10; round++) {
+        uint8_t *blocks[20];
+        for (int i = 0; i < 20; i++) blocks[i] = mempool_alloc(pool, false);
+        for (int i = 0; i < 20; i++) mempool_free(pool, blocks[i]);
+    }
+    MEMPOOL_ASSERT(mempool_get_stats(pool, &stats) == 0);
+    MEMPOOL_ASSERT(stats.allocs == 200 && stats.frees == 200 && stats.in_use == 0 && stats.peak_in_use == 20);
+    mempool_destroy(pool);
+
+    // 引用计数池: 最后一个引用释放时才计为释放
+    pool = mempool_create_flags(TEST_BLOCK_SIZE, 4, MEMPOOL_FLAG_REFCOUNT);
+    uint8_t *block = mempool_alloc(pool, false);
+    mempool_ref(pool, block);
+    mempool_unref(pool, block);
+    MEMPOOL_ASSERT(mempool_get_stats(pool, &stats) == 0 && stats.frees == 0 && stats.in_use == 1);
+    mempool_unref(pool, block);
+    MEMPOOL_ASSERT(mempool_get_stats(pool, &stats) == 0 && stats.frees == 1 && stats.in_use == 0);
+    mempool_destroy(pool);
+
+    // 多线程: 各分片汇总后计数准确
+    pool = mempool_create(TEST_BLOCK_SIZE, 16);
+    pthread_t tids[4];
+    for (int i = 0; i < 4; i++) pthread_create(&tids[i], NULL, stats_worker_thread, pool);
+    for (int i = 0; i < 4; i++) pthread_join(tids[i], NULL);
+    MEMPOOL_ASSERT(mempool_get_stats(pool, &stats) == 0);
+    MEMPOOL_ASSERT(stats.allocs + stats.alloc_failures == 80000 && stats.allocs == stats.frees && stats.in_use == 0);
+    MEMPOOL_ASSERT(stats.peak_in_use >= 1 && stats.peak_in_use <= 16);
+    DEBUG_PRINT("4 threads: %zu allocs, %zu lock contentions, peak %zu", stats.allocs, stats.lock_contended, stats.peak_in_use);
+    mempool_destroy(pool);
+
+    // 队列: 深度峰值与拒绝次数
+    uint32_t modes[] = { MEMPOOL_QUEUE_LOCKED, MEMPOOL_QUEUE_SPSC, MEMPOOL_QUEUE_MPMC };
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        pool = mempool_create(TEST_BLOCK_SIZE, 16);
+        mempool_queue_t *queue = mempool_queue_create_mode(pool, 5, modes[m]);
+        mempool_queue_stats_t qstats;
+        uint8_t *blocks[8];
+        mempool_alloc_batch(pool, blocks, 8, false);
+
+        for (int round = 0; round < 3; round++) {
+            for (int i = 0; i < 3; i++) MEMPOOL_ASSERT(mempool_queue_enqueue(queue, blocks[i]) == 0);
+            for (int i = 0; i < 3; i++) MEMPOOL_ASSERT(mempool_queue_dequeue(queue) != NULL);
+        }
+        for (int i = 0; i < 5; i++) MEMPOOL_ASSERT(mempool_queue_enqueue(queue, blocks[i]) == 0);
+        MEMPOOL_ASSERT(mempool_queue_enqueue(queue, blocks[5]) == -1);
+        MEMPOOL_ASSERT(mempool_queue_enqueue(queue, NULL) == -1);
+        MEMPOOL_ASSERT(mempool_queue_dequeue(queue) != NULL);
+
+        MEMPOOL_ASSERT(mempool_queue_get_stats(queue, &qstats) == 0);
+        MEMPOOL_ASSERT(qstats.depth == 4 && qstats.peak_depth == 5 && qstats.enqueue_rejected == 2);
+
+        mempool_queue_destroy(queue);
+        mempool_destroy(pool);
+    }
+#else
+    MEMPOOL_ASSERT(mempool_get_stats(NULL, NULL) == -1);
+#endif
+
+    DEBUG_PRINT("Statistics test passed!");
+}
+
+#if MEMPOOL_HISTOGRAM_EN
+// 延迟直方图测试线程: 退出后计数仍保留
+static void *hist_worker_thread(void *arg) {
+    mempool_t *pool = (mempool_t *)arg;
+    for (int i = 0; i < 1000; i++) {
+        mempool_free(pool, mempool_alloc(pool, false));
+    }
+    return NULL;
+}
+#endif
+
+// 延迟直方图测试
+void test_mempool_hist() {
+    DEBUG_PRINT("=== Testing latency histograms ===");
+
+#if MEMPOOL_HISTOGRAM_EN
+    mempool_hist_summary_t summary;
+    uint64_t ns;
+
+    MEMPOOL_ASSERT(mempool_hist_reset() == 0);
+    MEMPOOL_ASSERT(mempool_hist_summary(MEMPOOL_HIST_ALLOC, &summary) == 0 && summary.count == 0);
+    MEMPOOL_ASSERT(mempool_hist_percentile(MEMPOOL_HIST_ALLOC, 50.0, &ns) == -1);
+
+    mempool_t *pool = mempool_create(TEST_BLOCK_SIZE, 16);
+    for (int i = 0; i < 1000; i++) {
+        mempool_free(pool, mempool_alloc(pool, false));
+    }
+    pthread_t tid;
+    pthread_create(&tid, NULL, hist_worker_thread, pool);
+    pthread_join(tid, NULL);
+
+    uint32_t modes[] = { MEMPOOL_QUEUE_LOCKED, MEMPOOL_QUEUE_SPSC, MEMPOOL_QUEUE_MPMC };
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        mempool_queue_t *queue = mempool_queue_create_mode(pool, 8, modes[m]);
+        uint8_t *blocks[4];
+        mempool_alloc_batch(pool, blocks, 4, false);
+        for (int i = 0; i < 4; i++) MEMPOOL_ASSERT(mempool_queue_enqueue(queue, blocks[i]) == 0);
+        MEMPOOL_ASSERT(mempool_queue_dequeue(queue) != NULL);
+        MEMPOOL_ASSERT(mempool_queue_dequeue_batch(queue, blocks, 4) == 3);
+        // 阻塞出队超时只记录一次, 等待中的重试不计入
+        MEMPOOL_ASSERT(mempool_queue_dequeue_timed(queue, NULL, 1000000) == NULL);
+        mempool_free_batch(pool, blocks, 3);
+        mempool_queue_destroy(queue);
+    }
+    uint8_t *all[16];
+    size_t held = mempool_alloc_batch(pool, all, 16, false);
+    MEMPOOL_ASSERT(mempool_alloc_timed(pool, false, 1000000) == NULL);
+    mempool_free_batch(pool, all, held);
+
+    // 已退出线程的计数合并保留; 批量分配/释放不计入单块直方图
+    MEMPOOL_ASSERT(mempool_hist_summary(MEMPOOL_HIST_ALLOC, &summary) == 0 && summary.count == 2001);
+    MEMPOOL_ASSERT(summary.p50_ns <= summary.p90_ns && summary.p90_ns <= summary.p99_ns);
+    MEMPOOL_ASSERT(summary.p99_ns <= summary.p999_ns && summary.p999_ns <= summary.max_ns);
+    MEMPOOL_ASSERT(summary.mean_ns <= summary.max_ns);
+    MEMPOOL_ASSERT(mempool_hist_summary(MEMPOOL_HIST_FREE, &summary) == 0 && summary.count == 2000);
+    MEMPOOL_ASSERT(mempool_hist_summary(MEMPOOL_HIST_ENQUEUE, &summary) == 0 && summary.count == 12);
+    MEMPOOL_ASSERT(mempool_hist_summary(MEMPOOL_HIST_DEQUEUE, &summary) == 0 && summary.count == 9);
+    MEMPOOL_ASSERT(mempool_hist_percentile(MEMPOOL_HIST_DEQUEUE, 100.0, &ns) == 0 && ns == summary.max_ns);
+    MEMPOOL_ASSERT(mempool_hist_percentile(MEMPOOL_HIST_DEQUEUE, 101.0, &ns) == -1);
+    MEMPOOL_ASSERT(mempool_hist_dump(stdout) == 0);
+
+    MEMPOOL_ASSERT(mempool_hist_reset() == 0);
+    MEMPOOL_ASSERT(mempool_hist_summary(MEMPOOL_HIST_FREE, &summary) == 0 && summary.count == 0);
+    mempool_destroy(pool);
+#else
+    MEMPOOL_ASSERT(mempool_hist_summary(MEMPOOL_HIST_ALLOC, NULL) == -1);
+    MEMPOOL_ASSERT(mempool_hist_dump(stdout) == -1);
+#endif
+
+    DEBUG_PRINT("Latency histogram test passed!");
+}
+
+// 编译期定长池: 100字节取整为128, 130块(最后一个位图字只有2位有效)
+MEMPOOL_STATIC_DEFINE(test_static_pool, 100, 130)
+static test_static_pool_t test_static;
+
+static void *static_worker_thread(void *arg) {
+    (void)arg;
+    for (int i = 0; i < 20000; i++) {
+        uint8_t *block = test_static_pool_alloc(&test_static, false);
+        if (block) {
+            block[0] = (uint8_t)i;
+            test_static_pool_free(&test_static, block);
+        }
+    }
+    return NULL;
+}
+
+// 编译期定长池测试
+void test_mempool_static() {
+    DEBUG_PRINT("=== Testing compile-time static pool ===");
+
+    MEMPOOL_ASSERT(test_static_pool_BLOCK_SIZE == 128 && test_static_pool_SHIFT == 7);
+    MEMPOOL_ASSERT(test_static_pool_WORDS == 3 && sizeof(test_static.area) == 128 * 130);
+    MEMPOOL_ASSERT(((uintptr_t)test_static.area & (MEMPOOL_ALIGNMENT - 1)) == 0);
+
+    test_static_pool_init(&test_static);
+    MEMPOOL_ASSERT(test_static_pool_available(&test_static) == 130);
+
+    uint8_t *blocks[130];
+    for (int i = 0; i < 130; i++) {
+        blocks[i] = test_static_pool_alloc(&test_static, i == 5);
+        MEMPOOL_ASSERT(blocks[i] == test_static.area + (size_t)i * 128);
+        MEMPOOL_ASSERT(test_static_pool_index(&test_static, blocks[i]) == (size_t)i);
+    }
+    MEMPOOL_ASSERT(test_static_pool_alloc(&test_static, false) == NULL);
+    MEMPOOL_ASSERT(test_static_pool_is_hw_owned(&test_static, blocks[5]));
+    MEMPOOL_ASSERT(!test_static_pool_is_hw_owned(&test_static, blocks[6]));
+
+    // 释放清除硬件标记; 越界与重复释放被忽略; 块内地址释放所在块
+    test_static_pool_free(&test_static, blocks[5]);
+    MEMPOOL_ASSERT(!test_static_pool_is_hw_owned(&test_static, blocks[5]));
+    test_static_pool_free(&test_static, blocks[5]);
+    test_static_pool_free(&test_static, test_static.area + sizeof(test_static.area));
+    MEMPOOL_ASSERT(test_static_pool_available(&test_static) == 1);
+    test_static_pool_free(&test_static, blocks[129] + 17);
+    MEMPOOL_ASSERT(test_static_pool_alloc(&test_static, false) == blocks[5]);
+    MEMPOOL_ASSERT(test_static_pool_alloc(&test_static, false) == blocks[129]);
+
+    for (int i = 0; i < 130; i++) {
+        test_static_pool_free(&test_static, blocks[i]);
+    }
+    MEMPOOL_ASSERT(test_static_pool_available(&test_static) == 130);
+
+    // 多线程并发分配/释放后块数不变
+    pthread_t tids[4];
+    for (int i = 0; i < 4; i++) pthread_create(&tids[i], NULL, static_worker_thread, NULL);
+    for (int i = 0; i < 4; i++) pthread_join(tids[i], NULL);
+    MEMPOOL_ASSERT(test_static_pool_available(&test_static) == 130);
+
+    DEBUG_PRINT("Static pool test passed!");
+}
+
+// 逐位参考实现: 首个置位
+static long bitmap_ref_find_first(const BITMAP_TYPE *bitmap, size_t nbits)
+{
+    for (size_t i = 0; i < nbits; i++) {
+        if ((bitmap[i / MEMPOOL_BITMAP_EACH_NUM] >> (i % MEMPOOL_BITMAP_EACH_NUM)) & 1) return (long)i;
+    }
+    return -1;
+}
+
+// 逐位参考实现: 第一段连续n个置位
+static long bitmap_ref_find_run(const BITMAP_TYPE *bitmap, size_t nbits, size_t n)
+{
+    size_t len = 0;
+    for (size_t i = 0; i < nbits && n > 0; i++) {
+        len = ((bitmap[i / MEMPOOL_BITMAP_EACH_NUM] >> (i % MEMPOOL_BITMAP_EACH_NUM)) & 1) ? len + 1 : 0;
+        if (len == n) return (long)(i + 1 - n);
+    }
+    return -1;
+}
+
+static bool pool_block_hw_owned(mempool_t *pool, const uint8_t *ptr)
+{
+    size_t idx = (size_t)(ptr - pool->memory_area) / pool->block_size;
+    return (pool->hw_owned_bitmap[idx / MEMPOOL_BITMAP_EACH_NUM] >> (idx % MEMPOOL_BITMAP_EACH_NUM)) & 1;
+}
+
+// 位图查找内核与连续块分配测试
+void test_mempool_bitmap() {
+    DEBUG_PRINT("=== Testing bitmap kernels ===");
+
+    static const mempool_bitmap_kernel_t kernels[] = {
+        MEMPOOL_BITMAP_KERNEL_SCALAR, MEMPOOL_BITMAP_KERNEL_SSE2, MEMPOOL_BITMAP_KERNEL_AVX2,
+    };
+    static const size_t word_counts[] = { 1, 2, 3, 4, 7, 8, 9, 16, 33 };
+    static const size_t runs[] = { 1, 2, 3, 7, 8, 31, 32, 33, 64, 65, 100, 200 };
+    static const int densities[] = { 0, 1, 50, 90, 99, 100 };
+    BITMAP_TYPE bitmap[33];
+
+    MEMPOOL_ASSERT(mempool_bitmap_set_kernel(MEMPOOL_BITMAP_KERNEL_SCALAR) == 0);
+    srand(21);
+
+    // 各内核与逐位参考实现结果一致(随机密度、不同字数、不同区间长度)
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (mempool_bitmap_set_kernel(kernels[k]) != 0) {
+            DEBUG_PRINT("Bitmap kernel %d not supported, skipped", (int)kernels[k]);
+            continue;
+        }
+        for (size_t wc = 0; wc < sizeof(word_counts) / sizeof(word_counts[0]); wc++) {
+            size_t words = word_counts[wc];
+            size_t nbits = words * MEMPOOL_BITMAP_EACH_NUM;
+            for (size_t d = 0; d < sizeof(densities) / sizeof(densities[0]); d++) {
+                for (int round = 0; round < 20; round++) {
+                    memset(bitmap, 0, sizeof(bitmap));
+                    for (size_t i = 0; i < nbits; i++) {
+                        if (rand() % 100 < densities[d]) {
+                            bitmap[i / MEMPOOL_BITMAP_EACH_NUM] |= (BITMAP_TYPE)1 << (i % MEMPOOL_BITMAP_EACH_NUM);
+                        }
+                    }
+                    // 部分轮次写入一段较长的连续置位, 覆盖跨字区间
+                    if (round % 2) {
+                        size_t from = (size_t)rand() % nbits;
+                        size_t len = (size_t)rand() % (nbits - from) + 1;
+                        for (size_t i = from; i < from + len; i++) {
+                            bitmap[i / MEMPOOL_BITMAP_EACH_NUM] |= (BITMAP_TYPE)1 << (i % MEMPOOL_BITMAP_EACH_NUM);
+                        }
+                    }
+
+                    size_t pop = 0;
+                    for (size_t i = 0; i < nbits; i++) {
+                        pop += (bitmap[i / MEMPOOL_BITMAP_EACH_NUM] >> (i % MEMPOOL_BITMAP_EACH_NUM)) & 1;
+                    }
+                    MEMPOOL_ASSERT(mempool_bitmap_popcount(bitmap, words) == pop);
+                    MEMPOOL_ASSERT(mempool_bitmap_find_first(bitmap, words) == bitmap_ref_find_first(bitmap, nbits));
+                    for (size_t r = 0; r < sizeof(runs) / sizeof(runs[0]); r++) {
+                        // 也覆盖nbits不是字宽整数倍的情况
+                        size_t limit = nbits - (size_t)round % 5;
+                        MEMPOOL_ASSERT(mempool_bitmap_find_run(bitmap, limit, runs[r]) ==
+                                       bitmap_ref_find_run(bitmap, limit, runs[r]));
+                    }
+                }
+            }
+        }
+    }
+    MEMPOOL_ASSERT(mempool_bitmap_find_run(bitmap, 64, 0) == -1);
+    MEMPOOL_ASSERT(mempool_bitmap_set_kernel(MEMPOOL_BITMAP_KERNEL_AUTO) == 0);
+    DEBUG_PRINT("Bitmap kernel: %s", mempool_bitmap_kernel_name());
+
+    // 连续块分配: 有锁与无锁模式
+    static const uint32_t modes[] = { 0, MEMPOOL_FLAG_LOCKFREE };
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        mempool_t *pool = mempool_create_flags(64, 200, modes[m]);
+        MEMPOOL_ASSERT(pool != NULL);
+        size_t bs = pool->block_size;
+
+        uint8_t *ring = mempool_alloc_contiguous(pool, 10, true);
+        MEMPOOL_ASSERT(ring == pool->memory_area);
+        MEMPOOL_ASSERT(pool_block_hw_owned(pool, ring) && pool_block_hw_owned(pool, ring + 9 * bs));
+        MEMPOOL_ASSERT(mempool_available(pool) == 190);
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == ring + 10 * bs);
+        MEMPOOL_ASSERT(mempool_alloc_contiguous(pool, 191, false) == NULL);
+        MEMPOOL_ASSERT(mempool_alloc_contiguous(pool, 0, false) == NULL);
+
+        // 各块分别释放
+        for (int i = 0; i < 10; i++) {
+            mempool_free(pool, ring + (size_t)i * bs);
+        }
+        MEMPOOL_ASSERT(!pool_block_hw_owned(pool, ring));
+        mempool_free(pool, ring + 10 * bs);
+        MEMPOOL_ASSERT(mempool_available(pool) == 200);
+
+        // 碎片化: 全部分配后隔一个释放一个, 不存在长度2的连续区间
+        uint8_t *blocks[200];
+        MEMPOOL_ASSERT(mempool_alloc_batch(pool, blocks, 200, false) == 200);
+        for (int i = 0; i < 200; i += 2) {
+            mempool_free(pool, pool->memory_area + (size_t)i * bs);
+        }
+        MEMPOOL_ASSERT(mempool_alloc_contiguous(pool, 2, false) == NULL);
+        MEMPOOL_ASSERT(mempool_available(pool) == 100);
+
+        // 释放跨越多个位图字的一段后可整段分配
+        for (int i = 41; i < 148; i += 2) {
+            mempool_free(pool, pool->memory_area + (size_t)i * bs);
+        }
+        uint8_t *span = mempool_alloc_contiguous(pool, 109, false);
+        MEMPOOL_ASSERT(span == pool->memory_area + 40 * bs);
+        MEMPOOL_ASSERT(mempool_available(pool) == 100 + 54 - 109);
+        MEMPOOL_ASSERT(mempool_alloc_contiguous(pool, 2, false) == NULL);
+        for (int i = 40; i < 149; i++) {
+            mempool_free(pool, pool->memory_area + (size_t)i * bs);
+        }
+        MEMPOOL_ASSERT(mempool_available(pool) == 154);
+
+        mempool_destroy(pool);
+    }
+
+    DEBUG_PRINT("Bitmap kernel test passed!");
+}
+
+static void *lockfree_stress_thread(void *arg);
+
+// 分配位置策略测试
+void test_mempool_placement() {
+    DEBUG_PRINT("=== Testing placement policies ===");
+
+    static const uint32_t modes[] = { 0, MEMPOOL_FLAG_LOCKFREE };
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        mempool_t *pool = mempool_create_flags(64, 200, modes[m]);
+        MEMPOOL_ASSERT(pool != NULL);
+        uint8_t *base = pool->memory_area;
+        size_t bs = pool->block_size;
+        uint8_t *blocks[200];
+
+        MEMPOOL_ASSERT(mempool_set_placement(pool, 3) == -1);
+        MEMPOOL_ASSERT(mempool_set_placement(NULL, MEMPOOL_PLACEMENT_LIFO) == -1);
+
+        // first-fit: 释放后立即重用最低下标
+        for (int i = 0; i < 3; i++) blocks[i] = mempool_alloc(pool, false);
+        mempool_free(pool, blocks[0]);
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == base);
+
+        // next-fit: 从上次分配之后继续, 到末尾后回绕
+        MEMPOOL_ASSERT(mempool_set_placement(pool, MEMPOOL_PLACEMENT_NEXT_FIT) == 0);
+        mempool_free(pool, base + bs);
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == base + bs);
+        mempool_free(pool, base);
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == base + 3 * bs);
+        for (int i = 4; i < 200; i++) {
+            blocks[i] = mempool_alloc(pool, false);
+            MEMPOOL_ASSERT(blocks[i] == base + (size_t)i * bs);
+        }
+        MEMPOOL_ASSERT(mempool_alloc(pool, true) == base);
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == NULL);
+        mempool_free(pool, base + 150 * bs);
+        mempool_free(pool, base + 20 * bs);
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == base + 20 * bs);
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == base + 150 * bs);
+
+        // LIFO: 优先复用最近释放的块, 提示用尽后按first-fit
+        MEMPOOL_ASSERT(mempool_set_placement(pool, MEMPOOL_PLACEMENT_LIFO) == 0);
+        mempool_free(pool, base + 50 * bs);
+        mempool_free(pool, base + 130 * bs);
+        mempool_free(pool, base + 7 * bs);
+        mempool_free(pool, base + 90 * bs);
+        MEMPOOL_ASSERT(mempool_alloc(pool, true) == base + 90 * bs);
+        MEMPOOL_ASSERT(pool->hw_owned_bitmap[90 / MEMPOOL_BITMAP_EACH_NUM] & ((BITMAP_TYPE)1 << (90 % MEMPOOL_BITMAP_EACH_NUM)));
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == base + 7 * bs);
+        // 提示中的块已被其他路径取走时跳过
+        uint8_t *batch[1];
+        MEMPOOL_ASSERT(mempool_alloc_batch(pool, batch, 1, false) == 1 && batch[0] == base + 50 * bs);
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == base + 130 * bs);
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == NULL);
+        mempool_free(pool, base + 60 * bs);
+        mempool_free(pool, base + 61 * bs);
+        MEMPOOL_ASSERT(mempool_available(pool) == 2);
+
+        // 回到first-fit
+        MEMPOOL_ASSERT(mempool_set_placement(pool, MEMPOOL_PLACEMENT_FIRST_FIT) == 0);
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == base + 60 * bs);
+        mempool_destroy(pool);
+    }
+
+    // 无锁模式并发: 块不被重复分配, 结束后块数不变
+    static const uint32_t policies[] = { MEMPOOL_PLACEMENT_NEXT_FIT, MEMPOOL_PLACEMENT_LIFO };
+    for (size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); p++) {
+        mempool_t *pool = mempool_create_flags(TEST_BLOCK_SIZE, 64, MEMPOOL_FLAG_LOCKFREE);
+        MEMPOOL_ASSERT(pool != NULL && mempool_set_placement(pool, policies[p]) == 0);
+        pthread_t tids[4];
+        for (int i = 0; i < 4; i++) pthread_create(&tids[i], NULL, lockfree_stress_thread, pool);
+        for (int i = 0; i < 4; i++) pthread_join(tids[i], NULL);
+        MEMPOOL_ASSERT(mempool_available(pool) == 64);
+        mempool_destroy(pool);
+    }
+
+    DEBUG_PRINT("Placement policy test passed!");
+}
+
+// 空闲链表引擎测试
+void test_mempool_freelist() {
+    DEBUG_PRINT("=== Testing free-list engine ===");
+
+    MEMPOOL_ASSERT(mempool_create_flags(64, 100, MEMPOOL_FLAG_FREELIST | MEMPOOL_FLAG_REFCOUNT) == NULL);
+    MEMPOOL_ASSERT(mempool_create_elastic(64, 64, 1, 4, MEMPOOL_FLAG_FREELIST) == NULL);
+
+    static const uint32_t modes[] = { MEMPOOL_FLAG_FREELIST, MEMPOOL_FLAG_FREELIST | MEMPOOL_FLAG_LOCKFREE };
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        mempool_t *pool = mempool_create_flags(64, 100, modes[m]);
+        MEMPOOL_ASSERT(pool != NULL && pool->freelist_next != NULL);
+        uint8_t *base = pool->memory_area;
+        size_t bs = pool->block_size;
+        uint8_t *blocks[100];
+
+        // 初始按下标升序分配
+        for (int i = 0; i < 100; i++) {
+            blocks[i] = mempool_alloc(pool, i == 3);
+            MEMPOOL_ASSERT(blocks[i] == base + (size_t)i * bs);
+        }
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == NULL);
+        MEMPOOL_ASSERT(mempool_available(pool) == 0);
+        MEMPOOL_ASSERT(pool->hw_owned_bitmap[0] == ((BITMAP_TYPE)1 << 3));
+
+        // LIFO复用, 释放清除硬件标记
+        mempool_free(pool, blocks[10]);
+        mempool_free(pool, blocks[3]);
+        MEMPOOL_ASSERT(pool->hw_owned_bitmap[0] == 0);
+        MEMPOOL_ASSERT(mempool_available(pool) == 2);
+        MEMPOOL_ASSERT(mempool_alloc(pool, true) == blocks[3]);
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == blocks[10]);
+        MEMPOOL_ASSERT(pool->hw_owned_bitmap[0] == ((BITMAP_TYPE)1 << 3));
+
+        // 不支持的操作
+        MEMPOOL_ASSERT(mempool_alloc_contiguous(pool, 2, false) == NULL);
+        MEMPOOL_ASSERT(mempool_set_placement(pool, MEMPOOL_PLACEMENT_NEXT_FIT) == -1);
+
+        // 批量释放整条链, 批量分配按释放的逆序取回
+        mempool_free_batch(pool, &blocks[50], 50);
+        MEMPOOL_ASSERT(mempool_available(pool) == 50);
+        uint8_t *batch[60];
+        MEMPOOL_ASSERT(mempool_alloc_batch(pool, batch, 60, false) == 50);
+        MEMPOOL_ASSERT(batch[0] == blocks[50] && batch[49] == blocks[99]);
+        mempool_free_batch(pool, batch, 50);
+
+#if MEMPOOL_FREELIST_CHECK
+        // 重复释放被检测并忽略
+        mempool_free(pool, blocks[0]);
+        mempool_free(pool, blocks[0]);
+        uint8_t *twice[2] = { blocks[1], blocks[1] };
+        mempool_free_batch(pool, twice, 2);
+        MEMPOOL_ASSERT(mempool_available(pool) == 52);
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == blocks[1]);
+        MEMPOOL_ASSERT(mempool_alloc(pool, false) == blocks[0]);
+#endif
+
+        // 线程缓存照常工作
+        MEMPOOL_ASSERT(mempool_magazine_enable(pool, 8) == 0);
+        for (int i = 0; i < 1000; i++) {
+            uint8_t *p = mempool_alloc(pool, false);
+            MEMPOOL_ASSERT(p != NULL);
+            mempool_free(pool, p);
+        }
+        mempool_magazine_flush(pool);
+        MEMPOOL_ASSERT(mempool_available(pool) == 50);
+
+        for (int i = 0; i < 50; i++) {
+            mempool_free(pool, blocks[i]);
+        }
+        MEMPOOL_ASSERT(mempool_available(pool) == 100);
+        mempool_destroy(pool);
+    }
+
+    // 无锁模式并发: 带标签的链表头防止ABA, 块不被重复分配
+    mempool_t *pool = mempool_create_flags(TEST_BLOCK_SIZE, 64, MEMPOOL_FLAG_FREELIST | MEMPOOL_FLAG_LOCKFREE);
+    MEMPOOL_ASSERT(pool != NULL);
+    pthread_t tids[4];
+    for (int i = 0; i < 4; i++) pthread_create(&tids[i], NULL, lockfree_stress_thread, pool);
+    for (int i = 0; i < 4; i++) pthread_join(tids[i], NULL);
+    MEMPOOL_ASSERT(mempool_available(pool) == 64);
+    mempool_destroy(pool);
+
+    DEBUG_PRINT("Free-list engine test passed!");
+}
+
+// 多优先级队列集合测试
+void test_mempool_prio() {
+    DEBUG_PRINT("=== Testing priority queue set ===");
+
+    mempool_t *pool = mempool_create(TEST_BLOCK_SIZE, 64);
+    MEMPOOL_ASSERT(pool != NULL);
+    // 三个类别分别使用三种队列模式
+    mempool_queue_t *ctrl = mempool_queue_create_mode(pool, 32, MEMPOOL_QUEUE_LOCKED);
+    mempool_queue_t *mid = mempool_queue_create_mode(pool, 32, MEMPOOL_QUEUE_SPSC);
+    mempool_queue_t *bulk = mempool_queue_create_mode(pool, 32, MEMPOOL_QUEUE_MPMC);
+    MEMPOOL_ASSERT(ctrl && mid && bulk);
+
+    uint8_t *blocks[64];
+    MEMPOOL_ASSERT(mempool_alloc_batch(pool, blocks, 64, false) == 64);
+    uint8_t *out[64];
+    size_t lens[64];
+    size_t len, cls;
+
+    // 严格优先级: 拥塞时控制帧越过已排队的批量数据
+    mempool_prio_t prio;
+    mempool_prio_init(&prio, MEMPOOL_PRIO_STRICT);
+    MEMPOOL_ASSERT(mempool_prio_add(&prio, ctrl, 0) == 0);
+    MEMPOOL_ASSERT(mempool_prio_add(&prio, mid, 0) == 1);
+    MEMPOOL_ASSERT(mempool_prio_add(&prio, bulk, 0) == 2);
+    MEMPOOL_ASSERT(mempool_prio_add(&prio, bulk, 0) == -1);
+    MEMPOOL_ASSERT(mempool_prio_dequeue(&prio, &len, &cls) == NULL);
+
+    for (int i = 0; i < 5; i++) MEMPOOL_ASSERT(mempool_queue_enqueue_with_length(bulk, blocks[i], 1000 + i) == 0);
+    MEMPOOL_ASSERT(mempool_queue_enqueue_with_length(mid, blocks[5], 500) == 0);
+    MEMPOOL_ASSERT(mempool_queue_enqueue_with_length(ctrl, blocks[6], 64) == 0);
+    MEMPOOL_ASSERT(mempool_queue_enqueue_with_length(ctrl, blocks[7], 65) == 0);
+    MEMPOOL_ASSERT(mempool_prio_count(&prio) == 8);
+    MEMPOOL_ASSERT(mempool_prio_dequeue(&prio, &len, &cls) == blocks[6] && len == 64 && cls == 0);
+    // 突发跨类别填充: 剩余控制帧 -> 中间类别 -> 批量数据
+    MEMPOOL_ASSERT(mempool_prio_dequeue_batch(&prio, out, lens, 4) == 4);
+    MEMPOOL_ASSERT(out[0] == blocks[7] && out[1] == blocks[5] && out[2] == blocks[0] && out[3] == blocks[1]);
+    MEMPOOL_ASSERT(lens[0] == 65 && lens[1] == 500 && lens[3] == 1001);
+    MEMPOOL_ASSERT(mempool_prio_dequeue_batch(&prio, out, NULL, 64) == 3 && out[2] == blocks[4]);
+    mempool_prio_clear(&prio);
+    MEMPOOL_ASSERT(ctrl->next == NULL && mid->next == NULL && mempool_prio_count(&prio) == 0);
+
+    // 加权轮询: 权重3:1
+    mempool_prio_init(&prio, MEMPOOL_PRIO_WRR);
+    MEMPOOL_ASSERT(mempool_prio_add(&prio, ctrl, 0) == -1);
+    MEMPOOL_ASSERT(mempool_prio_add(&prio, ctrl, 3) == 0);
+    MEMPOOL_ASSERT(mempool_prio_add(&prio, bulk, 1) == 1);
+    for (int i = 0; i < 8; i++) {
+        MEMPOOL_ASSERT(mempool_queue_enqueue_with_length(ctrl, blocks[i], 0) == 0);
+        MEMPOOL_ASSERT(mempool_queue_enqueue_with_length(bulk, blocks[8 + i], 0) == 0);
+    }
+    static const int wrr_order[] = { 0, 0, 0, 1, 0, 0, 0, 1 };
+    for (int i = 0; i < 8; i++) {
+        MEMPOOL_ASSERT(mempool_prio_dequeue(&prio, NULL, &cls) != NULL && cls == (size_t)wrr_order[i]);
+    }
+    // 批量出队沿用轮询位置; 一个类别为空时其余类别获得全部份额
+    MEMPOOL_ASSERT(mempool_prio_dequeue_batch(&prio, out, NULL, 64) == 8);
+    MEMPOOL_ASSERT(out[0] == blocks[6] && out[1] == blocks[7] && out[2] == blocks[10] && out[7] == blocks[15]);
+    mempool_prio_clear(&prio);
+
+    // 差额轮询: 额度相同, 按字节公平分配(100字节的小帧每轮3个, 300字节的大帧每轮1个)
+    mempool_prio_init(&prio, MEMPOOL_PRIO_DRR);
+    MEMPOOL_ASSERT(mempool_prio_add(&prio, mid, 300) == 0);
+    MEMPOOL_ASSERT(mempool_prio_add(&prio, bulk, 300) == 1);
+    for (int i = 0; i < 12; i++) MEMPOOL_ASSERT(mempool_queue_enqueue_with_length(mid, blocks[i], 100) == 0);
+    for (int i = 0; i < 4; i++) MEMPOOL_ASSERT(mempool_queue_enqueue_with_length(bulk, blocks[12 + i], 300) == 0);
+    MEMPOOL_ASSERT(mempool_prio_dequeue_batch(&prio, out, lens, 8) == 8);
+    size_t bytes[2] = { 0, 0 };
+    for (int i = 0; i < 8; i++) bytes[lens[i] == 300] += lens[i];
+    MEMPOOL_ASSERT(bytes[0] == 600 && bytes[1] == 600);
+    MEMPOOL_ASSERT(lens[0] == 100 && lens[2] == 100 && lens[3] == 300 && lens[4] == 100);
+    // 超过额度的帧在额度累积足够后发送
+    MEMPOOL_ASSERT(mempool_prio_dequeue_batch(&prio, out, NULL, 64) == 8);
+    MEMPOOL_ASSERT(mempool_queue_enqueue_with_length(bulk, blocks[20], 700) == 0);
+    MEMPOOL_ASSERT(mempool_queue_enqueue_with_length(mid, blocks[21], 100) == 0);
+    MEMPOOL_ASSERT(mempool_prio_dequeue(&prio, &len, &cls) != NULL);
+    MEMPOOL_ASSERT(mempool_prio_dequeue(&prio, &len, &cls) != NULL);
+    MEMPOOL_ASSERT(mempool_prio_dequeue(&prio, &len, &cls) == NULL);
+    mempool_prio_clear(&prio);
+
+    mempool_free_batch(pool, blocks, 64);
+    mempool_queue_destroy(ctrl);
+    mempool_queue_destroy(mid);
+    mempool_queue_destroy(bulk);
+    mempool_destroy(pool);
+
+    DEBUG_PRINT("Priority queue set test passed!");
+}
+
+// 就绪通知消费者线程: 在epoll上等待eventfd, 每次就绪后取空队列再确认
+struct queue_event_ctx {
+    mempool_queue_t *queue;
+    int epfd;
+    size_t expected;
+    size_t received;
+    size_t wakeups;
+};
+
+static void *queue_event_consumer(void *arg)
+{
+    struct queue_event_ctx *ctx = (struct queue_event_ctx *)arg;
+    struct epoll_event ev;
+
+    while (ctx->received < ctx->expected) {
+        if (epoll_wait(ctx->epfd, &ev, 1, 5000) != 1) break;
+        ctx->wakeups++;
+        uint8_t *block;
+        while ((block = mempool_queue_dequeue(ctx->queue)) != NULL) {
+            ctx->received++;
+        }
+        mempool_queue_event_ack(ctx->queue);
+    }
+    return NULL;
+}
+
+// 队列就绪通知(eventfd)测试
+void test_mempool_queue_event() {
+    DEBUG_PRINT("=== Testing queue readiness eventfd ===");
+
+    mempool_t *pool = mempool_create(TEST_BLOCK_SIZE, 64);
+    MEMPOOL_ASSERT(pool != NULL);
+    uint8_t *blocks[64];
+    MEMPOOL_ASSERT(mempool_alloc_batch(pool, blocks, 64, false) == 64);
+    struct epoll_event ev;
+    uint64_t value;
+
+    for (uint32_t mode = MEMPOOL_QUEUE_LOCKED; mode <= MEMPOOL_QUEUE_MPMC; mode++) {
+        mempool_queue_t *queue = mempool_queue_create_mode(pool, 32, mode);
+        MEMPOOL_ASSERT(queue != NULL && queue->event_fd < 0);
+        MEMPOOL_ASSERT(mempool_queue_event_ack(queue) == 0);
+
+        int fd = mempool_queue_event_enable(queue, 0);
+        MEMPOOL_ASSERT(fd >= 0 && mempool_queue_event_enable(queue, 0) == fd);
+        int epfd = epoll_create1(0);
+        ev.events = EPOLLIN;
+        ev.data.ptr = queue;
+        MEMPOOL_ASSERT(epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == 0);
+        MEMPOOL_ASSERT(epoll_wait(epfd, &ev, 1, 0) == 0);
+
+        // 由空变为非空时可读, 一次突发只写一次eventfd
+        for (int i = 0; i < 8; i++) MEMPOOL_ASSERT(mempool_queue_enqueue(queue, blocks[i]) == 0);
+        MEMPOOL_ASSERT(epoll_wait(epfd, &ev, 1, 0) == 1 && ev.data.ptr == queue);
+        MEMPOOL_ASSERT(read(fd, &value, sizeof(value)) == sizeof(value) && value == 1);
+        MEMPOOL_ASSERT(epoll_wait(epfd, &ev, 1, 0) == 0);
+
+        // 未取空就确认: 深度仍达到水位, 立即再次可读
+        for (int i = 0; i < 5; i++) MEMPOOL_ASSERT(mempool_queue_dequeue(queue) == blocks[i]);
+        MEMPOOL_ASSERT(mempool_queue_event_ack(queue) == 3);
+        MEMPOOL_ASSERT(epoll_wait(epfd, &ev, 1, 0) == 1);
+        MEMPOOL_ASSERT(mempool_queue_dequeue_batch(queue, blocks + 5, 3) == 3);
+        MEMPOOL_ASSERT(mempool_queue_event_ack(queue) == 0);
+        MEMPOOL_ASSERT(epoll_wait(epfd, &ev, 1, 0) == 0);
+
+        // 水位: 深度达到4时才通知
+        MEMPOOL_ASSERT(mempool_queue_event_enable(queue, 4) == fd);
+        for (int i = 0; i < 3; i++) MEMPOOL_ASSERT(mempool_queue_enqueue(queue, blocks[i]) == 0);
+        MEMPOOL_ASSERT(epoll_wait(epfd, &ev, 1, 0) == 0);
+        MEMPOOL_ASSERT(mempool_queue_enqueue(queue, blocks[3]) == 0);
+        MEMPOOL_ASSERT(epoll_wait(epfd, &ev, 1, 0) == 1);
+        MEMPOOL_ASSERT(mempool_queue_dequeue_batch(queue, blocks, 4) == 4);
+        MEMPOOL_ASSERT(mempool_queue_event_ack(queue) == 0);
+        MEMPOOL_ASSERT(mempool_queue_event_enable(queue, 1000) == fd && queue->event_watermark == 32);
+
+        // 跨线程: 消费者阻塞在epoll_wait, 收到全部块且唤醒次数不超过入队次数
+        MEMPOOL_ASSERT(mempool_queue_event_enable(queue, 1) == fd);
+        struct queue_event_ctx ctx = { queue, epfd, 2000, 0, 0 };
+        pthread_t tid;
+        pthread_create(&tid, NULL, queue_event_consumer, &ctx);
+        for (size_t i = 0; i < ctx.expected; i++) {
+            while (mempool_queue_enqueue(queue, blocks[i % 32]) != 0) {
+                sched_yield();
+            }
+        }
+        pthread_join(tid, NULL);
+        MEMPOOL_ASSERT(ctx.received == ctx.expected && ctx.wakeups <= ctx.expected);
+        DEBUG_PRINT("mode %u: %zu blocks, %zu wakeups", mode, ctx.received, ctx.wakeups);
+
+        close(epfd);
+        mempool_queue_destroy(queue);
+    }
+
+    mempool_free_batch(pool, blocks, 64);
+    mempool_destroy(pool);
+
+    DEBUG_PRINT("Queue readiness eventfd test passed!");
+}
+
+// 无锁模式压力测试线程: 每个块写入线程标识, 释放前校验未被其他线程同时持有
+static void *lockfree_stress_thread(void *arg) {
+    mempool_t *pool = (mempool_t *)arg;
+    uint8_t tag = (uint8_t)(uintptr_t)pthread_self();
+    uint8_t *held[8];
+
+    for (int iter = 0; iter < 20000; iter++) {
+        int n = 0;
+        for (int i = 0; i < 8; i++) {
+            if ((held[n] = mempool_alloc(pool, i & 1)) != NULL) {
+                memset(held[n], tag, TEST_BLOCK_SIZE);
+                n++;
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            for (size_t j = 0; j < TEST_BLOCK_SIZE; j++) {
+                MEMPOOL_ASSERT(held[i][j] == tag && "Block shared between threads");
+            }
+            mempool_free(pool, held[i]);
+        }
+    }
+    return NULL;
+}
+
+// 无锁分配模式测试
+void test_mempool_lockfree() {
+    DEBUG_PRINT("=== Testing lock-free mempool mode ===");
+
+    size_t test_blocks = get_test_block_count();
+    mempool_t *pool = mempool_create_flags(TEST_BLOCK_SIZE, test_blocks, MEMPOOL_FLAG_LOCKFREE);
+    MEMPOOL_ASSERT(pool != NULL);
+
+    // 单线程语义与加锁模式一致
+    uint8_t *blocks[test_blocks];
+    for (size_t i = 0; i < test_blocks; i++) {
+        blocks[i] = mempool_alloc(pool, i % 2);
+        MEMPOOL_ASSERT(blocks[i] != NULL);
+        MEMPOOL_ASSERT(mempool_available(pool) == test_blocks - i - 1);
+    }
+    MEMPOOL_ASSERT(mempool_alloc(pool, false) == NULL);
+    for (size_t i = 0; i < pool->bitmap_words; i++) {
+        MEMPOOL_ASSERT(pool->hw_owned_bitmap[i] != 0 || i * MEMPOOL_BITMAP_EACH_NUM >= test_blocks);
+    }
+
+    for (size_t i = 0; i < test_blocks; i++) {
+        mempool_free(pool, blocks[i]);
+        mempool_free(pool, blocks[i]); // 重复释放应被忽略
+        MEMPOOL_ASSERT(mempool_available(pool) == i + 1);
+    }
+    for (size_t i = 0; i < pool->bitmap_words; i++) {
+        MEMPOOL_ASSERT(pool->hw_owned_bitmap[i] == 0);
+    }
+
+    // 多线程并发分配释放
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++) {
+        pthread_create(&threads[i], NULL, lockfree_stress_thread, pool);
+    }
+    for (int i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    MEMPOOL_ASSERT(mempool_available(pool) == test_blocks);
+
+    mempool_destroy(pool);
+    DEBUG_PRINT("Lock-free mempool test passed!");
+}
+
+// 线程缓存测试线程: 退出时缓存应自动归还
+static void *magazine_thread(void *arg) {
+    mempool_t *pool = (mempool_t *)arg;
+    uint8_t *held[16];
+
+    for (int iter = 0; iter < 1000; iter++) {
+        for (int i = 0; i < 16; i++) {
+            held[i] = mempool_alloc(pool, false);
+            MEMPOOL_ASSERT(held[i] != NULL);
+        }
+        for (int i = 0; i < 16; i++) {
+            mempool_free(pool, held[i]);
+        }
+    }
+    return NULL;
+}
+
+// 每线程块缓存测试
+void test_mempool_magazine() {
+    DEBUG_PRINT("=== Testing per-thread magazine ===");
+
+    size_t test_blocks = get_test_block_count();
+    mempool_t *pool = mempool_create(TEST_BLOCK_SIZE, test_blocks);
+    MEMPOOL_ASSERT(pool != NULL);
+    MEMPOOL_ASSERT(mempool_magazine_enable(pool, 8) == 0);
+    MEMPOOL_ASSERT(mempool_magazine_enable(pool, 8) == -1);
+
+    // 缓存中的块仍计为可用
+    uint8_t *blocks[test_blocks];
+    for (size_t i = 0; i < test_blocks; i++) {
+        blocks[i] = mempool_alloc(pool, i % 4 == 0);
+        MEMPOOL_ASSERT(blocks[i] != NULL);
+        MEMPOOL_ASSERT(mempool_available(pool) == test_blocks - i - 1);
+    }
+    MEMPOOL_ASSERT(mempool_alloc(pool, false) == NULL);
+
+    for (size_t i = 0; i < test_blocks; i++) {
+        mempool_free(pool, blocks[i]);
+        MEMPOOL_ASSERT(mempool_available(pool) == i + 1);
+    }
+
+    // 刷新后全部回到位图, 可被硬件分配取走
+    mempool_magazine_flush(pool);
+    for (size_t i = 0; i < test_blocks; i++) {
+        blocks[i] = mempool_alloc(pool, true);
+        MEMPOOL_ASSERT(blocks[i] != NULL);
+    }
+    for (size_t i = 0; i < test_blocks; i++) {
+        mempool_free(pool, blocks[i]);
+    }
+
+    // 线程退出时缓存归还
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++) {
+        pthread_create(&threads[i], NULL, magazine_thread, pool);
+    }
+    for (int i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    mempool_magazine_flush(pool);
+    MEMPOOL_ASSERT(mempool_available(pool) == test_blocks);
+    mempool_destroy(pool);
+
+    // 重复释放缓存中的块被拒绝, 之后的分配不会两次返回同一块
+    pool = mempool_create(TEST_BLOCK_SIZE, test_blocks);
+    MEMPOOL_ASSERT(pool != NULL && mempool_magazine_enable(pool, 8) == 0);
+    uint8_t *dup = mempool_alloc(pool, false);
+    MEMPOOL_ASSERT(dup != NULL);
+    mempool_free(pool, dup);
+    mempool_free(pool, dup);
+    mempool_free_batch(pool, &dup, 1);
+    MEMPOOL_ASSERT(mempool_available(pool) == test_blocks);
+    uint8_t *first = mempool_alloc(pool, false);
+    uint8_t *second = mempool_alloc(pool, false);
+    MEMPOOL_ASSERT(first && second && first != second);
+    mempool_free(pool, first);
+    mempool_free(pool, second);
+    // 从缓存刷新回位图后再次释放同样被忽略
+    mempool_magazine_flush(pool);
+    mempool_free(pool, first);
+    MEMPOOL_ASSERT(mempool_available(pool) == test_blocks);
+    MEMPOOL_ASSERT(mempool_alloc_batch(pool, blocks, test_blocks, false) == test_blocks);
+    mempool_free_batch(pool, blocks, test_blocks);
+    MEMPOOL_ASSERT(mempool_available(pool) == test_blocks);
+    mempool_destroy(pool);
+
+    // 有阻塞分配的等待者时, 其他线程释放的块不进入线程缓存, 直接唤醒等待者
+    pool = mempool_create_flags(64, 4, 0);
+    MEMPOOL_ASSERT(pool != NULL && mempool_magazine_enable(pool, 2) == 0);
+    MEMPOOL_ASSERT(mempool_alloc_batch(pool, blocks, 4, false) == 4);
+    pthread_t tid;
+    timed_test_arg_t arg = { pool, NULL, blocks[1] };
+    pthread_create(&tid, NULL, timed_release_thread, &arg);
+    MEMPOOL_ASSERT(mempool_alloc_timed(pool, false, 5000000000ull) == blocks[1]);
+    pthread_join(tid, NULL);
+    mempool_free_batch(pool, blocks, 4);
+    mempool_destroy(pool);
+
+    DEBUG_PRINT("Magazine test passed!");
+}
+
 #include "mempool_port.h"
 // 互斥锁测试线程参数结构
 typedef struct {
@@ -432,6 +2433,29 @@ int main() {
     test_mempool_edge_cases();
     test_mempool_memory_content();
     test_mempool_all_blocks_isolation();
+    test_mempool_lockfree();
+    test_mempool_magazine();
+    test_mempool_large_pool();
+    test_mempool_batch();
+    test_mempool_queue_spsc();
+    test_mempool_queue_mpmc();
+    test_mempool_sizeclass();
+    test_mempool_elastic();
+    test_mempool_area_backend();
+    test_mempool_numa();
+    test_mempool_shared();
+    test_mempool_timed();
+    test_mempool_refcount();
+    test_mempool_chain();
+    test_mempool_pkt();
+    test_mempool_stats();
+    test_mempool_hist();
+    test_mempool_static();
+    test_mempool_bitmap();
+    test_mempool_placement();
+    test_mempool_freelist();
+    test_mempool_prio();
+    test_mempool_queue_event();
 
     DEBUG_PRINT("All memory pool tests passed successfully!");
     return 0;